@@ -0,0 +1,81 @@
+#include <JuceHeader.h>
+#include "BenchmarkResults.h"
+#include <algorithm>
+
+//==============================================================================
+BenchmarkResults::BenchmarkResults()
+{
+}
+
+BenchmarkResults::~BenchmarkResults()
+{
+}
+
+void BenchmarkResults::add(const juce::String& suite, const juce::String& name,
+                           const juce::String& metric, double value, const juce::String& unit)
+{
+    results.push_back({ suite, name, metric, value, unit });
+}
+
+void BenchmarkResults::addBlockTimes(const juce::String& suite, const juce::String& name,
+                                     std::vector<double> secondsPerBlock, double blockDurationSeconds)
+{
+    if (secondsPerBlock.empty())
+    {
+        return;
+    }
+    std::sort(secondsPerBlock.begin(), secondsPerBlock.end());
+
+    double total = 0;
+    for (auto seconds : secondsPerBlock)
+    {
+        total += seconds;
+    }
+    auto mean = total / (double) secondsPerBlock.size();
+    auto percentile = [&secondsPerBlock](double fraction)
+    {
+        auto index = (size_t) std::floor(fraction * (double) (secondsPerBlock.size() - 1));
+        return secondsPerBlock[index];
+    };
+
+    add(suite, name, "mean", mean * 1.0e6, "us");
+    add(suite, name, "median", percentile(0.5) * 1.0e6, "us");
+    add(suite, name, "p99", percentile(0.99) * 1.0e6, "us");
+    add(suite, name, "max", secondsPerBlock.back() * 1.0e6, "us");
+    add(suite, name, "load", 100.0 * mean / blockDurationSeconds, "%");
+}
+
+juce::String BenchmarkResults::toJSON() const
+{
+    juce::Array<juce::var> rows;
+    for (auto& result : results)
+    {
+        auto* row = new juce::DynamicObject();
+        row->setProperty("suite", result.suite);
+        row->setProperty("name", result.name);
+        row->setProperty("metric", result.metric);
+        row->setProperty("value", result.value);
+        row->setProperty("unit", result.unit);
+        rows.add(juce::var(row));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("version", ProjectInfo::versionString);
+    root->setProperty("time", juce::Time::getCurrentTime().toISO8601(true));
+    root->setProperty("cpu", juce::SystemStats::getCpuModel());
+    root->setProperty("cores", juce::SystemStats::getNumCpus());
+    root->setProperty("os", juce::SystemStats::getOperatingSystemName());
+    root->setProperty("results", rows);
+    return juce::JSON::toString(juce::var(root));
+}
+
+juce::String BenchmarkResults::toCSV() const
+{
+    juce::String csv = "suite,name,metric,value,unit\n";
+    for (auto& result : results)
+    {
+        csv << result.suite << "," << result.name.quoted() << "," << result.metric << ","
+            << juce::String(result.value, 3) << "," << result.unit << "\n";
+    }
+    return csv;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+//==============================================================================
+/*
+    Collects benchmark measurements and writes them out as JSON or CSV, so
+    runs from different releases can be compared by a script.
+*/
+class BenchmarkResults
+{
+public:
+    struct Result
+    {
+        juce::String suite;
+        juce::String name;
+        juce::String metric;
+        double value;
+        juce::String unit;
+    };
+
+    BenchmarkResults();
+    ~BenchmarkResults();
+
+    void add(const juce::String& suite, const juce::String& name,
+             const juce::String& metric, double value, const juce::String& unit);
+    /**Adds mean, median, p99 and max of per-block times, plus the mean as a share of the block's duration*/
+    void addBlockTimes(const juce::String& suite, const juce::String& name,
+                       std::vector<double> secondsPerBlock, double blockDurationSeconds);
+
+    /**Everything as one JSON object, with the app version and CPU so runs can be told apart*/
+    juce::String toJSON() const;
+    /**One row per result under a suite,name,metric,value,unit header*/
+    juce::String toCSV() const;
+
+private:
+    std::vector<Result> results;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BenchmarkResults)
+};
+
+//==============================================================================
+/**Seconds since start, for timing a piece of code*/
+inline double secondsSince(juce::int64 startTicks)
+{
+    return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+}
@@ -0,0 +1,526 @@
+#include <JuceHeader.h>
+#include "DeckBenchmarks.h"
+#include "DJAudioPlayer.h"
+#include "DeckMixer.h"
+#include "DeckResampler.h"
+#include "OfflineRenderer.h"
+#include "ReadAheadPool.h"
+#include "SyncEngine.h"
+#include "TimeStretcher.h"
+#include "VectorReverb.h"
+#include <thread>
+
+namespace
+{
+    constexpr double deviceSampleRate = 48000.0;
+
+    /**Endless stereo noise, so the stages under test never see silence*/
+    class NoiseSource  : public juce::AudioSource
+    {
+    public:
+        void prepareToPlay(int, double) override {}
+        void releaseResources() override {}
+
+        void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override
+        {
+            for (int channel = 0; channel < bufferToFill.buffer->getNumChannels(); ++channel)
+            {
+                auto* samples = bufferToFill.buffer->getWritePointer(channel, bufferToFill.startSample);
+                for (int i = 0; i < bufferToFill.numSamples; ++i)
+                {
+                    samples[i] = random.nextFloat() * 0.5f - 0.25f;
+                }
+            }
+        }
+
+    private:
+        juce::Random random{ 1 };
+    };
+
+    /**Times each call of render over enough blocks to cover secondsOfAudio, after a short warm-up*/
+    template <typename RenderFunction>
+    std::vector<double> timeBlocks(int blockSize, double secondsOfAudio, RenderFunction&& render)
+    {
+        auto numBlocks = juce::jmax(100, (int) (secondsOfAudio * deviceSampleRate / blockSize));
+        for (int i = 0; i < 20; ++i)
+        {
+            render();
+        }
+
+        std::vector<double> times;
+        times.reserve((size_t) numBlocks);
+        for (int i = 0; i < numBlocks; ++i)
+        {
+            auto start = juce::Time::getHighResolutionTicks();
+            render();
+            times.push_back(secondsSince(start));
+        }
+        return times;
+    }
+
+    /**Writes a stereo click on every beat, starting on the first sample, and silence in between*/
+    bool createClickTrack(const juce::File& file, double bpm, double lengthSeconds, double sampleRate)
+    {
+        auto numSamples = (int) (lengthSeconds * sampleRate);
+        auto beatSamples = 60.0 * sampleRate / bpm;
+        auto clickSamples = (int) (0.03 * sampleRate);
+        juce::AudioBuffer<float> audio(2, numSamples);
+        audio.clear();
+        for (double beat = 0; beat < numSamples; beat += beatSamples)
+        {
+            auto start = (int) std::round(beat);
+            for (int i = 0; i < clickSamples && start + i < numSamples; ++i)
+            {
+                // a decaying 2kHz burst, long enough that stretching can't skip all of it
+                auto value = (float) (0.8 * std::exp(-i / (0.008 * sampleRate))
+                                      * std::sin(2.0 * juce::MathConstants<double>::pi * 2000.0 * i / sampleRate));
+                audio.setSample(0, start + i, value);
+                audio.setSample(1, start + i, value);
+            }
+        }
+
+        file.deleteFile();
+        auto stream = std::make_unique<juce::FileOutputStream>(file);
+        if (!stream->openedOk())
+        {
+            return false;
+        }
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), sampleRate, 2, 16, {}, 0));
+        if (writer == nullptr)
+        {
+            return false;
+        }
+        stream.release();
+        return writer->writeFromAudioSampleBuffer(audio, 0, numSamples);
+    }
+
+    /**Finds where clicks start in a stream of blocks: the first loud sample after a quiet stretch*/
+    class ClickFinder
+    {
+    public:
+        void process(const float* samples, int numSamples, juce::int64 startSample)
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                if (std::abs(samples[i]) > 0.2f)
+                {
+                    if (startSample + i - lastLoud > quietSamples)
+                    {
+                        clicks.push_back(startSample + i);
+                    }
+                    lastLoud = startSample + i;
+                }
+            }
+        }
+
+        std::vector<juce::int64> clicks;
+
+    private:
+        static constexpr juce::int64 quietSamples = (juce::int64) (0.1 * deviceSampleRate);
+        juce::int64 lastLoud{ -quietSamples - 1 };
+    };
+
+    /**Keeps every core spinning while it exists, like another program hogging the machine*/
+    class CpuHog
+    {
+    public:
+        CpuHog()
+        {
+            for (int i = 0; i < juce::SystemStats::getNumCpus(); ++i)
+            {
+                threads.emplace_back([this]
+                {
+                    volatile double sink = 0;
+                    while (running.load())
+                    {
+                        sink = sink + 1.0;
+                    }
+                });
+            }
+        }
+
+        ~CpuHog()
+        {
+            running.store(false);
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+        }
+
+    private:
+        std::atomic<bool> running{ true };
+        std::vector<std::thread> threads;
+    };
+
+    std::unique_ptr<DJAudioPlayer> createPlayer(juce::AudioFormatManager& formatManager,
+                                                ReadAheadPool& readAheadPool,
+                                                const juce::File& testFile)
+    {
+        auto player = std::make_unique<DJAudioPlayer>(formatManager, readAheadPool);
+        // straight from the decoder, so disk timing never shows up in the numbers
+        player->setRealtime(false);
+        player->loadURL(juce::URL(testFile));
+        player->setLooping(true);
+        player->play();
+        return player;
+    }
+}
+
+//==============================================================================
+bool DeckBenchmarks::createTestFile(const juce::File& file, double lengthSeconds, double sampleRate)
+{
+    auto numSamples = (int) (lengthSeconds * sampleRate);
+    juce::AudioBuffer<float> audio(2, numSamples);
+    juce::Random random{ 2 };
+    const double frequencies[] = { 220.0, 277.18, 329.63, 440.0 };
+    for (int i = 0; i < numSamples; ++i)
+    {
+        double value = 0;
+        for (auto frequency : frequencies)
+        {
+            value += 0.15 * std::sin(2.0 * juce::MathConstants<double>::pi * frequency * i / sampleRate);
+        }
+        audio.setSample(0, i, (float) value + random.nextFloat() * 0.02f - 0.01f);
+        audio.setSample(1, i, (float) -value + random.nextFloat() * 0.02f - 0.01f);
+    }
+
+    file.deleteFile();
+    auto stream = std::make_unique<juce::FileOutputStream>(file);
+    if (!stream->openedOk())
+    {
+        return false;
+    }
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), sampleRate, 2, 16, {}, 0));
+    if (writer == nullptr)
+    {
+        return false;
+    }
+    stream.release();
+    return writer->writeFromAudioSampleBuffer(audio, 0, numSamples);
+}
+
+void DeckBenchmarks::runDspBenchmarks(BenchmarkResults& results, bool quick)
+{
+    auto seconds = quick ? 2.0 : 10.0;
+    const int blockSize = 256;
+    auto blockDuration = blockSize / deviceSampleRate;
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    juce::AudioSourceChannelInfo info(&buffer, 0, blockSize);
+
+    // 44.1k tracks on a 48k device, at normal speed and sped up
+    const std::pair<const char*, DeckResampler::Quality> qualities[] = {
+        { "linear", DeckResampler::Quality::linear },
+        { "cubic", DeckResampler::Quality::cubic },
+        { "sinc", DeckResampler::Quality::sinc }
+    };
+    for (auto& quality : qualities)
+    {
+        for (auto ratio : { 44100.0 / 48000.0, 1.25 * 44100.0 / 48000.0 })
+        {
+            NoiseSource noise;
+            DeckResampler resampler(&noise);
+            resampler.prepareToPlay(blockSize, deviceSampleRate);
+            resampler.setQuality(quality.second);
+            resampler.setResamplingRatio(ratio);
+            auto times = timeBlocks(blockSize, seconds, [&] { resampler.getNextAudioBlock(info); });
+            results.addBlockTimes("dsp", "resampler " + juce::String(quality.first) + " ratio " + juce::String(ratio, 3),
+                                  times, blockDuration);
+        }
+    }
+
+    for (auto factor : { 1.0, 0.8, 1.25, 2.0 })
+    {
+        NoiseSource noise;
+        TimeStretcher stretcher(&noise);
+        stretcher.prepareToPlay(blockSize, deviceSampleRate);
+        stretcher.setStretchFactor(factor);
+        auto times = timeBlocks(blockSize, seconds, [&] { stretcher.getNextAudioBlock(info); });
+        results.addBlockTimes("dsp", "stretcher factor " + juce::String(factor, 2), times, blockDuration);
+    }
+
+    // blocks smaller than a hop, where the worst block should still follow the block size
+    for (auto stretchBlockSize : { 32, 128 })
+    {
+        juce::AudioBuffer<float> stretchBuffer(2, stretchBlockSize);
+        juce::AudioSourceChannelInfo stretchInfo(&stretchBuffer, 0, stretchBlockSize);
+        NoiseSource noise;
+        TimeStretcher stretcher(&noise);
+        stretcher.prepareToPlay(stretchBlockSize, deviceSampleRate);
+        stretcher.setStretchFactor(1.25);
+        auto times = timeBlocks(stretchBlockSize, seconds, [&] { stretcher.getNextAudioBlock(stretchInfo); });
+        results.addBlockTimes("dsp", "stretcher factor 1.25 block " + juce::String(stretchBlockSize), times,
+                              stretchBlockSize / deviceSampleRate);
+    }
+
+    // the vectorized reverb against the juce::Reverb it replaced, both on noise so neither suspends
+    for (auto reverbBlockSize : { 128, 512 })
+    {
+        juce::AudioBuffer<float> reverbBuffer(2, reverbBlockSize);
+        juce::AudioSourceChannelInfo reverbInfo(&reverbBuffer, 0, reverbBlockSize);
+        juce::Reverb::Parameters parameters;
+        parameters.wetLevel = 0.5f;
+        NoiseSource noise;
+
+        juce::Reverb scalarReverb;
+        scalarReverb.setSampleRate(deviceSampleRate);
+        scalarReverb.setParameters(parameters);
+        auto scalarTimes = timeBlocks(reverbBlockSize, seconds, [&]
+        {
+            noise.getNextAudioBlock(reverbInfo);
+            scalarReverb.processStereo(reverbBuffer.getWritePointer(0), reverbBuffer.getWritePointer(1), reverbBlockSize);
+        });
+        results.addBlockTimes("dsp", "juce reverb block " + juce::String(reverbBlockSize), scalarTimes,
+                              reverbBlockSize / deviceSampleRate);
+
+        VectorReverb vectorReverb;
+        vectorReverb.setSampleRate(deviceSampleRate);
+        vectorReverb.setParameters(parameters);
+        auto vectorTimes = timeBlocks(reverbBlockSize, seconds, [&]
+        {
+            noise.getNextAudioBlock(reverbInfo);
+            vectorReverb.processStereo(reverbBuffer.getWritePointer(0), reverbBuffer.getWritePointer(1), reverbBlockSize);
+        });
+        results.addBlockTimes("dsp", "vector reverb block " + juce::String(reverbBlockSize), vectorTimes,
+                              reverbBlockSize / deviceSampleRate);
+    }
+}
+
+void DeckBenchmarks::runPlayerBenchmarks(BenchmarkResults& results, juce::AudioFormatManager& formatManager,
+                                         const juce::File& testFile, bool quick)
+{
+    struct Setting
+    {
+        const char* name;
+        double speed;
+        bool keyLock;
+        double pitch;
+    };
+    const Setting settings[] = {
+        { "speed 1.00", 1.0, false, 0.0 },
+        { "speed 1.25", 1.25, false, 0.0 },
+        { "speed 1.25 key lock", 1.25, true, 0.0 },
+        { "pitch +3", 1.0, false, 3.0 }
+    };
+    auto seconds = quick ? 2.0 : 10.0;
+    ReadAheadPool readAheadPool(1);
+
+    for (auto blockSize : { 64, 128, 256, 512, 1024 })
+    {
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        juce::AudioSourceChannelInfo info(&buffer, 0, blockSize);
+        for (auto& setting : settings)
+        {
+            for (auto reverbOn : { false, true })
+            {
+                auto player = createPlayer(formatManager, readAheadPool, testFile);
+                player->prepareToPlay(blockSize, deviceSampleRate);
+                player->setSpeed(setting.speed);
+                player->setKeyLock(setting.keyLock);
+                player->setPitchSemitones(setting.pitch);
+                player->setWetLevel(reverbOn ? 0.4f : 0.0f);
+                player->setRoomSize(0.7f);
+
+                auto times = timeBlocks(blockSize, seconds, [&] { player->getNextAudioBlock(info); });
+                results.addBlockTimes("player",
+                                      juce::String(setting.name) + (reverbOn ? " reverb" : "")
+                                          + " block " + juce::String(blockSize),
+                                      times, blockSize / deviceSampleRate);
+                player->releaseResources();
+            }
+        }
+    }
+}
+
+void DeckBenchmarks::runMixerBenchmarks(BenchmarkResults& results, juce::AudioFormatManager& formatManager,
+                                        const juce::File& testFile, bool quick)
+{
+    const int blockSize = 256;
+    auto seconds = quick ? 2.0 : 10.0;
+    ReadAheadPool readAheadPool(1);
+
+    for (auto numDecks : { 1, 2, 4, 8 })
+    {
+        juce::OwnedArray<DJAudioPlayer> players;
+        DeckMixer mixer;
+        mixer.prepareToPlay(blockSize, deviceSampleRate);
+        for (int i = 0; i < numDecks; ++i)
+        {
+            auto* player = players.add(createPlayer(formatManager, readAheadPool, testFile).release());
+            // every deck doing real work: off-speed with a reverb tail
+            player->setSpeed(1.0 + 0.05 * i);
+            player->setWetLevel(0.3f);
+            mixer.addDeck(i, player);
+        }
+
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        juce::AudioSourceChannelInfo info(&buffer, 0, blockSize);
+        auto times = timeBlocks(blockSize, seconds, [&] { mixer.getNextAudioBlock(info); });
+        double renderSeconds = 0;
+        for (auto time : times)
+        {
+            renderSeconds += time;
+        }
+
+        auto name = juce::String(numDecks) + " decks";
+        results.addBlockTimes("mixer", name, times, blockSize / deviceSampleRate);
+        results.add("mixer", name, "realtime factor", (double) times.size() * blockSize / deviceSampleRate / renderSeconds, "x");
+
+        auto stats = mixer.getRenderStats();
+        results.add("mixer", name, "parallel blocks", (double) stats.parallelBlocks, "blocks");
+        results.add("mixer", name, "deadline misses", (double) stats.deadlineMisses, "blocks");
+        results.add("mixer", name, "late jobs", (double) stats.lateJobs, "jobs");
+        for (int thread = 0; thread < stats.threads.size(); ++thread)
+        {
+            results.add("mixer", name, "thread " + juce::String(thread) + " busy",
+                        stats.threads[thread].busySeconds * 1000.0, "ms");
+        }
+
+        for (int i = 0; i < numDecks; ++i)
+        {
+            mixer.removeDeck(i);
+        }
+    }
+}
+
+bool DeckBenchmarks::runSyncChecks(BenchmarkResults& results, juce::AudioFormatManager& formatManager,
+                                   const juce::File& workingDirectory, bool quick)
+{
+    // 120 and 100 bpm, so following the first makes the second stretch by 1.2 with key lock
+    auto masterFile = workingDirectory.getChildFile("clicks_120.wav");
+    auto followerFile = workingDirectory.getChildFile("clicks_100.wav");
+    if (!createClickTrack(masterFile, 120.0, 30.0, 44100.0) || !createClickTrack(followerFile, 100.0, 30.0, 44100.0))
+    {
+        DBG("DeckBenchmarks::runSyncChecks could not write the click tracks");
+        return false;
+    }
+
+    const int blockSize = 256;
+    // the follower needs a few beats to pull into phase, so only the clicks after that are compared
+    auto settleSamples = (juce::int64) (10.0 * deviceSampleRate);
+    auto numBlocks = (int) ((quick ? 20.0 : 40.0) * deviceSampleRate / blockSize);
+    ReadAheadPool readAheadPool(1);
+    SyncEngine engine;
+    engine.prepare(deviceSampleRate);
+
+    auto master = createPlayer(formatManager, readAheadPool, masterFile);
+    auto follower = createPlayer(formatManager, readAheadPool, followerFile);
+    for (auto* player : { master.get(), follower.get() })
+    {
+        player->setSyncEngine(&engine);
+        player->prepareToPlay(blockSize, deviceSampleRate);
+    }
+    master->setBeatGrid({ 120.0, 0.0 });
+    master->setSyncMaster(true);
+    follower->setBeatGrid({ 100.0, 0.0 });
+    follower->setKeyLock(true);
+    follower->setSyncing(true);
+
+    juce::AudioBuffer<float> masterBuffer(2, blockSize);
+    juce::AudioBuffer<float> followerBuffer(2, blockSize);
+    ClickFinder masterClicks;
+    ClickFinder followerClicks;
+    for (int block = 0; block < numBlocks; ++block)
+    {
+        engine.beginChunk(blockSize);
+        master->getNextAudioBlock(juce::AudioSourceChannelInfo(&masterBuffer, 0, blockSize));
+        follower->getNextAudioBlock(juce::AudioSourceChannelInfo(&followerBuffer, 0, blockSize));
+        masterClicks.process(masterBuffer.getReadPointer(0), blockSize, (juce::int64) block * blockSize);
+        followerClicks.process(followerBuffer.getReadPointer(0), blockSize, (juce::int64) block * blockSize);
+    }
+    master->releaseResources();
+    follower->releaseResources();
+
+    // each of the follower's clicks against the master's nearest
+    double totalOffset = 0;
+    double worstOffset = 0;
+    int numCompared = 0;
+    for (auto click : followerClicks.clicks)
+    {
+        if (click < settleSamples || masterClicks.clicks.empty())
+        {
+            continue;
+        }
+        auto nearest = std::lower_bound(masterClicks.clicks.begin(), masterClicks.clicks.end(), click);
+        auto offset = nearest == masterClicks.clicks.end() ? click - masterClicks.clicks.back() : *nearest - click;
+        if (nearest != masterClicks.clicks.begin() && std::abs((double) (click - *(nearest - 1))) < std::abs((double) offset))
+        {
+            offset = *(nearest - 1) - click;
+        }
+        auto offsetMs = -1000.0 * offset / deviceSampleRate;
+        totalOffset += offsetMs;
+        worstOffset = juce::jmax(worstOffset, std::abs(offsetMs));
+        ++numCompared;
+    }
+
+    auto meanOffset = numCompared > 0 ? totalOffset / numCompared : 0.0;
+    results.add("sync", "key lock follower at 1.2x", "beats compared", (double) numCompared, "beats");
+    results.add("sync", "key lock follower at 1.2x", "mean beat offset", meanOffset, "ms");
+    results.add("sync", "key lock follower at 1.2x", "worst beat offset", worstOffset, "ms");
+    // single clicks jitter by up to a hop as the stretcher crossfades them in, so only the mean is checked;
+    // a frame is over 20ms, so a deck synced to where it had read to misses by more than this
+    return numCompared > 0 && std::abs(meanOffset) < maxBeatOffsetMs;
+}
+
+bool DeckBenchmarks::runRenderChecks(BenchmarkResults& results, juce::AudioFormatManager& formatManager,
+                                     const juce::File& workingDirectory, bool quick)
+{
+    auto toneFile = workingDirectory.getChildFile("render_tone.wav");
+    auto clickFile = workingDirectory.getChildFile("render_clicks.wav");
+    auto length = quick ? 10.0 : 30.0;
+    if (!createTestFile(toneFile, length, 44100.0) || !createClickTrack(clickFile, 128.0, length, 44100.0))
+    {
+        DBG("DeckBenchmarks::runRenderChecks could not write the test files");
+        return false;
+    }
+
+    // every deck on a different path through the player, so each of them is run in parallel
+    OfflineRenderer::Session session;
+    session.sampleRate = deviceSampleRate;
+    session.blockSize = 512;
+    for (int i = 0; i < 4; ++i)
+    {
+        OfflineRenderer::DeckSettings deck;
+        deck.file = i % 2 == 0 ? toneFile : clickFile;
+        deck.startInMix = 0.25 * i;
+        deck.speed = 1.0 + 0.07 * i;
+        deck.keyLock = i >= 2;
+        deck.pitchSemitones = i == 3 ? -2.0 : 0.0;
+        deck.quality = i == 1 ? DeckResampler::Quality::cubic : DeckResampler::Quality::sinc;
+        deck.wetLevel = 0.2f * i;
+        deck.roomSize = 0.5f;
+        session.decks.push_back(deck);
+    }
+
+    // rendered twice, the second time while the CPU is busy elsewhere, which is when a
+    // deadline would have changed the output
+    OfflineRenderer renderer(formatManager);
+    juce::File outputs[2] = { workingDirectory.getChildFile("render_a.wav"),
+                              workingDirectory.getChildFile("render_b.wav") };
+    double renderSeconds[2] = {};
+    for (int run = 0; run < 2; ++run)
+    {
+        std::unique_ptr<CpuHog> hog;
+        if (run == 1)
+        {
+            hog = std::make_unique<CpuHog>();
+        }
+        juce::String error;
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        if (!renderer.render(session, outputs[run], nullptr, error))
+        {
+            DBG("DeckBenchmarks::runRenderChecks " << error);
+            return false;
+        }
+        renderSeconds[run] = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    }
+
+    auto identical = outputs[0].hasIdenticalContentTo(outputs[1]);
+    auto renderedLength = renderer.getRenderedLength();
+    results.add("render", "4 decks offline", "realtime factor", renderedLength / renderSeconds[0], "x");
+    results.add("render", "4 decks offline", "realtime factor with the CPU busy", renderedLength / renderSeconds[1], "x");
+    results.add("render", "4 decks offline", "renders identical", identical ? 1.0 : 0.0, "");
+    return identical;
+}
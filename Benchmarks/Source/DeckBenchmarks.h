@@ -0,0 +1,34 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "BenchmarkResults.h"
+
+//==============================================================================
+/*
+    Timings for the deck audio chain: the DSP stages on their own, a whole
+    DJAudioPlayer across block sizes, speeds and reverb settings, and the
+    mixer with more and more decks. Also a check that a deck synced through
+    the time-stretcher plays its beats with the master's, and one that an
+    offline render comes out the same every time.
+*/
+namespace DeckBenchmarks
+{
+    /**Writes a stereo test file: a chord with some noise, long enough to loop without repeating often*/
+    bool createTestFile(const juce::File& file, double lengthSeconds, double sampleRate);
+
+    void runDspBenchmarks(BenchmarkResults& results, bool quick);
+    void runPlayerBenchmarks(BenchmarkResults& results, juce::AudioFormatManager& formatManager,
+                             const juce::File& testFile, bool quick);
+    void runMixerBenchmarks(BenchmarkResults& results, juce::AudioFormatManager& formatManager,
+                            const juce::File& testFile, bool quick);
+    /**Syncs a key-locked, stretched deck to an unstretched master on click tracks and measures
+    *  how far apart their clicks come out. false if they're further apart than maxBeatOffsetMs on average*/
+    bool runSyncChecks(BenchmarkResults& results, juce::AudioFormatManager& formatManager,
+                       const juce::File& workingDirectory, bool quick);
+    /**Renders a session of several decks offline twice, the second time with every core
+    *  kept busy, and times both. false unless the two files are identical*/
+    bool runRenderChecks(BenchmarkResults& results, juce::AudioFormatManager& formatManager,
+                         const juce::File& workingDirectory, bool quick);
+
+    constexpr double maxBeatOffsetMs = 5.0;
+}
@@ -0,0 +1,123 @@
+#include <JuceHeader.h>
+#include "LibraryBenchmarks.h"
+#include "TrackLibrary.h"
+
+namespace
+{
+    /**A plausible path for the nth synthetic track; the files never exist*/
+    juce::File getTrackFile(int index)
+    {
+        return juce::File::getCurrentWorkingDirectory()
+            .getChildFile("Music")
+            .getChildFile("Artist " + juce::String(index % 500))
+            .getChildFile("Track " + juce::String(index) + " (Original Mix).mp3");
+    }
+
+    /**What the playlist does for each imported file, minus opening the file to read its length*/
+    void importTracks(TrackLibrary& library, int numTracks)
+    {
+        for (int i = 0; i < numTracks; ++i)
+        {
+            Song song{ getTrackFile(i) };
+            if (!library.contains(song.title))
+            {
+                song.lengthMs = (i % 600) * 1000;
+                library.add(song);
+            }
+        }
+    }
+}
+
+//==============================================================================
+void LibraryBenchmarks::run(BenchmarkResults& results, const juce::File& workingDirectory, bool quick)
+{
+    std::vector<int> sizes = { 1000, 10000 };
+    if (!quick)
+    {
+        sizes.push_back(100000);
+    }
+
+    for (auto numTracks : sizes)
+    {
+        auto name = juce::String(numTracks) + " tracks";
+
+        TrackLibrary library;
+        auto start = juce::Time::getHighResolutionTicks();
+        importTracks(library, numTracks);
+        results.add("library", name, "import", secondsSince(start) * 1000.0, "ms");
+
+        // hits spread through the library, then misses that have to scan all of it
+        const int numSearches = 200;
+        juce::Random random{ 3 };
+        start = juce::Time::getHighResolutionTicks();
+        for (int i = 0; i < numSearches / 2; ++i)
+        {
+            library.find("Track " + juce::String(random.nextInt(numTracks)) + " (");
+        }
+        results.add("library", name, "search hit", secondsSince(start) * 1.0e6 / (numSearches / 2), "us");
+        start = juce::Time::getHighResolutionTicks();
+        for (int i = 0; i < numSearches / 2; ++i)
+        {
+            library.find("no such track " + juce::String(i));
+        }
+        results.add("library", name, "search miss", secondsSince(start) * 1.0e6 / (numSearches / 2), "us");
+
+        auto file = workingDirectory.getChildFile("bench_library_" + juce::String(numTracks) + ".otolib");
+        auto journalFile = file.getSiblingFile(file.getFileName() + ".journal");
+        {
+            TrackLibrary stored;
+            stored.open(file);
+            start = juce::Time::getHighResolutionTicks();
+            for (int i = 0; i < library.size(); ++i)
+            {
+                stored.add(library.getTrack(i));
+            }
+            stored.commit();
+            results.add("library", name, "journal all", secondsSince(start) * 1000.0, "ms");
+
+            // what the playlist does for each analyzed track; the flush to disk dominates
+            const int numEdits = 20;
+            start = juce::Time::getHighResolutionTicks();
+            for (int i = 0; i < numEdits; ++i)
+            {
+                stored.setKey(random.nextInt(stored.size()), MusicalKey::fromIndex(i % 24));
+                stored.commit();
+            }
+            results.add("library", name, "edit commit", secondsSince(start) * 1.0e6 / numEdits, "us");
+        }
+
+        {
+            TrackLibrary replayed;
+            start = juce::Time::getHighResolutionTicks();
+            replayed.open(file);
+            results.add("library", name, "open replaying journal", secondsSince(start) * 1000.0, "ms");
+            start = juce::Time::getHighResolutionTicks();
+            replayed.compact();
+            results.add("library", name, "compact", secondsSince(start) * 1000.0, "ms");
+        }
+        {
+            TrackLibrary loaded;
+            start = juce::Time::getHighResolutionTicks();
+            loaded.open(file);
+            results.add("library", name, "open snapshot", secondsSince(start) * 1000.0, "ms");
+            results.add("library", name, "file size", (double) file.getSize() / 1024.0, "KiB");
+            results.add("library", name, "bytes per track", (double) file.getSize() / juce::jmax(1, loaded.size()), "B");
+
+            // what the playlist paints right after opening: the rows that fit on screen
+            const int numVisibleRows = 40;
+            start = juce::Time::getHighResolutionTicks();
+            for (int i = 0; i < juce::jmin(numVisibleRows, loaded.size()); ++i)
+            {
+                loaded.getTrack(i);
+            }
+            results.add("library", name, "first screen", secondsSince(start) * 1000.0, "ms");
+
+            if (loaded.size() != library.size())
+            {
+                DBG("LibraryBenchmarks::run loaded " << loaded.size() << " of " << library.size() << " tracks");
+            }
+        }
+        file.deleteFile();
+        journalFile.deleteFile();
+    }
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "BenchmarkResults.h"
+
+//==============================================================================
+/*
+    Timings for the track library behind the playlist: importing, searching,
+    journaling, compacting and opening synthetic libraries of growing size.
+*/
+namespace LibraryBenchmarks
+{
+    void run(BenchmarkResults& results, const juce::File& workingDirectory, bool quick);
+}
@@ -0,0 +1,109 @@
+#include <JuceHeader.h>
+#include "BenchmarkResults.h"
+#include "DeckBenchmarks.h"
+#include "LibraryBenchmarks.h"
+#include <iostream>
+
+//==============================================================================
+/*
+    OtoDecksBench [--suite dsp|player|mixer|sync|render|library|all] [--format json|csv]
+                  [--output results.json] [--quick]
+
+    Prints the results to stdout unless an output file is given. --quick runs
+    shorter timings and skips the largest library, for a smoke test. Exits
+    with 1 if the sync check finds a synced deck's beats out of line, or two
+    offline renders of the same session differ.
+*/
+int main(int argc, char* argv[])
+{
+    // the decks use timers and the message thread, which need the event system running
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ArgumentList args(argc, argv);
+    auto suite = args.containsOption("--suite") ? args.getValueForOption("--suite") : juce::String("all");
+    auto format = args.containsOption("--format") ? args.getValueForOption("--format") : juce::String("json");
+    auto quick = args.containsOption("--quick");
+    auto runAll = suite == "all";
+
+    if (format != "json" && format != "csv")
+    {
+        std::cerr << "--format must be json or csv" << std::endl;
+        return 1;
+    }
+
+    auto workingDirectory = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                                .getChildFile("OtoDecksBench");
+    workingDirectory.createDirectory();
+    auto testFile = workingDirectory.getChildFile("test_tone.wav");
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    BenchmarkResults results;
+    if (runAll || suite == "dsp")
+    {
+        std::cerr << "Running DSP benchmarks" << std::endl;
+        DeckBenchmarks::runDspBenchmarks(results, quick);
+    }
+    if (runAll || suite == "player" || suite == "mixer")
+    {
+        if (!DeckBenchmarks::createTestFile(testFile, 30.0, 44100.0))
+        {
+            std::cerr << "Could not write " << testFile.getFullPathName() << std::endl;
+            return 1;
+        }
+        if (runAll || suite == "player")
+        {
+            std::cerr << "Running player benchmarks" << std::endl;
+            DeckBenchmarks::runPlayerBenchmarks(results, formatManager, testFile, quick);
+        }
+        if (runAll || suite == "mixer")
+        {
+            std::cerr << "Running mixer benchmarks" << std::endl;
+            DeckBenchmarks::runMixerBenchmarks(results, formatManager, testFile, quick);
+        }
+    }
+    auto checksPassed = true;
+    if (runAll || suite == "sync")
+    {
+        std::cerr << "Running sync checks" << std::endl;
+        checksPassed = DeckBenchmarks::runSyncChecks(results, formatManager, workingDirectory, quick);
+        if (!checksPassed)
+        {
+            std::cerr << "A synced deck's beats were more than " << DeckBenchmarks::maxBeatOffsetMs
+                      << "ms from the master's" << std::endl;
+        }
+    }
+    if (runAll || suite == "render")
+    {
+        std::cerr << "Running render checks" << std::endl;
+        if (!DeckBenchmarks::runRenderChecks(results, formatManager, workingDirectory, quick))
+        {
+            std::cerr << "Two offline renders of the same session differ" << std::endl;
+            checksPassed = false;
+        }
+    }
+    if (runAll || suite == "library")
+    {
+        std::cerr << "Running library benchmarks" << std::endl;
+        LibraryBenchmarks::run(results, workingDirectory, quick);
+    }
+
+    auto text = format == "csv" ? results.toCSV() : results.toJSON();
+    if (args.containsOption("--output"))
+    {
+        auto output = args.getFileForOption("--output");
+        if (!output.replaceWithText(text))
+        {
+            std::cerr << "Could not write " << output.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        std::cout << text << std::endl;
+    }
+
+    workingDirectory.deleteRecursively();
+    return checksPassed ? 0 : 1;
+}
@@ -0,0 +1,321 @@
+#include <JuceHeader.h>
+#include "AudioTelemetry.h"
+
+namespace
+{
+    // a callback this many block durations after the previous one means audio was missed
+    constexpr double lateCallbackFactor = 2.0;
+
+    double ticksToSeconds(juce::int64 ticks)
+    {
+        return juce::Time::highResolutionTicksToSeconds(ticks);
+    }
+}
+
+//==============================================================================
+AudioTelemetry::DeckTimings::DeckTimings()
+{
+    for (auto& total : stageTotals)
+    {
+        total.store(0);
+    }
+}
+
+void AudioTelemetry::DeckTimings::record(const juce::int64 (&stageTicks)[numDeckStages], int numSamples,
+                                         double sampleRate, int numUnderruns) noexcept
+{
+    if (resetRequested.exchange(false, std::memory_order_acquire))
+    {
+        for (auto& total : stageTotals)
+        {
+            total.store(0, std::memory_order_relaxed);
+        }
+        numSamplesTotal.store(0, std::memory_order_relaxed);
+        numBlocks.store(0, std::memory_order_relaxed);
+        peakLoad.store(0.0f, std::memory_order_relaxed);
+        peakStage.store(readStage, std::memory_order_relaxed);
+    }
+
+    juce::int64 blockTicks = 0;
+    int longestStage = readStage;
+    for (int stage = 0; stage < numDeckStages; ++stage)
+    {
+        stageTotals[stage].fetch_add(stageTicks[stage], std::memory_order_relaxed);
+        blockTicks += stageTicks[stage];
+        if (stageTicks[stage] > stageTicks[longestStage])
+        {
+            longestStage = stage;
+        }
+    }
+    numSamplesTotal.fetch_add(numSamples, std::memory_order_relaxed);
+    numBlocks.fetch_add(1, std::memory_order_relaxed);
+    underruns.store(numUnderruns, std::memory_order_relaxed);
+
+    if (numSamples > 0 && sampleRate > 0)
+    {
+        auto load = (float) (ticksToSeconds(blockTicks) * sampleRate / numSamples);
+        // only this thread raises the peak, so a plain compare is enough
+        if (load > peakLoad.load(std::memory_order_relaxed))
+        {
+            peakLoad.store(load, std::memory_order_relaxed);
+            peakStage.store(longestStage, std::memory_order_relaxed);
+        }
+    }
+}
+
+void AudioTelemetry::DeckTimings::reset()
+{
+    resetRequested.store(true, std::memory_order_release);
+}
+
+//==============================================================================
+double AudioTelemetry::DeckSnapshot::getStageLoad(int stage) const
+{
+    return audioSeconds > 0 ? stageSeconds[stage] / audioSeconds : 0.0;
+}
+
+double AudioTelemetry::Snapshot::getAverageLoad() const
+{
+    return audioSeconds > 0 ? renderSeconds / audioSeconds : 0.0;
+}
+
+AudioTelemetry::Snapshot AudioTelemetry::Snapshot::since(const Snapshot& earlier) const
+{
+    auto difference = *this;
+    // a reset in between leaves the earlier counts bigger, so start from zero instead
+    if (numBlocks < earlier.numBlocks)
+    {
+        return difference;
+    }
+
+    difference.numBlocks -= earlier.numBlocks;
+    difference.overruns -= earlier.overruns;
+    difference.lateCallbacks -= earlier.lateCallbacks;
+    difference.renderSeconds -= earlier.renderSeconds;
+    difference.audioSeconds -= earlier.audioSeconds;
+    for (int bin = 0; bin < numLoadBins; ++bin)
+    {
+        difference.histogram[bin] -= earlier.histogram[bin];
+    }
+    for (int slot = 0; slot < maxDecks; ++slot)
+    {
+        auto& deck = difference.decks[slot];
+        const auto& earlierDeck = earlier.decks[slot];
+        if (deck.numBlocks >= earlierDeck.numBlocks)
+        {
+            deck.numBlocks -= earlierDeck.numBlocks;
+            deck.audioSeconds -= earlierDeck.audioSeconds;
+            for (int stage = 0; stage < numDeckStages; ++stage)
+            {
+                deck.stageSeconds[stage] -= earlierDeck.stageSeconds[stage];
+            }
+        }
+    }
+    return difference;
+}
+
+//==============================================================================
+AudioTelemetry::AudioTelemetry()
+{
+    for (auto& bin : histogram)
+    {
+        bin.store(0);
+    }
+}
+
+void AudioTelemetry::prepare(double sampleRate)
+{
+    currentSampleRate.store(sampleRate);
+    // the first callback on the new settings has nothing to be late after
+    previousStartTicks = 0;
+    previousNumSamples = 0;
+}
+
+juce::int64 AudioTelemetry::beginBlock() noexcept
+{
+    auto startTicks = juce::Time::getHighResolutionTicks();
+    if (resetRequested.exchange(false, std::memory_order_acquire))
+    {
+        clearCounters();
+    }
+
+    auto sampleRate = currentSampleRate.load(std::memory_order_relaxed);
+    if (previousStartTicks != 0 && previousNumSamples > 0 && sampleRate > 0)
+    {
+        auto gap = ticksToSeconds(startTicks - previousStartTicks);
+        if (gap > lateCallbackFactor * previousNumSamples / sampleRate)
+        {
+            lateCallbacks.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    previousStartTicks = startTicks;
+    return startTicks;
+}
+
+void AudioTelemetry::endBlock(juce::int64 startTicks, int numSamples) noexcept
+{
+    auto blockTicks = juce::Time::getHighResolutionTicks() - startTicks;
+    previousNumSamples = numSamples;
+
+    numBlocks.fetch_add(1, std::memory_order_relaxed);
+    renderTicks.fetch_add(blockTicks, std::memory_order_relaxed);
+    numSamplesTotal.fetch_add(numSamples, std::memory_order_relaxed);
+
+    auto sampleRate = currentSampleRate.load(std::memory_order_relaxed);
+    if (numSamples > 0 && sampleRate > 0)
+    {
+        auto load = (float) (ticksToSeconds(blockTicks) * sampleRate / numSamples);
+        lastLoad.store(load, std::memory_order_relaxed);
+        updatePeak(peakLoad, load);
+        histogram[getLoadBin(load)].fetch_add(1, std::memory_order_relaxed);
+        if (load >= 1.0f)
+        {
+            overruns.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void AudioTelemetry::setDeviceXRuns(int numXRuns)
+{
+    deviceXRuns.store(numXRuns);
+}
+
+void AudioTelemetry::reset()
+{
+    resetRequested.store(true, std::memory_order_release);
+    for (auto& deck : decks)
+    {
+        deck.reset();
+    }
+}
+
+AudioTelemetry::DeckTimings& AudioTelemetry::getDeckTimings(int slot)
+{
+    jassert(juce::isPositiveAndBelow(slot, maxDecks));
+    return decks[slot];
+}
+
+AudioTelemetry::Snapshot AudioTelemetry::getSnapshot() const
+{
+    Snapshot snapshot;
+    snapshot.sampleRate = currentSampleRate.load();
+    snapshot.numBlocks = numBlocks.load();
+    snapshot.overruns = overruns.load();
+    snapshot.lateCallbacks = lateCallbacks.load();
+    snapshot.deviceXRuns = deviceXRuns.load();
+    snapshot.renderSeconds = ticksToSeconds(renderTicks.load());
+    snapshot.audioSeconds = snapshot.sampleRate > 0 ? numSamplesTotal.load() / snapshot.sampleRate : 0.0;
+    snapshot.lastLoad = lastLoad.load();
+    snapshot.peakLoad = peakLoad.load();
+    for (int bin = 0; bin < numLoadBins; ++bin)
+    {
+        snapshot.histogram[bin] = histogram[bin].load();
+    }
+
+    for (int slot = 0; slot < maxDecks; ++slot)
+    {
+        const auto& timings = decks[slot];
+        auto& deck = snapshot.decks[slot];
+        for (int stage = 0; stage < numDeckStages; ++stage)
+        {
+            deck.stageSeconds[stage] = ticksToSeconds(timings.stageTotals[stage].load());
+        }
+        deck.audioSeconds = snapshot.sampleRate > 0 ? timings.numSamplesTotal.load() / snapshot.sampleRate : 0.0;
+        deck.numBlocks = timings.numBlocks.load();
+        deck.peakLoad = timings.peakLoad.load();
+        deck.peakStage = timings.peakStage.load();
+        deck.underruns = timings.underruns.load();
+    }
+    return snapshot;
+}
+
+juce::var AudioTelemetry::createReport() const
+{
+    auto snapshot = getSnapshot();
+    auto* report = new juce::DynamicObject();
+    report->setProperty("time", juce::Time::getCurrentTime().toISO8601(true));
+    report->setProperty("sampleRate", snapshot.sampleRate);
+    report->setProperty("blocks", snapshot.numBlocks);
+    report->setProperty("averageLoad", snapshot.getAverageLoad());
+    report->setProperty("peakLoad", snapshot.peakLoad);
+    report->setProperty("overruns", snapshot.overruns);
+    report->setProperty("lateCallbacks", snapshot.lateCallbacks);
+    report->setProperty("deviceXRuns", snapshot.deviceXRuns);
+
+    juce::Array<juce::var> bins;
+    for (int bin = 0; bin < numLoadBins; ++bin)
+    {
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("fromPercent", getBinStartPercent(bin));
+        entry->setProperty("blocks", snapshot.histogram[bin]);
+        bins.add(juce::var(entry));
+    }
+    report->setProperty("loadHistogram", bins);
+
+    juce::Array<juce::var> deckReports;
+    for (int slot = 0; slot < maxDecks; ++slot)
+    {
+        const auto& deck = snapshot.decks[slot];
+        if (deck.numBlocks == 0)
+        {
+            continue;
+        }
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("deck", slot + 1);
+        entry->setProperty("blocks", deck.numBlocks);
+        for (int stage = 0; stage < numDeckStages; ++stage)
+        {
+            entry->setProperty(getStageName(stage) + "Load", deck.getStageLoad(stage));
+        }
+        entry->setProperty("peakLoad", deck.peakLoad);
+        entry->setProperty("peakStage", getStageName(deck.peakStage));
+        entry->setProperty("underruns", deck.underruns);
+        deckReports.add(juce::var(entry));
+    }
+    report->setProperty("decks", deckReports);
+    return juce::var(report);
+}
+
+juce::String AudioTelemetry::getStageName(int stage)
+{
+    switch (stage)
+    {
+        case readStage:   return "read";
+        case dspStage:    return "dsp";
+        case reverbStage: return "reverb";
+        default:          return {};
+    }
+}
+
+int AudioTelemetry::getBinStartPercent(int bin)
+{
+    return bin * 100 / (numLoadBins - 1);
+}
+
+int AudioTelemetry::getLoadBin(float load) noexcept
+{
+    return juce::jlimit(0, numLoadBins - 1, (int) (load * (numLoadBins - 1)));
+}
+
+void AudioTelemetry::updatePeak(std::atomic<float>& peak, float value) noexcept
+{
+    if (value > peak.load(std::memory_order_relaxed))
+    {
+        peak.store(value, std::memory_order_relaxed);
+    }
+}
+
+void AudioTelemetry::clearCounters() noexcept
+{
+    numBlocks.store(0, std::memory_order_relaxed);
+    overruns.store(0, std::memory_order_relaxed);
+    lateCallbacks.store(0, std::memory_order_relaxed);
+    renderTicks.store(0, std::memory_order_relaxed);
+    numSamplesTotal.store(0, std::memory_order_relaxed);
+    lastLoad.store(0.0f, std::memory_order_relaxed);
+    peakLoad.store(0.0f, std::memory_order_relaxed);
+    for (auto& bin : histogram)
+    {
+        bin.store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "DeckMixer.h"
+
+//==============================================================================
+/*
+    Measures how much of each audio callback's time budget the decks use. The
+    audio thread times every block against the block's duration and counts
+    it into a histogram of load percentages. Blocks that take longer than
+    their duration are counted as overruns, and callbacks that arrive well
+    after the previous block ran out as late, e.g. because the device glitched.
+
+    Each deck also times its own blocks per stage: reading the track, the
+    resampling and stretching, and the reverb, so a dropout can be traced to
+    the stage that caused it.
+
+    Everything is kept in atomics with a single writer, so the audio thread
+    never waits. A snapshot is read field by field and may mix two blocks,
+    which is fine for display.
+*/
+class AudioTelemetry
+{
+public:
+    static constexpr int maxDecks = DeckMixer::maxDecks;
+    // 5% bins up to 100%, then one for every block that overran
+    static constexpr int numLoadBins = 21;
+
+    enum DeckStage
+    {
+        readStage,
+        dspStage,
+        reverbStage,
+        numDeckStages
+    };
+
+    /**Timings of one deck, written by whichever thread renders it*/
+    class DeckTimings
+    {
+    public:
+        DeckTimings();
+
+        /**Rendering thread: one block's time per stage in high resolution ticks,
+        *  and the deck's read-ahead underruns so far*/
+        void record(const juce::int64 (&stageTicks)[numDeckStages], int numSamples,
+                    double sampleRate, int numUnderruns) noexcept;
+        /**Any thread: clears the timings before the next block is recorded*/
+        void reset();
+
+    private:
+        friend class AudioTelemetry;
+
+        std::atomic<juce::int64> stageTotals[numDeckStages];
+        std::atomic<juce::int64> numSamplesTotal{ 0 };
+        std::atomic<juce::int64> numBlocks{ 0 };
+        std::atomic<float> peakLoad{ 0.0f };
+        std::atomic<int> peakStage{ readStage };
+        std::atomic<int> underruns{ 0 };
+        std::atomic<bool> resetRequested{ false };
+    };
+
+    struct DeckSnapshot
+    {
+        double stageSeconds[numDeckStages] = {};
+        double audioSeconds = 0;
+        juce::int64 numBlocks = 0;
+        /**Worst block's time over its duration, and the stage that took longest in it*/
+        float peakLoad = 0;
+        int peakStage = readStage;
+        int underruns = 0;
+
+        /**Average share of the audio time a stage took*/
+        double getStageLoad(int stage) const;
+    };
+
+    struct Snapshot
+    {
+        double sampleRate = 0;
+        juce::int64 numBlocks = 0;
+        juce::int64 overruns = 0;
+        juce::int64 lateCallbacks = 0;
+        /**As reported by the device since it opened, -1 if it can't tell*/
+        int deviceXRuns = -1;
+        double renderSeconds = 0;
+        double audioSeconds = 0;
+        float lastLoad = 0;
+        float peakLoad = 0;
+        juce::int64 histogram[numLoadBins] = {};
+        DeckSnapshot decks[maxDecks];
+
+        /**Average share of the audio time the callbacks took*/
+        double getAverageLoad() const;
+        /**The counts and times that accumulated between an earlier snapshot and this one;
+        *  peaks are kept from this one*/
+        Snapshot since(const Snapshot& earlier) const;
+    };
+
+    AudioTelemetry();
+
+    /**Called from prepareToPlay*/
+    void prepare(double sampleRate);
+    /**Audio thread: call at the start of the callback, returns the start time to pass to endBlock*/
+    juce::int64 beginBlock() noexcept;
+    /**Audio thread: call at the end of the callback*/
+    void endBlock(juce::int64 startTicks, int numSamples) noexcept;
+    /**Message thread: the device's own xrun count, polled from AudioIODevice::getXRunCount*/
+    void setDeviceXRuns(int numXRuns);
+    /**Any thread: starts counting again from zero, for the callback and all decks*/
+    void reset();
+
+    DeckTimings& getDeckTimings(int slot);
+    Snapshot getSnapshot() const;
+    /**A snapshot as a JSON object, for saving to a file*/
+    juce::var createReport() const;
+
+    static juce::String getStageName(int stage);
+    /**Lower edge of a histogram bin as a percentage*/
+    static int getBinStartPercent(int bin);
+
+private:
+    static int getLoadBin(float load) noexcept;
+    static void updatePeak(std::atomic<float>& peak, float value) noexcept;
+    void clearCounters() noexcept;
+
+    std::atomic<double> currentSampleRate{ 0 };
+    std::atomic<juce::int64> numBlocks{ 0 };
+    std::atomic<juce::int64> overruns{ 0 };
+    std::atomic<juce::int64> lateCallbacks{ 0 };
+    std::atomic<int> deviceXRuns{ -1 };
+    std::atomic<juce::int64> renderTicks{ 0 };
+    std::atomic<juce::int64> numSamplesTotal{ 0 };
+    std::atomic<float> lastLoad{ 0.0f };
+    std::atomic<float> peakLoad{ 0.0f };
+    std::atomic<juce::int64> histogram[numLoadBins];
+    std::atomic<bool> resetRequested{ false };
+
+    // audio thread: when the previous callback started and how much audio it covered
+    juce::int64 previousStartTicks{ 0 };
+    int previousNumSamples{ 0 };
+
+    DeckTimings decks[maxDecks];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioTelemetry)
+};
@@ -0,0 +1,180 @@
+#include <JuceHeader.h>
+#include "BeatDetector.h"
+
+//==============================================================================
+BeatDetector::BeatDetector(double _sampleRate) : sampleRate(_sampleRate)
+{
+    hopSize = juce::jmax(1, juce::roundToInt(sampleRate * hopSecs));
+    maxFrames = (int) (maxAnalysisSecs * sampleRate / hopSize);
+    lowCoeff = 1.0 - std::exp(-juce::MathConstants<double>::twoPi * 150.0 / sampleRate);
+    midCoeff = 1.0 - std::exp(-juce::MathConstants<double>::twoPi * 2000.0 / sampleRate);
+}
+
+BeatDetector::~BeatDetector()
+{
+}
+
+void BeatDetector::process(const float* samples, int numSamples)
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto x = (double) samples[i];
+        low += lowCoeff * (x - low);
+        mid += midCoeff * (x - mid);
+        bandEnergy[0] += low * low;
+        bandEnergy[1] += (mid - low) * (mid - low);
+        bandEnergy[2] += (x - mid) * (x - mid);
+        if (++hopPos == hopSize)
+        {
+            endFrame();
+        }
+    }
+}
+
+void BeatDetector::endFrame()
+{
+    hopPos = 0;
+    float flux = 0;
+    float lowFlux = 0;
+    for (int band = 0; band < numBands; ++band)
+    {
+        auto level = (float) std::log1p(1000.0 * bandEnergy[band] / hopSize);
+        auto rise = juce::jmax(0.0f, level - lastLevel[band]);
+        flux += rise;
+        if (band == 0)
+        {
+            lowFlux = rise;
+        }
+        lastLevel[band] = level;
+        bandEnergy[band] = 0;
+    }
+    if ((int) onsets.size() < maxFrames)
+    {
+        onsets.push_back(flux);
+        lowOnsets.push_back(lowFlux);
+    }
+}
+
+BeatGrid BeatDetector::getBeatGrid() const
+{
+    auto frameRate = sampleRate / hopSize;
+    auto numFrames = (int) onsets.size();
+    if (numFrames < frameRate * minAnalysisSecs)
+    {
+        return {};
+    }
+
+    auto novelty = removeLocalMean(onsets);
+    auto minLag = juce::jmax(1, (int) std::floor(frameRate * 60.0 / maxBpm));
+    auto maxLag = (int) std::ceil(frameRate * 60.0 / minBpm);
+
+    // the curve against itself shifted by each lag, up to twice the longest beat for the harmonic below
+    std::vector<double> acf((size_t) (2 * maxLag + 1), 0.0);
+    for (int lag = minLag; lag <= 2 * maxLag && lag < numFrames; ++lag)
+    {
+        double sum = 0;
+        for (int t = 0; t + lag < numFrames; ++t)
+        {
+            sum += novelty[(size_t) t] * novelty[(size_t) (t + lag)];
+        }
+        acf[(size_t) lag] = sum / (numFrames - lag);
+    }
+
+    int bestLag = 0;
+    double bestLagScore = 0;
+    for (int lag = minLag; lag <= maxLag; ++lag)
+    {
+        auto octaves = std::log2(60.0 * frameRate / lag / preferredBpm) / octaveWidth;
+        // a true beat period also lines up at twice its length
+        auto score = std::exp(-0.5 * octaves * octaves) * (acf[(size_t) lag] + 0.5 * acf[(size_t) (2 * lag)]);
+        if (score > bestLagScore)
+        {
+            bestLag = lag;
+            bestLagScore = score;
+        }
+    }
+    if (bestLag == 0)
+    {
+        // silence, or nothing that repeats
+        return {};
+    }
+
+    // a lag in whole frames is too coarse to stay on the beat for a whole track, so search around it
+    double bestPeriod = bestLag;
+    double bestPhase = 0;
+    double bestScore = -1;
+    for (auto period = juce::jmax(1.0, bestLag - 1.0); period <= bestLag + 1.0; period += 0.02)
+    {
+        for (double phase = 0; phase < period; phase += 0.25)
+        {
+            auto score = combScore(novelty, phase, period);
+            if (score > bestScore)
+            {
+                bestPeriod = period;
+                bestPhase = phase;
+                bestScore = score;
+            }
+        }
+    }
+
+    // the bar starts on whichever of its four beats has the most bass
+    auto lowNovelty = removeLocalMean(lowOnsets);
+    int downbeat = 0;
+    double downbeatScore = -1;
+    for (int beat = 0; beat < 4; ++beat)
+    {
+        auto score = combScore(lowNovelty, bestPhase + beat * bestPeriod, 4 * bestPeriod);
+        if (score > downbeatScore)
+        {
+            downbeat = beat;
+            downbeatScore = score;
+        }
+    }
+    auto firstDownbeat = std::fmod(bestPhase + downbeat * bestPeriod, 4 * bestPeriod);
+
+    BeatGrid grid;
+    grid.bpm = 60.0 * frameRate / bestPeriod;
+    // a frame's rise happened somewhere during it, so take its middle
+    grid.firstBeatSecs = (firstDownbeat + 0.5) * hopSize / sampleRate;
+    return grid;
+}
+
+std::vector<float> BeatDetector::removeLocalMean(const std::vector<float>& curve) const
+{
+    auto halfWindow = juce::jmax(1, juce::roundToInt(0.125 * sampleRate / hopSize));
+    auto numFrames = (int) curve.size();
+    std::vector<float> result(curve.size());
+
+    // a running sum over the window, so this is linear in the length of the track
+    double sum = 0;
+    int windowStart = 0;
+    int windowEnd = 0;
+    for (int t = 0; t < numFrames; ++t)
+    {
+        for (; windowEnd < juce::jmin(numFrames, t + halfWindow + 1); ++windowEnd)
+        {
+            sum += curve[(size_t) windowEnd];
+        }
+        for (; windowStart < t - halfWindow; ++windowStart)
+        {
+            sum -= curve[(size_t) windowStart];
+        }
+        auto mean = sum / (windowEnd - windowStart);
+        result[(size_t) t] = juce::jmax(0.0f, (float) (curve[(size_t) t] - mean));
+    }
+    return result;
+}
+
+double BeatDetector::combScore(const std::vector<float>& curve, double phase, double period)
+{
+    double sum = 0;
+    int count = 0;
+    for (auto pos = phase; pos + 1 < (double) curve.size(); pos += period)
+    {
+        auto index = (size_t) pos;
+        auto frac = (float) (pos - (double) index);
+        sum += curve[index] + frac * (curve[index + 1] - curve[index]);
+        ++count;
+    }
+    return count > 0 ? sum / count : 0;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+#include "BeatGrid.h"
+
+//==============================================================================
+/*
+    Finds the tempo and the beat grid of a track fed in block by block.
+
+    Each hop of about 12ms adds one value to an onset curve: how much the
+    energy rose in three bands, on a log scale so quiet passages count too.
+    Only the curve is kept, a few hundred KB for a long track, never the
+    audio. The tempo is the autocorrelation peak of the curve, weighted
+    towards 120 BPM so half and double tempos lose out. A comb over the
+    whole curve then refines the period and finds where the beats fall, and
+    the bar starts on the beat with the strongest bass onsets, which is
+    usually where the kick lands.
+*/
+class BeatDetector
+{
+public:
+    explicit BeatDetector(double _sampleRate);
+    ~BeatDetector();
+
+    /**Feeds in the next block of the track, mixed down to mono*/
+    void process(const float* samples, int numSamples);
+    /**The grid that fits what was fed in best, its first beat being the first downbeat.
+    *  Invalid if the track is too short or has no steady beat*/
+    BeatGrid getBeatGrid() const;
+
+    // anything after this is ignored, which bounds the memory for very long files
+    static constexpr double maxAnalysisSecs = 1200.0;
+
+private:
+    void endFrame();
+    /**Subtracts the average over about a quarter second and drops what is left below zero*/
+    std::vector<float> removeLocalMean(const std::vector<float>& curve) const;
+    /**Average of a curve at phase, phase + period, phase + 2 * period and so on*/
+    static double combScore(const std::vector<float>& curve, double phase, double period);
+
+    static constexpr int numBands = 3;
+    static constexpr double hopSecs = 0.0116;
+    static constexpr double minAnalysisSecs = 5.0;
+    static constexpr double minBpm = 70.0;
+    static constexpr double maxBpm = 180.0;
+    static constexpr double preferredBpm = 120.0;
+    // how many octaves either side of preferredBpm the weighting falls off over
+    static constexpr double octaveWidth = 1.0;
+
+    double sampleRate;
+    int hopSize;
+    int maxFrames;
+    double lowCoeff;
+    double midCoeff;
+
+    // one-pole lowpasses splitting the bands at 150Hz and 2kHz
+    double low{ 0 };
+    double mid{ 0 };
+    double bandEnergy[numBands]{};
+    float lastLevel[numBands]{};
+    int hopPos{ 0 };
+
+    std::vector<float> onsets;
+    // the rises in the bass band alone, for finding the downbeat
+    std::vector<float> lowOnsets;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BeatDetector)
+};
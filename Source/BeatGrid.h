@@ -0,0 +1,46 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Where the beats of a track fall: a constant tempo from the first beat on.
+    A grid with no tempo means the track hasn't been analysed.
+*/
+struct BeatGrid
+{
+    double bpm = 0;
+    double firstBeatSecs = 0;
+
+    bool isValid() const
+    {
+        return bpm > 0;
+    }
+
+    double getBeatLengthSecs() const
+    {
+        return isValid() ? 60.0 / bpm : 0;
+    }
+
+    /**The beat nearest to a position, or the position itself without a grid*/
+    double getNearestBeat(double secs) const
+    {
+        if (!isValid())
+        {
+            return secs;
+        }
+        auto beat = std::round((secs - firstBeatSecs) / getBeatLengthSecs());
+        return juce::jmax(0.0, firstBeatSecs + beat * getBeatLengthSecs());
+    }
+
+    /**The first beat at or after a position, or the position itself without a grid*/
+    double getNextBeat(double secs) const
+    {
+        if (!isValid())
+        {
+            return secs;
+        }
+        auto beat = std::ceil((secs - firstBeatSecs) / getBeatLengthSecs());
+        return juce::jmax(0.0, firstBeatSecs + beat * getBeatLengthSecs());
+    }
+};
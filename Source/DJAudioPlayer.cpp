@@ -1,51 +1,520 @@
 
 #include "DJAudioPlayer.h"
-DJAudioPlayer::DJAudioPlayer(juce::AudioFormatManager& _formatManager
-                            ) : formatManager(_formatManager) , looping(false)
+DJAudioPlayer::DJAudioPlayer(juce::AudioFormatManager& _formatManager,
+                             ReadAheadPool& _readAheadPool
+                            ) : formatManager(_formatManager),
+                                readAheadPool(_readAheadPool),
+                                readAheadThread(_readAheadPool.getNextThread())
 {
     //Default reverb settings
-    reverbParameters.roomSize = 0;
-    reverbParameters.damping = 0;
-    reverbParameters.wetLevel = 0;
-    reverbParameters.dryLevel = 1.0;
-    reverbSource.setParameters(reverbParameters);
+    reverbParameters.roomSize = reverbRoomSize.load();
+    reverbParameters.damping = reverbDamping.load();
+    reverbParameters.wetLevel = reverbWetLevel.load();
+    reverbParameters.dryLevel = reverbDryLevel.load();
+    reverb.setParameters(reverbParameters);
 }
 
 DJAudioPlayer::~DJAudioPlayer()
 {
+    // the clock mustn't go on waiting for a deck that is gone
+    setSyncMaster(false);
 }
 
 void DJAudioPlayer::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
 {
+    deviceSampleRate = sampleRate;
     transportSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    stretchSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
     resampleSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
-    reverbSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    reverb.setSampleRate(sampleRate);
+    reverb.reset();
 }
 
 void DJAudioPlayer::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
 {
-    reverbSource.getNextAudioBlock(bufferToFill);
+    auto* timings = telemetry.load(std::memory_order_acquire);
+    auto startTicks = timings != nullptr ? juce::Time::getHighResolutionTicks() : 0;
+
+    // pick up a track the loader finished since the last block
+    auto trackChanged = transportSource.updateTrack();
+    auto deckSpeed = getSyncedSpeed(bufferToFill.numSamples);
+    playbackSpeed.store(deckSpeed);
+    stretchSource.setStretchFactor(getStretchFactor(deckSpeed));
+    resampleSource.setResamplingRatio(getResamplingRatio(deckSpeed));
+    if (trackChanged)
+    {
+        // drop the old track's samples and jump straight to the new ratio
+        stretchSource.flushBuffers();
+        resampleSource.flushBuffers();
+    }
+    resampleSource.getNextAudioBlock(bufferToFill);
+
+    // the master tells the clock where it got to, for the followers' next block
+    auto* engine = syncEngine.load(std::memory_order_acquire);
+    if (engine != nullptr && engine->isMaster(this) && transportSource.isPlaying())
+    {
+        auto gridBpm = transportSource.getGridBpm();
+        if (gridBpm > 0)
+        {
+            engine->reportMaster(gridBpm * deckSpeed, getAudibleBeatPosition(deckSpeed));
+        }
+    }
+    auto reverbStartTicks = timings != nullptr ? juce::Time::getHighResolutionTicks() : 0;
+
+    updateReverbParameters();
+    auto* buffer = bufferToFill.buffer;
+    if (buffer->getNumChannels() > 1)
+    {
+        reverb.processStereo(buffer->getWritePointer(0, bufferToFill.startSample),
+                             buffer->getWritePointer(1, bufferToFill.startSample),
+                             bufferToFill.numSamples);
+    }
+    else
+    {
+        reverb.processMono(buffer->getWritePointer(0, bufferToFill.startSample), bufferToFill.numSamples);
+    }
+
+    activeStages.store((resampleSource.isResampling() ? resampleStage : 0)
+                       | (stretchSource.isStretching() ? stretchStage : 0)
+                       | (reverb.isActive() ? reverbStage : 0));
+
+    // reading the track happens inside the stretcher and resampler, so it is taken out of their time
+    auto readTicks = transportSource.takeReadTicks();
+    if (timings != nullptr)
+    {
+        const juce::int64 stageTicks[AudioTelemetry::numDeckStages] = {
+            readTicks,
+            reverbStartTicks - startTicks - readTicks,
+            juce::Time::getHighResolutionTicks() - reverbStartTicks
+        };
+        timings->record(stageTicks, bufferToFill.numSamples, deviceSampleRate, underruns.load());
+    }
 }
 
 void DJAudioPlayer::releaseResources()
 {
     transportSource.releaseResources();
+    stretchSource.releaseResources();
     resampleSource.releaseResources();
-    reverbSource.releaseResources();
+}
+
+// with key lock the stretcher sets the tempo and the resampler only shifts the pitch,
+// without it the resampler changes both and the stretcher undoes the pitch shift's tempo change
+double DJAudioPlayer::getResamplingRatio(double deckSpeed) const
+{
+    auto ratio = keyLock.load() ? pitchFactor.load() : deckSpeed * pitchFactor.load();
+    auto trackSampleRate = transportSource.getCurrentTrackSampleRate();
+    if (trackSampleRate > 0 && deviceSampleRate > 0)
+    {
+        ratio *= trackSampleRate / deviceSampleRate;
+    }
+    return ratio;
+}
+
+void DJAudioPlayer::updateReverbParameters()
+{
+    auto newParameters = reverbParameters;
+    newParameters.roomSize = reverbRoomSize.load();
+    newParameters.damping = reverbDamping.load();
+    newParameters.wetLevel = reverbWetLevel.load();
+    newParameters.dryLevel = reverbDryLevel.load();
+
+    // a whole drag's worth of changes lands here as one update
+    if (newParameters.roomSize != reverbParameters.roomSize
+        || newParameters.damping != reverbParameters.damping
+        || newParameters.wetLevel != reverbParameters.wetLevel
+        || newParameters.dryLevel != reverbParameters.dryLevel)
+    {
+        reverbParameters = newParameters;
+        reverb.setParameters(reverbParameters);
+    }
+}
+
+double DJAudioPlayer::getStretchFactor(double deckSpeed) const
+{
+    return keyLock.load() ? deckSpeed / pitchFactor.load() : 1.0 / pitchFactor.load();
+}
+
+double DJAudioPlayer::getAudibleBeatPosition(double deckSpeed) const
+{
+    auto gridBpm = transportSource.getGridBpm();
+    auto trackSampleRate = transportSource.getCurrentTrackSampleRate();
+    if (gridBpm <= 0 || trackSampleRate <= 0)
+    {
+        return transportSource.getBeatPosition();
+    }
+    // the resampler holds the stretcher's output, which covers the track faster by the stretch factor
+    auto latency = stretchSource.getLatency() + resampleSource.getLatency() * getStretchFactor(deckSpeed);
+    return transportSource.getBeatPosition() - latency * gridBpm / (60.0 * trackSampleRate);
+}
+
+double DJAudioPlayer::getSyncedSpeed(int numSamples)
+{
+    auto manualSpeed = speed.load();
+    auto* engine = syncEngine.load(std::memory_order_acquire);
+    if (engine == nullptr || !syncing.load() || engine->isMaster(this) || !transportSource.isPlaying())
+    {
+        syncedSpeed = 0;
+        return manualSpeed;
+    }
+
+    auto target = engine->getFollowerSpeed(transportSource.getGridBpm(), getAudibleBeatPosition(playbackSpeed.load()));
+    if (target <= 0)
+    {
+        // no grid yet, so nothing to line up
+        syncedSpeed = 0;
+        return manualSpeed;
+    }
+    if (syncedSpeed <= 0)
+    {
+        syncedSpeed = manualSpeed;
+    }
+    // a ramp rather than a step, both when sync takes over and for each phase correction
+    syncedSpeed += (target - syncedSpeed) * juce::jmin(1.0, numSamples / (deviceSampleRate * syncRampSecs));
+    syncedSpeed = juce::jlimit(0.25, 4.0, syncedSpeed);
+    return syncedSpeed;
+}
+
+void DJAudioPlayer::setRealtime(bool isRealtime)
+{
+    realtime.store(isRealtime);
+}
+
+void DJAudioPlayer::setMemoryMapped(bool shouldMap)
+{
+    memoryMapped.store(shouldMap);
+}
+
+void DJAudioPlayer::setDecodeCache(DecodeCache* cache, bool fillOnMiss)
+{
+    fillDecodeCache.store(fillOnMiss);
+    decodeCache.store(cache);
+}
+
+void DJAudioPlayer::setPreloadCache(PreloadCache* cache)
+{
+    preloadCache.store(cache);
+}
+
+void DJAudioPlayer::setPreloading(bool shouldPreload)
+{
+    preloading.store(shouldPreload);
+}
+
+bool DJAudioPlayer::isPreloading() const
+{
+    return preloading.load();
+}
+
+bool DJAudioPlayer::isTrackInMemory() const
+{
+    return trackInMemory.load();
 }
 
 // R1A
 void DJAudioPlayer::loadURL(juce::URL audioURL)
 {
     DBG("DJAudioPlayer::loadURL called");
+    ++loadGeneration;
+    auto track = createTrack(audioURL, [](double) {});
+    if (track != nullptr) // good file!
+    {
+        publishTrack(std::move(track));
+    }
+}
+
+void DJAudioPlayer::loadURLAsync(juce::URL audioURL,
+                                 std::function<void(double progress)> onProgress,
+                                 std::function<void(bool loaded)> onLoaded)
+{
+    DBG("DJAudioPlayer::loadURLAsync called");
+    auto generation = ++loadGeneration;
+
+    loaderPool.addJob([this, audioURL, generation, onProgress, onLoaded]
+    {
+        auto reportProgress = [onProgress](double progress)
+        {
+            if (onProgress != nullptr)
+            {
+                juce::MessageManager::callAsync([onProgress, progress] { onProgress(progress); });
+            }
+        };
+
+        reportProgress(0.0);
+        auto track = createTrack(audioURL, reportProgress);
+        // a newer load was started while this one was running
+        bool loaded = track != nullptr && generation == loadGeneration.load();
+        if (loaded)
+        {
+            publishTrack(std::move(track));
+            reportProgress(1.0);
+        }
+
+        if (onLoaded != nullptr)
+        {
+            juce::MessageManager::callAsync([onLoaded, loaded] { onLoaded(loaded); });
+        }
+    });
+}
+
+void DJAudioPlayer::publishTrack(std::unique_ptr<LoadedTrack> track)
+{
+    // loop heads are decoded from the mapped file if there is one, which may be a decoded copy
+    auto url = track->mappedSource != nullptr ? juce::URL(track->mappedSource->getFile()) : track->url;
+    auto inMemory = track->memorySource != nullptr;
+    auto serial = transportSource.setTrack(std::move(track));
+    {
+        const juce::ScopedLock sl(trackLock);
+        loadedURL = url;
+        loadedSerial = serial;
+        loadedInMemory = inMemory;
+    }
+    trackInMemory.store(inMemory);
+    // the grid is kept in seconds, so the transport converts it again at the new track's rate
+    transportSource.setBeatGrid(getBeatGrid());
+    // looping may still be on from the last track
+    decodeLoopHead();
+    decodeHotCues();
+}
+
+void DJAudioPlayer::decodeLoopHead()
+{
+    // an offline deck reads the file itself without falling behind, and with looping
+    // off nothing jumps back; turning looping on decodes the head then
+    if (!realtime.load() || !transportSource.isLoopEnabled())
+    {
+        return;
+    }
+    loaderPool.addJob([this]
+    {
+        juce::URL url;
+        juce::uint32 serial;
+        {
+            const juce::ScopedLock sl(trackLock);
+            if (loadedInMemory)
+            {
+                // the jump back already reads from RAM
+                return;
+            }
+            url = loadedURL;
+            serial = loadedSerial;
+        }
+        // read the loop start when the job runs, so a burst of changes decodes only the latest
+        auto head = decodeSegment(url, serial, transportSource.getLoopStartSample(), loopHeadLength);
+        if (head != nullptr)
+        {
+            transportSource.setLoopHead(std::move(head));
+        }
+    });
+}
+
+void DJAudioPlayer::decodeHotCues()
+{
+    loaderPool.addJob([this]
+    {
+        juce::URL url;
+        juce::uint32 serial;
+        HotCues cues;
+        {
+            const juce::ScopedLock sl(trackLock);
+            if (loadedInMemory || loadedSerial == 0)
+            {
+                // a jump in a track in RAM already lands on RAM
+                return;
+            }
+            url = loadedURL;
+            serial = loadedSerial;
+            cues = hotCues;
+        }
+
+        std::unique_ptr<DecodedCueSet> cueSet(new DecodedCueSet());
+        cueSet->trackSerial = serial;
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(url.createInputStream(false)));
+        if (reader == nullptr)
+        {
+            DBG("DJAudioPlayer::decodeHotCues could not open " << url.getFileName());
+            return;
+        }
+        for (int i = 0; i < HotCues::numCues; ++i)
+        {
+            if (cues.isSet(i))
+            {
+                cueSet->cues[i] = decodeSegment(*reader, serial, transportSource.getSampleAt(cues.positions[i]),
+                                                loopHeadLength);
+            }
+        }
+        transportSource.setCueSegments(std::move(cueSet));
+    });
+}
+
+// decode with a reader of its own, so the read-ahead thread's reader is left alone
+std::unique_ptr<DecodedSegment> DJAudioPlayer::decodeSegment(const juce::URL& audioURL, juce::uint32 trackSerial,
+                                                             juce::int64 startSample, int numSamples)
+{
+    if (trackSerial == 0)
+    {
+        return nullptr;
+    }
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(audioURL.createInputStream(false)));
+    if (reader == nullptr)
+    {
+        DBG("DJAudioPlayer::decodeSegment could not open " << audioURL.getFileName());
+        return nullptr;
+    }
+    return decodeSegment(*reader, trackSerial, startSample, numSamples);
+}
+
+std::unique_ptr<DecodedSegment> DJAudioPlayer::decodeSegment(juce::AudioFormatReader& reader, juce::uint32 trackSerial,
+                                                             juce::int64 startSample, int numSamples)
+{
+    numSamples = (int) juce::jmin((juce::int64) numSamples, reader.lengthInSamples - startSample);
+    if (numSamples <= 0)
+    {
+        return nullptr;
+    }
+    std::unique_ptr<DecodedSegment> segment(new DecodedSegment());
+    segment->trackSerial = trackSerial;
+    segment->startSample = startSample;
+    segment->audio.setSize(2, numSamples);
+    reader.read(&segment->audio, 0, numSamples, startSample, true, true);
+    return segment;
+}
+
+// open, probe and pre-buffer a file, on whichever thread calls it
+std::unique_ptr<LoadedTrack> DJAudioPlayer::createTrack(const juce::URL& audioURL,
+                                                        const std::function<void(double)>& reportProgress)
+{
+    if (preloading.load() && audioURL.isLocalFile())
+    {
+        if (auto track = createPreloadedTrack(audioURL, reportProgress))
+        {
+            return track;
+        }
+    }
+
+    if (memoryMapped.load() && audioURL.isLocalFile())
+    {
+        auto file = audioURL.getLocalFile();
+        if (auto track = createMappedTrack(audioURL, file))
+        {
+            return track;
+        }
+
+        // a compressed file, which the cache may already have decoded
+        if (auto* cache = decodeCache.load())
+        {
+            auto cached = cache->findCachedFile(file);
+            if (cached.existsAsFile())
+            {
+                if (auto track = createMappedTrack(audioURL, cached))
+                {
+                    return track;
+                }
+            }
+            else if (fillDecodeCache.load())
+            {
+                cache->cacheInBackground(file);
+            }
+        }
+    }
+
     auto* reader = formatManager.createReaderFor(audioURL.createInputStream(false));
-    if (reader != nullptr) // good file!
+    if (reader == nullptr)
+    {
+        DBG("DJAudioPlayer::createTrack could not open " << audioURL.getFileName());
+        return nullptr;
+    }
+    reportProgress(0.25);
+
+    std::unique_ptr<LoadedTrack> track(new LoadedTrack());
+    track->url = audioURL;
+    track->sampleRate = reader->sampleRate;
+    track->lengthInSamples = reader->lengthInSamples;
+    track->readerSource.reset(new juce::AudioFormatReaderSource(reader, true));
+    if (!realtime.load())
+    {
+        return track;
+    }
+    // decode on the read-ahead thread so the audio callback never touches the disk
+    track->readAheadSource.reset(new ReadAheadSource(track->readerSource.get(),
+        readAheadThread, false, readAheadPool.getBufferSize(), underruns));
+    reportProgress(0.5);
+
+    // fill the buffer here rather than letting the first blocks underrun. The transport
+    // prepares it again as it is handed over if the device has changed in the meantime
+    auto blockSize = transportSource.getBlockSize();
+    if (blockSize > 0)
     {
-        std::unique_ptr<juce::AudioFormatReaderSource> newSource(new juce::AudioFormatReaderSource(reader,
-            true));
-        transportSource.setSource(newSource.get(), 0, nullptr, reader->sampleRate);
-        readerSource.reset(newSource.release());
+        track->prepare(blockSize, transportSource.getSampleRate());
+        track->readAheadSource->waitUntilBuffered(2000);
     }
+    reportProgress(0.9);
+    return track;
+}
+
+// decodes the whole track into the preload cache, from the decoded copy if there is one
+std::unique_ptr<LoadedTrack> DJAudioPlayer::createPreloadedTrack(const juce::URL& audioURL,
+                                                                 const std::function<void(double)>& reportProgress)
+{
+    auto* cache = preloadCache.load();
+    if (cache == nullptr)
+    {
+        return nullptr;
+    }
+
+    auto file = audioURL.getLocalFile();
+    auto decodeFrom = file;
+    if (auto* decoded = decodeCache.load())
+    {
+        auto cached = decoded->findCachedFile(file);
+        if (cached.existsAsFile())
+        {
+            decodeFrom = cached;
+        }
+    }
+
+    auto audio = cache->acquire(file, decodeFrom, [&reportProgress](double progress)
+    {
+        reportProgress(0.1 + 0.8 * progress);
+    });
+    if (audio == nullptr)
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<LoadedTrack> track(new LoadedTrack());
+    track->url = audioURL;
+    track->sampleRate = audio->sampleRate;
+    track->lengthInSamples = audio->audio.getNumSamples();
+    track->memorySource.reset(new PreloadedAudioSource(audio));
+    return track;
+}
+
+// maps the whole file; reads are synchronous either way, so offline rendering can use it too
+std::unique_ptr<LoadedTrack> DJAudioPlayer::createMappedTrack(const juce::URL& audioURL, const juce::File& fileToMap)
+{
+    auto source = MappedAudioSource::create(formatManager, fileToMap,
+                                            realtime.load() ? &readAheadThread : nullptr,
+                                            readAheadPool.getBufferSize());
+    if (source == nullptr)
+    {
+        return nullptr;
+    }
+
+    // have the start of the track in RAM before the first block asks for it
+    source->prefault(0, readAheadPool.getBufferSize());
+
+    std::unique_ptr<LoadedTrack> track(new LoadedTrack());
+    track->url = audioURL;
+    track->sampleRate = source->getSampleRate();
+    track->lengthInSamples = source->getTotalLength();
+    track->mappedSource = std::move(source);
+    auto blockSize = transportSource.getBlockSize();
+    if (blockSize > 0)
+    {
+        track->prepare(blockSize, transportSource.getSampleRate());
+    }
+    return track;
 }
 
 // R2A Start the song
@@ -60,13 +529,53 @@ void DJAudioPlayer::stop()
     transportSource.stop();
 }
 
-// R2B loop the song by reseting the position back to the start where pos = 0
-void DJAudioPlayer::loop(double pos)
+// R2B loop a region of the song, the audio thread jumps back at the exact sample
+void DJAudioPlayer::setLoop(double startSecs, double endSecs)
 {
-    if (transportSource.getCurrentPosition() >= transportSource.getLengthInSeconds() - 2)
+    if (startSecs < 0 || endSecs <= startSecs || endSecs > transportSource.getLengthInSeconds())
     {
-        transportSource.setPosition(transportSource.getLengthInSeconds() * pos);
+        DBG("DJAudioPlayer::setLoop loop should end after it starts and within the song");
     }
+    else {
+        transportSource.setLoop(startSecs, endSecs);
+        transportSource.setLoopEnabled(true);
+        decodeLoopHead();
+    }
+}
+
+void DJAudioPlayer::setLoopBeats(double beats, double bpm)
+{
+    if (beats <= 0 || bpm <= 0)
+    {
+        DBG("DJAudioPlayer::setLoopBeats beats and bpm should be above 0");
+    }
+    else {
+        auto startSecs = transportSource.getCurrentPosition();
+        if (transportSource.isQuantized())
+        {
+            startSecs = getBeatGrid().getNearestBeat(startSecs);
+        }
+        auto endSecs = juce::jmin(startSecs + beats * 60.0 / bpm, transportSource.getLengthInSeconds());
+        setLoop(startSecs, endSecs);
+    }
+}
+
+void DJAudioPlayer::setLooping(bool shouldLoop)
+{
+    transportSource.setLoopEnabled(shouldLoop);
+    decodeLoopHead();
+}
+
+bool DJAudioPlayer::isLooping() const
+{
+    return transportSource.isLoopEnabled();
+}
+
+void DJAudioPlayer::clearLoop()
+{
+    transportSource.clearLoop();
+    // back to looping the whole track, which starts at 0
+    decodeLoopHead();
 }
 
 void DJAudioPlayer::setPosition(double posInSecs)
@@ -107,62 +616,81 @@ void DJAudioPlayer::setSpeed(double ratio)
         DBG("DJAudioPlayer::setSpeed ratio should be between 0.25 and 4");
     }
     else {
-        resampleSource.setResamplingRatio(ratio);
+        // picked up by the audio thread on its next block
+        speed.store(ratio);
     }
 }
 
+void DJAudioPlayer::setKeyLock(bool shouldLockKey)
+{
+    keyLock.store(shouldLockKey);
+}
+
+bool DJAudioPlayer::isKeyLocked() const
+{
+    return keyLock.load();
+}
+
+void DJAudioPlayer::setPitchSemitones(double semitones)
+{
+    if (semitones < -12.0 || semitones > 12.0)
+    {
+        DBG("DJAudioPlayer::setPitchSemitones semitones should be between -12 and 12");
+    }
+    else {
+        pitchFactor.store(std::pow(2.0, semitones / 12.0));
+    }
+}
+
+void DJAudioPlayer::setResamplingQuality(DeckResampler::Quality quality)
+{
+    resampleSource.setQuality(quality);
+}
+
 
 // functions that will change the reverbs by using the JUCE library
 // change the roomsize of the song
 void DJAudioPlayer::setRoomSize(float roomSizeLevel)
 {
-    DBG("DJAudioPlayer::setRoomSize called");
     if (roomSizeLevel < 0 || roomSizeLevel > 1.0)
     {
         DBG("DJAudioPlayer::setRoomSize size should be between 0 and 1.0");
     }
     else {
-        reverbParameters.roomSize = roomSizeLevel;
-        reverbSource.setParameters(reverbParameters);
+        reverbRoomSize.store(roomSizeLevel);
     }
 }
 //change the damping value of the song
 void DJAudioPlayer::setDamping(float dampingLevel)
 {
-    DBG("DJAudioPlayer::setDamping called");
     if (dampingLevel < 0 || dampingLevel > 1.0)
     {
         DBG("DJAudioPlayer::setDamping amount should be between 0 and 1.0");
     }
     else {
-        reverbParameters.damping = dampingLevel;
-        reverbSource.setParameters(reverbParameters);
+        reverbDamping.store(dampingLevel);
     }
 }
 // change wet level of the song
 void DJAudioPlayer::setWetLevel(float wetLevel)
 {
-    DBG("DJAudioPlayer::setWetLevel called");
     if (wetLevel < 0 || wetLevel > 1.0)
     {
         DBG("DJAudioPlayer::setWetLevel level should be between 0 and 1.0");
     }
     else {
-        reverbParameters.wetLevel = wetLevel;
-        reverbSource.setParameters(reverbParameters);
+        reverbWetLevel.store(wetLevel);
     }
 }
 // change the drylevel of the song
 void DJAudioPlayer::setDryLevel(float dryLevel)
 {
-    DBG("DJAudioPlayer::setDryLevel called");
     if (dryLevel < 0 || dryLevel > 1.0)
     {
         DBG("DJAudioPlayer::setDryLevel level should be between 0 and 1.0");
     }
     else {
-        reverbParameters.dryLevel = dryLevel;
-        reverbSource.setParameters(reverbParameters);
+        reverbDryLevel.store(dryLevel);
     }
 }
 
@@ -175,3 +703,153 @@ double DJAudioPlayer::getLengthInSeconds()
 {
     return transportSource.getLengthInSeconds();
 }
+
+void DJAudioPlayer::setHotCues(const HotCues& cues)
+{
+    {
+        const juce::ScopedLock sl(trackLock);
+        hotCues = cues;
+        ++hotCuesVersion;
+    }
+    decodeHotCues();
+}
+
+HotCues DJAudioPlayer::getHotCues() const
+{
+    const juce::ScopedLock sl(trackLock);
+    return hotCues;
+}
+
+juce::uint32 DJAudioPlayer::getHotCuesVersion() const
+{
+    return hotCuesVersion.load();
+}
+
+void DJAudioPlayer::setHotCue(int index)
+{
+    if (index < 0 || index >= HotCues::numCues)
+    {
+        DBG("DJAudioPlayer::setHotCue index should be between 0 and " << HotCues::numCues - 1);
+    }
+    else {
+        auto posInSecs = transportSource.getCurrentPosition();
+        {
+            const juce::ScopedLock sl(trackLock);
+            if (transportSource.isQuantized())
+            {
+                posInSecs = beatGrid.getNearestBeat(posInSecs);
+            }
+            hotCues.positions[index] = posInSecs;
+            ++hotCuesVersion;
+        }
+        decodeHotCues();
+    }
+}
+
+void DJAudioPlayer::clearHotCue(int index)
+{
+    if (index < 0 || index >= HotCues::numCues)
+    {
+        DBG("DJAudioPlayer::clearHotCue index should be between 0 and " << HotCues::numCues - 1);
+    }
+    else {
+        {
+            const juce::ScopedLock sl(trackLock);
+            hotCues.positions[index] = -1.0;
+            ++hotCuesVersion;
+        }
+        decodeHotCues();
+    }
+}
+
+void DJAudioPlayer::triggerHotCue(int index)
+{
+    if (index < 0 || index >= HotCues::numCues || !getHotCues().isSet(index))
+    {
+        DBG("DJAudioPlayer::triggerHotCue cue " << index << " is not set");
+    }
+    else {
+        transportSource.triggerCue(transportSource.getSampleAt(getHotCues().positions[index]));
+    }
+}
+
+void DJAudioPlayer::setBeatGrid(const BeatGrid& grid)
+{
+    {
+        const juce::ScopedLock sl(trackLock);
+        beatGrid = grid;
+    }
+    transportSource.setBeatGrid(grid);
+}
+
+BeatGrid DJAudioPlayer::getBeatGrid() const
+{
+    const juce::ScopedLock sl(trackLock);
+    return beatGrid;
+}
+
+void DJAudioPlayer::setQuantize(bool shouldQuantize)
+{
+    transportSource.setQuantize(shouldQuantize);
+}
+
+bool DJAudioPlayer::isQuantized() const
+{
+    return transportSource.isQuantized();
+}
+
+void DJAudioPlayer::setSyncEngine(SyncEngine* engine)
+{
+    syncEngine.store(engine);
+}
+
+void DJAudioPlayer::setSyncing(bool shouldSync)
+{
+    syncing.store(shouldSync);
+}
+
+bool DJAudioPlayer::isSyncing() const
+{
+    return syncing.load();
+}
+
+void DJAudioPlayer::setSyncMaster(bool shouldLead)
+{
+    if (auto* engine = syncEngine.load())
+    {
+        if (shouldLead)
+        {
+            engine->setMaster(this);
+        }
+        else if (engine->isMaster(this))
+        {
+            engine->setMaster(nullptr);
+        }
+    }
+}
+
+bool DJAudioPlayer::isSyncMaster() const
+{
+    auto* engine = syncEngine.load();
+    return engine != nullptr && engine->isMaster(this);
+}
+
+double DJAudioPlayer::getPlaybackSpeed() const
+{
+    return playbackSpeed.load();
+}
+
+int DJAudioPlayer::getNumUnderruns() const
+{
+    return underruns.load();
+}
+
+int DJAudioPlayer::getActiveStages() const
+{
+    return activeStages.load();
+}
+
+void DJAudioPlayer::setTelemetry(AudioTelemetry::DeckTimings* deckTimings)
+{
+    telemetry.store(deckTimings, std::memory_order_release);
+}
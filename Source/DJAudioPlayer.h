@@ -1,20 +1,62 @@
 
 
 #pragma once
-#include "../JuceLibraryCode/JuceHeader.h"
+#include <JuceHeader.h>
+#include "ReadAheadPool.h"
+#include "DeckTransport.h"
+#include "DeckResampler.h"
+#include "TimeStretcher.h"
+#include "VectorReverb.h"
+#include "AudioTelemetry.h"
+#include "DecodeCache.h"
+#include "PreloadCache.h"
+#include "HotCues.h"
+#include "BeatGrid.h"
+#include "SyncEngine.h"
 
 class DJAudioPlayer : public juce::AudioSource
 {
     public:
-        DJAudioPlayer(juce::AudioFormatManager& _formatManager);
+        /**Bits of getActiveStages(), one per DSP stage that can be bypassed*/
+        enum Stage
+        {
+            resampleStage = 1,
+            stretchStage = 2,
+            reverbStage = 4
+        };
+
+        DJAudioPlayer(juce::AudioFormatManager& _formatManager, ReadAheadPool& _readAheadPool);
         ~DJAudioPlayer();
 
         void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
         void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
         void releaseResources() override;
 
-        /**Loads the audio file*/
+        /**Offline rendering reads straight from the file instead of through the read-ahead
+        *  buffer, so the output never depends on disk timing. Affects tracks loaded afterwards*/
+        void setRealtime(bool isRealtime);
+        /**Plays uncompressed local files (WAV, AIFF) from a memory mapping instead of through
+        *  the read-ahead buffer, on by default. Affects tracks loaded afterwards*/
+        void setMemoryMapped(bool shouldMap);
+        /**Plays compressed tracks from their decoded copy when the cache has one. With fillOnMiss
+        *  a track that isn't cached yet is decoded into it for next time. Null stops using it*/
+        void setDecodeCache(DecodeCache* cache, bool fillOnMiss);
+        /**Where tracks are decoded into RAM when preloading is on. Null turns preloading off*/
+        void setPreloadCache(PreloadCache* cache);
+        /**Decodes each local track fully into RAM before it plays, so playback never touches
+        *  the disk. Falls back to streaming when the cache's budget is full. Affects tracks
+        *  loaded afterwards*/
+        void setPreloading(bool shouldPreload);
+        bool isPreloading() const;
+        /**True if the track last loaded plays from RAM, false if it streams from disk*/
+        bool isTrackInMemory() const;
+        /**Loads the audio file, blocking until it is ready*/
         void loadURL(juce::URL audioURL);
+        /**Opens and pre-buffers the audio file on a worker thread, then swaps it in
+        *  without stalling the audio thread. Both callbacks run on the message thread*/
+        void loadURLAsync(juce::URL audioURL,
+                          std::function<void(double progress)> onProgress,
+                          std::function<void(bool loaded)> onLoaded);
         /**Plays loaded audio file*/
         void play();
         /**Stops playing audio file*/
@@ -25,25 +67,149 @@ class DJAudioPlayer : public juce::AudioSource
         void setGain(double gain);
         /**Sets the speed*/
         void setSpeed(double ratio);
+        /**Keeps the pitch when the speed changes*/
+        void setKeyLock(bool shouldLockKey);
+        bool isKeyLocked() const;
+        /**Shifts the pitch by up to an octave either way, independently of the speed*/
+        void setPitchSemitones(double semitones);
+        /**Chooses the interpolation used for speed and sample rate changes*/
+        void setResamplingQuality(DeckResampler::Quality quality);
         /**Gets relative position of playhead*/
         double getPositionRelative();
         /**Gets the length of transport source in seconds*/
         double getLengthInSeconds();
-        /**Control the amount of reverb*/
+        /**Control the amount of reverb. Like the other setters these only store the value,
+        *  so calling them on every drag event costs nothing*/
         void setRoomSize(float roomSizeLevel);
         void setDamping(float dampingLevel);
         void setWetLevel(float wetLevel);
         void setDryLevel(float dryLevel);
-        /**Loop the audio file**/
-        void loop(double pos);
-        bool looping;
+        /**Loops between two positions in seconds, wrapped to the sample on the audio thread**/
+        void setLoop(double startSecs, double endSecs);
+        /**Loops a number of beats starting at the playhead, or at the nearest beat when quantizing*/
+        void setLoopBeats(double beats, double bpm);
+        /**Switches looping on or off. Without a loop set the whole track loops*/
+        void setLooping(bool shouldLoop);
+        bool isLooping() const;
+        void clearLoop();
+        /**Replaces all the hot cues, e.g. with the ones the library stored for a track.
+        *  The audio at each is decoded into RAM in the background*/
+        void setHotCues(const HotCues& cues);
+        HotCues getHotCues() const;
+        /**Any thread: changes whenever the hot cues do, so a display can skip redrawing them*/
+        juce::uint32 getHotCuesVersion() const;
+        /**Sets a hot cue at the playhead, on the nearest beat when quantizing*/
+        void setHotCue(int index);
+        void clearHotCue(int index);
+        /**Plays from a hot cue on the next block, or from the next beat when quantizing*/
+        void triggerHotCue(int index);
+        /**Where the beats of the loaded track fall, for quantizing*/
+        void setBeatGrid(const BeatGrid& grid);
+        BeatGrid getBeatGrid() const;
+        /**Makes hot cues set and trigger on the beat grid, when the track has one*/
+        void setQuantize(bool shouldQuantize);
+        bool isQuantized() const;
+        /**The clock the deck syncs to, or nullptr. It must outlive the player or be replaced first*/
+        void setSyncEngine(SyncEngine* engine);
+        /**Follows the sync clock's tempo and beats, once the track has a beat grid*/
+        void setSyncing(bool shouldSync);
+        bool isSyncing() const;
+        /**Makes this deck the one the sync clock follows, taking over from any other*/
+        void setSyncMaster(bool shouldLead);
+        bool isSyncMaster() const;
+        /**The speed the last block actually played at, which differs from the set speed when syncing*/
+        double getPlaybackSpeed() const;
+        /**Number of blocks where the read-ahead buffer could not keep up*/
+        int getNumUnderruns() const;
+        /**Stage bits for the processing the last block actually ran; the rest were bypassed*/
+        int getActiveStages() const;
+        /**Times every block per stage into these, or stops timing with nullptr.
+        *  They must outlive the player or be replaced first*/
+        void setTelemetry(AudioTelemetry::DeckTimings* deckTimings);
 
     private:
         void setPosition(double posInSecs);
+        /**Hands a track to the transport and remembers where it came from*/
+        void publishTrack(std::unique_ptr<LoadedTrack> track);
+        /**Decodes the start of the current loop on the loader thread while a realtime deck loops*/
+        void decodeLoopHead();
+        /**Decodes the audio at every hot cue on the loader thread*/
+        void decodeHotCues();
+        std::unique_ptr<DecodedSegment> decodeSegment(const juce::URL& audioURL, juce::uint32 trackSerial,
+                                                      juce::int64 startSample, int numSamples);
+        std::unique_ptr<DecodedSegment> decodeSegment(juce::AudioFormatReader& reader, juce::uint32 trackSerial,
+                                                      juce::int64 startSample, int numSamples);
+        std::unique_ptr<LoadedTrack> createTrack(const juce::URL& audioURL,
+                                                 const std::function<void(double)>& reportProgress);
+        /**Null unless preloading is on and the track fits the budget*/
+        std::unique_ptr<LoadedTrack> createPreloadedTrack(const juce::URL& audioURL,
+                                                          const std::function<void(double)>& reportProgress);
+        /**Null unless fileToMap's format can be mapped. audioURL is what was asked for,
+        *  fileToMap the file itself or its decoded copy*/
+        std::unique_ptr<LoadedTrack> createMappedTrack(const juce::URL& audioURL, const juce::File& fileToMap);
+        /**Input samples per output sample: speed times track rate over device rate*/
+        double getResamplingRatio(double deckSpeed) const;
+        /**Input samples per output sample for the time-stretcher, 1 when it can pass through*/
+        double getStretchFactor(double deckSpeed) const;
+        /**Audio thread: the transport's beat position less the track still buffered in the
+        *  stretcher and resampler, i.e. the beat being heard. deckSpeed is the last block's*/
+        double getAudibleBeatPosition(double deckSpeed) const;
+        /**Audio thread: the set speed, or the speed that keeps a syncing deck on the clock*/
+        double getSyncedSpeed(int numSamples);
+        /**Audio thread: passes the latest reverb settings on if any changed since the last block*/
+        void updateReverbParameters();
         juce::AudioFormatManager& formatManager;
-        std::unique_ptr<juce::AudioFormatReaderSource> readerSource;
-        juce::AudioTransportSource transportSource;
-        juce::ResamplingAudioSource resampleSource{ &transportSource, false, 2 };
-        juce::ReverbAudioSource reverbSource{ &resampleSource, false };
+        ReadAheadPool& readAheadPool;
+        juce::TimeSliceThread& readAheadThread;
+        std::atomic<int> underruns{ 0 };
+        std::atomic<int> activeStages{ 0 };
+        std::atomic<bool> realtime{ true };
+        std::atomic<bool> memoryMapped{ true };
+        std::atomic<DecodeCache*> decodeCache{ nullptr };
+        std::atomic<bool> fillDecodeCache{ false };
+        std::atomic<PreloadCache*> preloadCache{ nullptr };
+        std::atomic<bool> preloading{ false };
+        std::atomic<bool> trackInMemory{ false };
+        std::atomic<AudioTelemetry::DeckTimings*> telemetry{ nullptr };
+        DeckTransport transportSource;
+        std::atomic<double> speed{ 1.0 };
+        std::atomic<double> playbackSpeed{ 1.0 };
+        std::atomic<SyncEngine*> syncEngine{ nullptr };
+        std::atomic<bool> syncing{ false };
+        // audio thread: eases the speed towards the sync target, 0 while not following
+        double syncedSpeed{ 0 };
+        static constexpr double syncRampSecs = 0.25;
+        std::atomic<double> pitchFactor{ 1.0 };
+        std::atomic<bool> keyLock{ false };
+        // changes the tempo for key lock and pitch shifts
+        TimeStretcher stretchSource{ &transportSource, 2 };
+        // applies the speed and the track-to-device rate conversion in one pass
+        DeckResampler resampleSource{ &stretchSource, 2 };
+        // the setters only store these; the audio thread picks up the latest values once per block
+        std::atomic<float> reverbRoomSize{ 0.0f };
+        std::atomic<float> reverbDamping{ 0.0f };
+        std::atomic<float> reverbWetLevel{ 0.0f };
+        std::atomic<float> reverbDryLevel{ 1.0f };
+        // audio thread only; ramps its gains and damping per sample like juce::Reverb
+        VectorReverb reverb;
         juce::Reverb::Parameters reverbParameters;
+        double deviceSampleRate{ 0 };
+
+        // enough audio to cover the read-ahead buffer refilling after a loop or cue jump
+        static constexpr int loopHeadLength = 16384;
+        // the track last handed to the transport, for decoding segments of it
+        juce::CriticalSection trackLock;
+        juce::URL loadedURL;
+        juce::uint32 loadedSerial{ 0 };
+        // a track in RAM needs no loop heads decoded
+        bool loadedInMemory{ false };
+        // kept across loads, the deck sets them for each new track
+        HotCues hotCues;
+        std::atomic<juce::uint32> hotCuesVersion{ 0 };
+        BeatGrid beatGrid;
+
+        // a newer load makes older ones drop their result
+        std::atomic<juce::uint32> loadGeneration{ 0 };
+        // declared last so pending loads finish before anything they use is destroyed
+        juce::ThreadPool loaderPool{ 1 };
 };
\ No newline at end of file
@@ -15,13 +15,31 @@ DeckGUI::DeckGUI(int _id,
     addAndMakeVisible(stopButton);
     addAndMakeVisible(loadButton);
     addAndMakeVisible(loopButton);
+    addAndMakeVisible(loopInButton);
+    addAndMakeVisible(loopOutButton);
+    addAndMakeVisible(syncButton);
+    addAndMakeVisible(masterButton);
 
     addAndMakeVisible(volSlider);
     addAndMakeVisible(volLabel);
     addAndMakeVisible(speedSlider);
     addAndMakeVisible(speedLabel);
+    addAndMakeVisible(qualityBox);
+    addAndMakeVisible(keyLockButton);
+    addAndMakeVisible(ramButton);
+    for (int i = 0; i < HotCues::numCues; ++i)
+    {
+        addAndMakeVisible(cueButtons.add(new juce::TextButton(juce::String(i + 1))));
+    }
+    addAndMakeVisible(quantizeButton);
+    for (int beats = 1; beats <= 8; beats *= 2)
+    {
+        addAndMakeVisible(beatLoopButtons.add(new juce::TextButton("L" + juce::String(beats))));
+    }
     addAndMakeVisible(posSlider);
     addAndMakeVisible(posLabel);
+    addAndMakeVisible(pitchSlider);
+    addAndMakeVisible(pitchLabel);
 
     addAndMakeVisible(reverbGraph1);
     addAndMakeVisible(reverbGraph2);
@@ -41,6 +59,44 @@ DeckGUI::DeckGUI(int _id,
     loopButton.setColour(ComboBox::outlineColourId, Colours::deepskyblue);
     loopButton.setColour(TextButton::textColourOffId, Colours::deepskyblue);
     loopButton.setColour(TextButton::textColourOnId, Colours::limegreen);
+    loopInButton.setColour(ComboBox::outlineColourId, Colours::deepskyblue);
+    loopInButton.setColour(TextButton::textColourOffId, Colours::deepskyblue);
+    loopOutButton.setColour(ComboBox::outlineColourId, Colours::deepskyblue);
+    loopOutButton.setColour(TextButton::textColourOffId, Colours::deepskyblue);
+    syncButton.setColour(ComboBox::outlineColourId, Colours::deepskyblue);
+    syncButton.setColour(TextButton::textColourOffId, Colours::deepskyblue);
+    syncButton.setColour(TextButton::textColourOnId, Colours::limegreen);
+    syncButton.setTooltip("Follow the master's tempo and keep the beats lined up");
+    masterButton.setColour(ComboBox::outlineColourId, Colours::deepskyblue);
+    masterButton.setColour(TextButton::textColourOffId, Colours::deepskyblue);
+    masterButton.setColour(TextButton::textColourOnId, Colours::limegreen);
+    masterButton.setTooltip("Make this deck the one synced decks follow");
+    keyLockButton.setColour(ComboBox::outlineColourId, Colours::deepskyblue);
+    keyLockButton.setColour(TextButton::textColourOffId, Colours::deepskyblue);
+    keyLockButton.setColour(TextButton::textColourOnId, Colours::limegreen);
+    ramButton.setColour(ComboBox::outlineColourId, Colours::deepskyblue);
+    ramButton.setColour(TextButton::textColourOffId, Colours::deepskyblue);
+    ramButton.setColour(TextButton::textColourOnId, Colours::limegreen);
+    ramButton.setTooltip("Decode the next track loaded fully into RAM before it plays");
+    // hot cue buttons light up once their cue is set
+    for (auto* cueButton : cueButtons)
+    {
+        cueButton->setColour(ComboBox::outlineColourId, Colours::deepskyblue);
+        cueButton->setColour(TextButton::textColourOffId, Colours::deepskyblue);
+        cueButton->setColour(TextButton::textColourOnId, Colours::limegreen);
+        cueButton->setTooltip("Click to set the cue or play from it, shift-click to clear it");
+    }
+    quantizeButton.setColour(ComboBox::outlineColourId, Colours::deepskyblue);
+    quantizeButton.setColour(TextButton::textColourOffId, Colours::deepskyblue);
+    quantizeButton.setColour(TextButton::textColourOnId, Colours::limegreen);
+    quantizeButton.setTooltip("Set and play hot cues on the beat");
+    for (int i = 0; i < beatLoopButtons.size(); ++i)
+    {
+        beatLoopButtons[i]->setColour(ComboBox::outlineColourId, Colours::deepskyblue);
+        beatLoopButtons[i]->setColour(TextButton::textColourOffId, Colours::deepskyblue);
+        beatLoopButtons[i]->setTooltip("Loop " + juce::String(1 << i) + " beat(s) from the playhead, "
+                                       "starting on the nearest beat when quantizing");
+    }
 
     // add listeners
     playButton.addListener(this);
@@ -49,10 +105,26 @@ DeckGUI::DeckGUI(int _id,
     volSlider.addListener(this);
     speedSlider.addListener(this);
     posSlider.addListener(this);
+    pitchSlider.addListener(this);
     reverbSlider.addListener(this);
     reverbGraph1.addListener(this);
     reverbGraph2.addListener(this);
     loopButton.addListener(this);
+    loopInButton.addListener(this);
+    loopOutButton.addListener(this);
+    syncButton.addListener(this);
+    masterButton.addListener(this);
+    keyLockButton.addListener(this);
+    ramButton.addListener(this);
+    for (auto* cueButton : cueButtons)
+    {
+        cueButton->addListener(this);
+    }
+    quantizeButton.addListener(this);
+    for (auto* beatLoopButton : beatLoopButtons)
+    {
+        beatLoopButton->addListener(this);
+    }
 
 
     //configure volume slider and label
@@ -83,6 +155,18 @@ DeckGUI::DeckGUI(int _id,
     speedLabel.setText("Speed", juce::dontSendNotification);
     speedLabel.attachToComponent(&speedSlider, true);
 
+    //configure resampling quality, ids match DeckResampler::Quality
+    qualityBox.addItem("Linear", (int) DeckResampler::Quality::linear);
+    qualityBox.addItem("Cubic", (int) DeckResampler::Quality::cubic);
+    qualityBox.addItem("Sinc", (int) DeckResampler::Quality::sinc);
+    qualityBox.setSelectedId((int) DeckResampler::Quality::sinc, juce::dontSendNotification);
+    qualityBox.setTooltip("Resampling quality");
+    qualityBox.onChange = [this]
+    {
+        DBG("Quality box changed " << qualityBox.getText());
+        player->setResamplingQuality((DeckResampler::Quality) qualityBox.getSelectedId());
+    };
+
     //configure position slider and label
     posSlider.setRange(0.0, 1.0);
     posSlider.setNumDecimalPlacesToDisplay(2);
@@ -94,6 +178,18 @@ DeckGUI::DeckGUI(int _id,
     posLabel.setText("Position", juce::dontSendNotification);
     posLabel.attachToComponent(&posSlider, true);
 
+    //configure pitch slider and label, in semitones
+    pitchSlider.setRange(-12.0, 12.0, 0.1);
+    pitchSlider.setTextBoxStyle(juce::Slider::TextBoxLeft,
+                              false,
+                              50,
+                              pitchSlider.getTextBoxHeight()
+                             );
+    pitchSlider.setValue(0.0);
+    pitchSlider.setDoubleClickReturnValue(true, 0.0);
+    pitchLabel.setText("Pitch", juce::dontSendNotification);
+    pitchLabel.attachToComponent(&pitchSlider, true);
+
     //configure reverb slider
     reverbSlider.setRange(0.0, 1.0);
     reverbSlider.setNumDecimalPlacesToDisplay(2);
@@ -144,17 +240,43 @@ void DeckGUI::resized()
     //(x start, y start, width, height)
 
     //buttons position
-    playButton.setBounds(0, 0, mainPos / 4, getHeight() / 8);
-    stopButton.setBounds(mainPos / 4, 0, mainPos / 4, getHeight() / 8);
-    loadButton.setBounds(2 * mainPos / 4, 0, mainPos / 4, getHeight() / 8);
-    loopButton.setBounds(3 * mainPos / 4, 0, mainPos / 4, getHeight() / 8);
+    playButton.setBounds(0, 0, mainPos / 8, getHeight() / 8);
+    stopButton.setBounds(mainPos / 8, 0, mainPos / 8, getHeight() / 8);
+    loadButton.setBounds(2 * mainPos / 8, 0, mainPos / 8, getHeight() / 8);
+    loopButton.setBounds(3 * mainPos / 8, 0, mainPos / 8, getHeight() / 8);
+    loopInButton.setBounds(4 * mainPos / 8, 0, mainPos / 8, getHeight() / 8);
+    loopOutButton.setBounds(5 * mainPos / 8, 0, mainPos / 8, getHeight() / 8);
+    syncButton.setBounds(6 * mainPos / 8, 0, mainPos / 8, getHeight() / 8);
+    masterButton.setBounds(7 * mainPos / 8, 0, mainPos - 7 * mainPos / 8, getHeight() / 8);
 
     // sliders position
-    volSlider.setBounds(sliderPos, getHeight() / 8, mainPos - sliderPos, getHeight() / 8);
-    speedSlider.setBounds(sliderPos, 2 * getHeight() / 8, mainPos - sliderPos, getHeight() / 8);
+    auto qualityWidth = mainPos / 6;
+    volSlider.setBounds(sliderPos, getHeight() / 8, mainPos - sliderPos - qualityWidth, getHeight() / 8);
+    ramButton.setBounds(mainPos - qualityWidth, getHeight() / 8, qualityWidth, getHeight() / 8);
+    speedSlider.setBounds(sliderPos, 2 * getHeight() / 8, mainPos - sliderPos - 2 * qualityWidth, getHeight() / 8);
+    keyLockButton.setBounds(mainPos - 2 * qualityWidth, 2 * getHeight() / 8, qualityWidth, getHeight() / 8);
+    qualityBox.setBounds(mainPos - qualityWidth, 2 * getHeight() / 8, qualityWidth, getHeight() / 8);
     posSlider.setBounds(sliderPos, 3 * getHeight() / 8, mainPos - sliderPos, getHeight() / 8);
+    // beat loops share the pitch row
+    auto beatLoopWidth = mainPos / 16;
+    auto beatLoopsPos = mainPos - beatLoopButtons.size() * beatLoopWidth;
+    pitchSlider.setBounds(sliderPos, 4 * getHeight() / 8, beatLoopsPos - sliderPos, getHeight() / 8);
+    for (int i = 0; i < beatLoopButtons.size(); ++i)
+    {
+        beatLoopButtons[i]->setBounds(beatLoopsPos + i * beatLoopWidth, 4 * getHeight() / 8,
+                                      beatLoopWidth, getHeight() / 8);
+    }
+
+    // hot cues with the quantize switch on the end
+    auto cueWidth = mainPos / (HotCues::numCues + 1);
+    for (int i = 0; i < cueButtons.size(); ++i)
+    {
+        cueButtons[i]->setBounds(i * cueWidth, 5 * getHeight() / 8, cueWidth, getHeight() / 8);
+    }
+    quantizeButton.setBounds(HotCues::numCues * cueWidth, 5 * getHeight() / 8,
+                             mainPos - HotCues::numCues * cueWidth, getHeight() / 8);
 
-    waveformDisplay.setBounds(0, 4 * getHeight() / 8, mainPos, 4 * getHeight() / 8);
+    waveformDisplay.setBounds(0, 6 * getHeight() / 8, mainPos, 2 * getHeight() / 8);
 
     reverbGraph1.setBounds(mainPos, 0, graphPos, getHeight() / 2);
     reverbGraph2.setBounds(mainPos, getHeight()/2, graphPos, getHeight() / 2);
@@ -190,7 +312,104 @@ void DeckGUI::buttonClicked(juce::Button* button)
     {
         DBG("Loop button was clicked ");
         loopButton.setToggleState(!loopButton.getToggleState(), dontSendNotification);
-        player->looping = !player->looping;
+        player->setLooping(loopButton.getToggleState());
+    }
+    // mark the start of a loop at the playhead
+    if (button == &loopInButton)
+    {
+        DBG("Loop in button was clicked ");
+        loopInSecs = getPositionInSeconds();
+    }
+    // close the loop at the playhead and start looping
+    if (button == &loopOutButton)
+    {
+        DBG("Loop out button was clicked ");
+        auto loopOutSecs = getPositionInSeconds();
+        if (loopInSecs >= 0 && loopOutSecs > loopInSecs)
+        {
+            player->setLoop(loopInSecs, loopOutSecs);
+            loopButton.setToggleState(true, dontSendNotification);
+        }
+    }
+    // a beat loop needs the track's tempo, so it waits until the grid is known
+    auto beatLoopIndex = beatLoopButtons.indexOf(dynamic_cast<juce::TextButton*>(button));
+    if (beatLoopIndex >= 0)
+    {
+        auto beats = 1 << beatLoopIndex;
+        DBG("Beat loop " << beats << " button was clicked ");
+        auto grid = player->getBeatGrid();
+        if (grid.isValid())
+        {
+            player->setLoopBeats(beats, grid.bpm);
+            loopButton.setToggleState(player->isLooping(), dontSendNotification);
+        }
+        else
+        {
+            DBG("DeckGUI::buttonClicked no beat grid yet, so no beat loop");
+        }
+    }
+    // key lock keeps the pitch when the speed slider moves
+    if (button == &keyLockButton)
+    {
+        DBG("Key lock button was clicked ");
+        keyLockButton.setToggleState(!keyLockButton.getToggleState(), dontSendNotification);
+        player->setKeyLock(keyLockButton.getToggleState());
+    }
+    // RAM decodes tracks loaded from now on into memory, so the disk can't interrupt them
+    if (button == &ramButton)
+    {
+        DBG("RAM button was clicked ");
+        ramButton.setToggleState(!ramButton.getToggleState(), dontSendNotification);
+        player->setPreloading(ramButton.getToggleState());
+    }
+    // a hot cue is set on the first click and played from after that
+    auto cueIndex = cueButtons.indexOf(dynamic_cast<juce::TextButton*>(button));
+    if (cueIndex >= 0)
+    {
+        DBG("Hot cue " << cueIndex + 1 << " button was clicked ");
+        if (juce::ModifierKeys::getCurrentModifiers().isShiftDown())
+        {
+            player->clearHotCue(cueIndex);
+        }
+        else if (player->getHotCues().isSet(cueIndex))
+        {
+            player->triggerHotCue(cueIndex);
+            return;
+        }
+        else
+        {
+            player->setHotCue(cueIndex);
+        }
+        updateHotCues();
+        if (onHotCuesChanged)
+        {
+            onHotCuesChanged(loadedURL, player->getHotCues());
+        }
+    }
+    // sync follows the master clock until switched off, then stays at the tempo it had
+    if (button == &syncButton)
+    {
+        DBG("Sync button was clicked ");
+        syncButton.setToggleState(!syncButton.getToggleState(), dontSendNotification);
+        player->setSyncing(syncButton.getToggleState());
+        if (!syncButton.getToggleState())
+        {
+            speedSlider.setValue(player->getPlaybackSpeed());
+        }
+    }
+    // only one deck is master, so taking over turns the others' buttons off on their next timer tick
+    if (button == &masterButton)
+    {
+        DBG("Master button was clicked ");
+        player->setSyncMaster(!player->isSyncMaster());
+        masterButton.setToggleState(player->isSyncMaster(), dontSendNotification);
+    }
+    // quantize snaps hot cues to the beat grid, if the track has one
+    if (button == &quantizeButton)
+    {
+        DBG("Quantize button was clicked ");
+        quantizeButton.setToggleState(!quantizeButton.getToggleState(), dontSendNotification);
+        player->setQuantize(quantizeButton.getToggleState());
     }
 }
 
@@ -215,6 +434,12 @@ void DeckGUI::sliderValueChanged(juce::Slider* slider)
         DBG("Position slider moved " << slider->getValue());
         player->setPositionRelative(slider->getValue());
     }
+    //shift the pitch without changing the speed
+    if (slider == &pitchSlider)
+    {
+        DBG("Pitch slider moved " << slider->getValue());
+        player->setPitchSemitones(slider->getValue());
+    }
 }
 
 // reverb graphs changed will affect the values set to them
@@ -259,22 +484,112 @@ void DeckGUI::filesDropped(const juce::StringArray& files, int x, int y)
 void DeckGUI::loadFile(juce::URL audioURL)
 {
     DBG("DeckGUI::loadFile called");
-    player->loadURL(audioURL);
+    // the player opens the file on a worker thread so the other deck keeps playing smoothly
+    juce::Component::SafePointer<DeckGUI> safeThis{ this };
+    player->loadURLAsync(audioURL,
+        [safeThis](double progress)
+        {
+            if (safeThis != nullptr)
+            {
+                safeThis->loadButton.setButtonText("LOADING " + std::to_string(juce::roundToInt(progress * 100)) + "%");
+            }
+        },
+        [safeThis](bool loaded)
+        {
+            if (safeThis != nullptr)
+            {
+                safeThis->loadButton.setButtonText("LOAD");
+                if (!loaded)
+                {
+                    DBG("DeckGUI::loadFile file NOT loaded");
+                }
+            }
+        });
     waveformDisplay.loadURL(audioURL);
+    // loop points and cues belong to the previous track
+    loopInSecs = -1;
+    loadedURL = audioURL;
+    setTrackInfo({}, {});
+    if (onTrackLoading)
+    {
+        onTrackLoading(audioURL);
+    }
+}
+
+void DeckGUI::setTrackInfo(const HotCues& cues, const BeatGrid& grid)
+{
+    player->setHotCues(cues);
+    player->setBeatGrid(grid);
+    updateHotCues();
+}
+
+void DeckGUI::updateBeatGrid(const juce::URL& audioURL, const BeatGrid& grid)
+{
+    if (audioURL == loadedURL)
+    {
+        player->setBeatGrid(grid);
+    }
+}
+
+void DeckGUI::updateHotCues()
+{
+    // read the version first, so a change that lands in between shows on the next tick
+    shownHotCuesVersion = player->getHotCuesVersion();
+    auto cues = player->getHotCues();
+    auto length = player->getLengthInSeconds();
+    shownTrackLength = length;
+    juce::Array<double> positions;
+    for (int i = 0; i < cueButtons.size(); ++i)
+    {
+        cueButtons[i]->setToggleState(cues.isSet(i), dontSendNotification);
+        positions.add(cues.isSet(i) && length > 0 ? cues.positions[i] / length : -1.0);
+    }
+    waveformDisplay.setHotCues(positions);
+}
+
+double DeckGUI::getPositionInSeconds()
+{
+    return player->getPositionRelative() * player->getLengthInSeconds();
 }
 
 void DeckGUI::timerCallback()
 {   
+    waveformDisplay.setUnderrunCount(player->getNumUnderruns());
+    waveformDisplay.setLoadMode(player->isTrackInMemory() ? "IN-MEMORY" : "STREAMING");
+    // the markers are relative to the track's length, which is only known once it has loaded
+    if (player->getHotCuesVersion() != shownHotCuesVersion || player->getLengthInSeconds() != shownTrackLength)
+    {
+        updateHotCues();
+    }
+    masterButton.setToggleState(player->isSyncMaster(), dontSendNotification);
+    // show the speed sync chose, without setting it as the deck's own
+    if (player->isSyncing() && !speedSlider.isMouseButtonDown())
+    {
+        speedSlider.setValue(player->getPlaybackSpeed(), dontSendNotification);
+    }
+
+    // bypassed stages cost nothing, so show which ones are actually running
+    auto stages = player->getActiveStages();
+    juce::String stagesText = "DSP:";
+    if (stages & DJAudioPlayer::resampleStage)
+    {
+        stagesText << " RESAMPLE";
+    }
+    if (stages & DJAudioPlayer::stretchStage)
+    {
+        stagesText << " STRETCH";
+    }
+    if (stages & DJAudioPlayer::reverbStage)
+    {
+        stagesText << " REVERB";
+    }
+    waveformDisplay.setActiveStages(stages == 0 ? juce::String("DSP: BYPASSED") : stagesText);
+
     //check if the relative position is greater than 0  
     //otherwise loading file causes error
     if (player->getPositionRelative() > 0)
     {
         waveformDisplay.setPositionRelative(player->getPositionRelative());
-        //loop the audio and set it back to the start
-        if (player->looping == true)
-        {
-            player->loop(0);
-        }
     }
 
 }
\ No newline at end of file
@@ -39,6 +39,15 @@ public:
     void filesDropped(const juce::StringArray &files, int x, int y) override;
     /**Listen for changes to the waveform*/
     void timerCallback() override;
+    /**Passes in what the library knows about the track loading, e.g. from onTrackLoading*/
+    void setTrackInfo(const HotCues& cues, const BeatGrid& grid);
+    /**Passes in a grid analyzed after the track was loaded, if this deck still has it*/
+    void updateBeatGrid(const juce::URL& audioURL, const BeatGrid& grid);
+
+    /**Called when a track starts loading, so its stored cues and grid can be looked up*/
+    std::function<void(const juce::URL& audioURL)> onTrackLoading;
+    /**Called when the user sets or clears a hot cue, so the library can store them*/
+    std::function<void(const juce::URL& audioURL, const HotCues& cues)> onHotCuesChanged;
 
 private:
     int id;
@@ -47,17 +56,40 @@ private:
     juce::TextButton stopButton{ "STOP" };
     juce::TextButton loadButton{ "LOAD" };
     juce::TextButton loopButton{ "LOOP" };
+    juce::TextButton loopInButton{ "IN" };
+    juce::TextButton loopOutButton{ "OUT" };
+    juce::TextButton syncButton{ "SYNC" };
+    juce::TextButton masterButton{ "MASTER" };
+    juce::TextButton keyLockButton{ "KEY LOCK" };
+    juce::TextButton ramButton{ "RAM" };
+    juce::OwnedArray<juce::TextButton> cueButtons;
+    // loops of 1, 2, 4 and 8 beats from the playhead
+    juce::OwnedArray<juce::TextButton> beatLoopButtons;
+    juce::TextButton quantizeButton{ "Q" };
     juce::Slider volSlider;
     juce::Label volLabel;
     juce::Slider speedSlider;
     juce::Label speedLabel;
+    juce::ComboBox qualityBox;
     juce::Slider posSlider;
     juce::Label posLabel;
+    juce::Slider pitchSlider;
+    juce::Label pitchLabel;
     juce::Slider reverbSlider;
     graphDisplay reverbGraph1;
     graphDisplay reverbGraph2;
 
     void loadFile(juce::URL audioURL);
+    double getPositionInSeconds();
+    /**Shows the player's hot cues on the buttons and the waveform*/
+    void updateHotCues();
+
+    // where IN was pressed, -1 until then
+    double loopInSecs{ -1 };
+    // what the cue buttons and markers were last drawn from
+    juce::uint32 shownHotCuesVersion{ 0 };
+    double shownTrackLength{ -1 };
+    juce::URL loadedURL;
 
     DJAudioPlayer* player;
     WaveformDisplay waveformDisplay;
@@ -0,0 +1,127 @@
+#include <JuceHeader.h>
+#include "DeckManager.h"
+
+//==============================================================================
+DeckManager::DeckManager(DeckMixer& _mixer,
+                         AudioTelemetry& _telemetry,
+                         ReadAheadPool& _readAheadPool,
+                         DecodeCache& _decodeCache,
+                         PreloadCache& _preloadCache,
+                         SyncEngine& _syncEngine,
+                         juce::AudioFormatManager& _formatManager,
+                         juce::AudioThumbnailCache& _thumbCache
+                        ) : mixer(_mixer),
+                            telemetry(_telemetry),
+                            readAheadPool(_readAheadPool),
+                            decodeCache(_decodeCache),
+                            preloadCache(_preloadCache),
+                            syncEngine(_syncEngine),
+                            formatManager(_formatManager),
+                            thumbCache(_thumbCache)
+{
+}
+
+DeckManager::~DeckManager()
+{
+    while (!decks.isEmpty())
+    {
+        destroyDeck(decks.size() - 1);
+    }
+}
+
+bool DeckManager::addDeck()
+{
+    int slot = 0;
+    while (slot < maxDecks && !mixer.isSlotFree(slot))
+    {
+        ++slot;
+    }
+    if (slot == maxDecks)
+    {
+        DBG("DeckManager::addDeck all " << maxDecks << " decks are in use");
+        return false;
+    }
+
+    auto* deck = new Deck();
+    deck->slot = slot;
+    deck->player = std::make_unique<DJAudioPlayer>(formatManager, readAheadPool);
+    // tracks played on a deck are worth keeping decoded for next time
+    deck->player->setDecodeCache(&decodeCache, true);
+    deck->player->setPreloadCache(&preloadCache);
+    deck->player->setSyncEngine(&syncEngine);
+    deck->gui = std::make_unique<DeckGUI>(slot + 1, deck->player.get(), formatManager, thumbCache);
+
+    // keep the decks in slot order so they are laid out by number
+    int index = 0;
+    while (index < decks.size() && decks[index]->slot < slot)
+    {
+        ++index;
+    }
+    decks.insert(index, deck);
+
+    // the slot may have timings left from a deck that was removed
+    auto& timings = telemetry.getDeckTimings(slot);
+    timings.reset();
+    deck->player->setTelemetry(&timings);
+
+    mixer.addDeck(slot, deck->player.get());
+    sendChangeMessage();
+    return true;
+}
+
+bool DeckManager::removeLastDeck()
+{
+    if (decks.size() <= minDecks)
+    {
+        DBG("DeckManager::removeLastDeck keeping at least " << minDecks << " decks");
+        return false;
+    }
+    destroyDeck(decks.size() - 1);
+    sendChangeMessage();
+    return true;
+}
+
+int DeckManager::getNumDecks() const
+{
+    return decks.size();
+}
+
+DeckGUI* DeckManager::getDeckGUI(int index) const
+{
+    if (auto* deck = decks[index])
+    {
+        return deck->gui.get();
+    }
+    return nullptr;
+}
+
+DeckGUI* DeckManager::findDeckGUI(int deckNumber) const
+{
+    for (auto* deck : decks)
+    {
+        if (deck->slot + 1 == deckNumber)
+        {
+            return deck->gui.get();
+        }
+    }
+    return nullptr;
+}
+
+int DeckManager::getDeckNumber(int index) const
+{
+    if (auto* deck = decks[index])
+    {
+        return deck->slot + 1;
+    }
+    return 0;
+}
+
+void DeckManager::destroyDeck(int index)
+{
+    std::unique_ptr<Deck> deck(decks.removeAndReturn(index));
+    // once this returns the audio thread has let go of the player
+    mixer.removeDeck(deck->slot);
+    // the GUI's timer polls the player, so it goes first
+    deck->gui.reset();
+    deck->player.reset();
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "DJAudioPlayer.h"
+#include "DeckGUI.h"
+#include "DeckMixer.h"
+#include "AudioTelemetry.h"
+#include "DecodeCache.h"
+#include "PreloadCache.h"
+#include "ReadAheadPool.h"
+#include "SyncEngine.h"
+
+//==============================================================================
+/*
+    Creates and destroys the player and GUI of each deck at runtime, and plugs
+    the players into the mixer. Every deck takes a mixer slot, and its number
+    on screen is its slot plus one. The slot also picks the deck's timings in
+    the telemetry.
+
+    Message thread only. Listeners get a change message after every add or
+    remove, e.g. to lay the decks out again.
+*/
+class DeckManager  : public juce::ChangeBroadcaster
+{
+public:
+    static constexpr int minDecks = 2;
+    static constexpr int maxDecks = DeckMixer::maxDecks;
+
+    DeckManager(DeckMixer& _mixer,
+                AudioTelemetry& _telemetry,
+                ReadAheadPool& _readAheadPool,
+                DecodeCache& _decodeCache,
+                PreloadCache& _preloadCache,
+                SyncEngine& _syncEngine,
+                juce::AudioFormatManager& _formatManager,
+                juce::AudioThumbnailCache& _thumbCache);
+    ~DeckManager() override;
+
+    /**Adds a deck in the lowest free slot, returns false when all are taken*/
+    bool addDeck();
+    /**Removes the highest numbered deck, keeping at least minDecks*/
+    bool removeLastDeck();
+    int getNumDecks() const;
+    /**Decks in slot order*/
+    DeckGUI* getDeckGUI(int index) const;
+    /**The deck shown as "Deck n", or nullptr*/
+    DeckGUI* findDeckGUI(int deckNumber) const;
+    int getDeckNumber(int index) const;
+
+private:
+    struct Deck
+    {
+        int slot;
+        std::unique_ptr<DJAudioPlayer> player;
+        std::unique_ptr<DeckGUI> gui;
+    };
+
+    DeckMixer& mixer;
+    AudioTelemetry& telemetry;
+    ReadAheadPool& readAheadPool;
+    DecodeCache& decodeCache;
+    PreloadCache& preloadCache;
+    SyncEngine& syncEngine;
+    juce::AudioFormatManager& formatManager;
+    juce::AudioThumbnailCache& thumbCache;
+    juce::OwnedArray<Deck> decks;
+
+    void destroyDeck(int index);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DeckManager)
+};
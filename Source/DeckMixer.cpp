@@ -0,0 +1,165 @@
+#include <JuceHeader.h>
+#include "DeckMixer.h"
+
+//==============================================================================
+DeckMixer::DeckMixer()
+{
+    for (auto& slot : slots)
+    {
+        slot.store(nullptr);
+    }
+}
+
+DeckMixer::~DeckMixer()
+{
+}
+
+void DeckMixer::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    const juce::ScopedLock sl(prepareLock);
+    blockSize = samplesPerBlockExpected;
+    currentSampleRate = sampleRate;
+    for (auto& buffer : deckBuffers)
+    {
+        buffer.setSize(2, samplesPerBlockExpected);
+    }
+
+    for (auto& slot : slots)
+    {
+        if (auto* deck = slot.load())
+        {
+            deck->prepareToPlay(samplesPerBlockExpected, sampleRate);
+        }
+    }
+    isPrepared = true;
+}
+
+void DeckMixer::releaseResources()
+{
+    const juce::ScopedLock sl(prepareLock);
+    for (auto& slot : slots)
+    {
+        if (auto* deck = slot.load())
+        {
+            deck->releaseResources();
+        }
+    }
+    for (auto& buffer : deckBuffers)
+    {
+        buffer.setSize(2, 0);
+    }
+    isPrepared = false;
+}
+
+void DeckMixer::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    // seq_cst like removeDeck's exchange and epoch load, so either it sees this callback
+    // running or this callback sees the slot it cleared
+    callbackEpoch.fetch_add(1);
+    bufferToFill.clearActiveBufferRegion();
+
+    juce::uint32 deckMask = 0;
+    for (int slot = 0; slot < maxDecks; ++slot)
+    {
+        if (auto* deck = slots[slot].load())
+        {
+            chunkDecks[slot] = deck;
+            deckMask |= 1u << slot;
+        }
+    }
+
+    // the device may hand us more than it promised, so render in prepared-size chunks
+    auto numChannels = juce::jmin(bufferToFill.buffer->getNumChannels(), deckBuffers[0].getNumChannels());
+    for (int done = 0; deckMask != 0 && done < bufferToFill.numSamples;)
+    {
+        chunkSamples = juce::jmin(deckBuffers[0].getNumSamples(), bufferToFill.numSamples - done);
+        if (chunkSamples <= 0)
+        {
+            break;
+        }
+
+        if (auto* engine = syncEngine.load(std::memory_order_acquire))
+        {
+            engine->beginChunk(chunkSamples);
+        }
+        auto deadline = realtime.load() ? renderBudget * chunkSamples / currentSampleRate : 0.0;
+        renderPool.render(*this, deckMask, deadline);
+        for (int deck = 0; deck < maxDecks; ++deck)
+        {
+            if ((deckMask & (1u << deck)) == 0)
+            {
+                continue;
+            }
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                bufferToFill.buffer->addFrom(channel, bufferToFill.startSample + done,
+                                             deckBuffers[deck], channel, 0, chunkSamples);
+            }
+        }
+        done += chunkSamples;
+    }
+
+    callbackEpoch.fetch_add(1);
+}
+
+void DeckMixer::renderJob(int jobIndex)
+{
+    chunkDecks[jobIndex]->getNextAudioBlock(juce::AudioSourceChannelInfo(&deckBuffers[jobIndex], 0, chunkSamples));
+}
+
+void DeckMixer::addDeck(int slot, juce::AudioSource* deck)
+{
+    jassert(juce::isPositiveAndBelow(slot, maxDecks) && isSlotFree(slot));
+    const juce::ScopedLock sl(prepareLock);
+    if (isPrepared)
+    {
+        deck->prepareToPlay(blockSize, currentSampleRate);
+    }
+    slots[slot].store(deck, std::memory_order_release);
+}
+
+void DeckMixer::removeDeck(int slot)
+{
+    jassert(juce::isPositiveAndBelow(slot, maxDecks));
+    const juce::ScopedLock sl(prepareLock);
+    auto* deck = slots[slot].exchange(nullptr);
+    if (deck == nullptr)
+    {
+        return;
+    }
+
+    // a callback that started before the exchange may still hold the pointer; its jobs end with it
+    auto epoch = callbackEpoch.load();
+    if ((epoch & 1) != 0)
+    {
+        while (callbackEpoch.load() == epoch)
+        {
+            juce::Thread::yield();
+        }
+    }
+
+    if (isPrepared)
+    {
+        deck->releaseResources();
+    }
+}
+
+bool DeckMixer::isSlotFree(int slot) const
+{
+    return slots[slot].load() == nullptr;
+}
+
+void DeckMixer::setRealtime(bool isRealtime)
+{
+    realtime.store(isRealtime);
+}
+
+void DeckMixer::setSyncEngine(SyncEngine* engine)
+{
+    syncEngine.store(engine);
+}
+
+DeckRenderPool::Stats DeckMixer::getRenderStats() const
+{
+    return renderPool.getStats();
+}
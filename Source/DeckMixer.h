@@ -0,0 +1,77 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "DeckRenderPool.h"
+#include "SyncEngine.h"
+
+//==============================================================================
+/*
+    Sums a fixed number of deck slots, replacing juce::MixerAudioSource for the
+    decks. Each slot is one atomic pointer, so the audio thread walks the slots
+    without locks, and adding a deck is a single store.
+
+    Removing a deck clears its slot and then waits for the audio callback that
+    might still be rendering it to finish. Every callback bumps an epoch
+    counter on the way in and out, so the remover only waits when a callback
+    is actually in flight.
+
+    The decks of a block are rendered in parallel on a DeckRenderPool, one job
+    per slot into the slot's own buffer, and summed in slot order afterwards.
+    Every deck is in every block: one that misses the pool's deadline is
+    waited for, and the pool goes serial for the blocks after it.
+*/
+class DeckMixer  : public juce::AudioSource,
+                   private DeckRenderPool::Client
+{
+public:
+    static constexpr int maxDecks = 8;
+    static_assert(maxDecks <= DeckRenderPool::maxJobs, "one render job per slot");
+
+    DeckMixer();
+    ~DeckMixer() override;
+
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+    void releaseResources() override;
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+    /**Message thread: prepares the deck if the device is running and starts mixing it in*/
+    void addDeck(int slot, juce::AudioSource* deck);
+    /**Message thread: stops mixing the deck in. When this returns the audio thread
+    *  no longer uses it, so it can be deleted*/
+    void removeDeck(int slot);
+    bool isSlotFree(int slot) const;
+    /**Offline rendering waits as long as the decks take, with no deadline, so the pool never
+    *  falls back to serial and the timing of one render doesn't change the next*/
+    void setRealtime(bool isRealtime);
+    /**Moves this clock on before every chunk the decks render, or none with nullptr*/
+    void setSyncEngine(SyncEngine* engine);
+    /**Per-thread timings of the deck rendering*/
+    DeckRenderPool::Stats getRenderStats() const;
+
+private:
+    void renderJob(int jobIndex) override;
+
+    // share of a block's duration the decks may take before rendering falls back to serial
+    static constexpr double renderBudget = 0.5;
+
+    std::atomic<juce::AudioSource*> slots[maxDecks];
+    std::atomic<SyncEngine*> syncEngine{ nullptr };
+    std::atomic<bool> realtime{ true };
+    // odd while a callback is running
+    std::atomic<juce::uint32> callbackEpoch{ 0 };
+
+    // held while preparing or releasing, never by the audio callback
+    juce::CriticalSection prepareLock;
+    bool isPrepared{ false };
+    int blockSize{ 0 };
+    double currentSampleRate{ 0 };
+    juce::AudioBuffer<float> deckBuffers[maxDecks];
+
+    // audio thread: the decks being rendered this chunk, slot i's into deckBuffers[i]
+    juce::AudioSource* chunkDecks[maxDecks] = {};
+    int chunkSamples{ 0 };
+
+    DeckRenderPool renderPool{ juce::jmin(maxDecks - 1, juce::SystemStats::getNumCpus() - 1) };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DeckMixer)
+};
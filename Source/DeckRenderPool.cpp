@@ -0,0 +1,355 @@
+#include <JuceHeader.h>
+#include "DeckRenderPool.h"
+
+#if JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#elif JUCE_MAC || JUCE_IOS
+ #include <dispatch/dispatch.h>
+ #include <mach/mach.h>
+ #include <mach/mach_time.h>
+ #include <mach/thread_policy.h>
+ #include <pthread.h>
+#else
+ #include <semaphore.h>
+ #include <cerrno>
+ #include <ctime>
+#endif
+
+namespace
+{
+    /**Gives the calling thread the scheduling audio callbacks get, beyond what a JUCE priority
+    *  maps to: Mach's time-constraint policy on Apple systems, time-critical on Windows. On Linux
+    *  realtimeAudioPriority already asks for SCHED_RR*/
+    void makeCurrentThreadRealtime()
+    {
+       #if JUCE_WINDOWS
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+       #elif JUCE_MAC || JUCE_IOS
+        mach_timebase_info_data_t timebase;
+        mach_timebase_info(&timebase);
+        auto toMachTime = [&timebase](double seconds)
+        {
+            return (uint32_t) (seconds * 1.0e9 * timebase.denom / timebase.numer);
+        };
+        // not periodic, as a job comes whenever a block does; up to 1ms of work due within 3ms,
+        // about the length of a 128-sample block
+        thread_time_constraint_policy_data_t policy;
+        policy.period = 0;
+        policy.computation = toMachTime(0.001);
+        policy.constraint = toMachTime(0.003);
+        policy.preemptible = 1;
+        thread_policy_set(pthread_mach_thread_np(pthread_self()), THREAD_TIME_CONSTRAINT_POLICY,
+                          (thread_policy_t) &policy, THREAD_TIME_CONSTRAINT_POLICY_COUNT);
+       #endif
+    }
+
+    /**The OS's counting semaphore, whose post doesn't take a lock the way
+    *  juce::WaitableEvent::signal does, so the audio thread can post to it*/
+    class WakeSemaphore
+    {
+    public:
+        WakeSemaphore()
+        {
+           #if JUCE_WINDOWS
+            handle = CreateSemaphoreW(nullptr, 0, 0x7fffffff, nullptr);
+           #elif JUCE_MAC || JUCE_IOS
+            handle = dispatch_semaphore_create(0);
+           #else
+            sem_init(&handle, 0, 0);
+           #endif
+        }
+
+        ~WakeSemaphore()
+        {
+           #if JUCE_WINDOWS
+            CloseHandle(handle);
+           #elif JUCE_MAC || JUCE_IOS
+            dispatch_release(handle);
+           #else
+            sem_destroy(&handle);
+           #endif
+        }
+
+        void post()
+        {
+           #if JUCE_WINDOWS
+            ReleaseSemaphore(handle, 1, nullptr);
+           #elif JUCE_MAC || JUCE_IOS
+            dispatch_semaphore_signal(handle);
+           #else
+            sem_post(&handle);
+           #endif
+        }
+
+        /**False if it timed out*/
+        bool wait(int timeoutMs)
+        {
+           #if JUCE_WINDOWS
+            return WaitForSingleObject(handle, (DWORD) timeoutMs) == WAIT_OBJECT_0;
+           #elif JUCE_MAC || JUCE_IOS
+            return dispatch_semaphore_wait(handle, dispatch_time(DISPATCH_TIME_NOW, (int64_t) timeoutMs * 1000000)) == 0;
+           #else
+            timespec until;
+            clock_gettime(CLOCK_REALTIME, &until);
+            until.tv_sec += timeoutMs / 1000;
+            until.tv_nsec += (timeoutMs % 1000) * 1000000L;
+            if (until.tv_nsec >= 1000000000L)
+            {
+                ++until.tv_sec;
+                until.tv_nsec -= 1000000000L;
+            }
+            while (sem_timedwait(&handle, &until) != 0)
+            {
+                if (errno != EINTR)
+                {
+                    return false;
+                }
+            }
+            return true;
+           #endif
+        }
+
+    private:
+       #if JUCE_WINDOWS
+        HANDLE handle;
+       #elif JUCE_MAC || JUCE_IOS
+        dispatch_semaphore_t handle;
+       #else
+        sem_t handle;
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE (WakeSemaphore)
+    };
+}
+
+//==============================================================================
+class DeckRenderPool::Worker  : public juce::Thread
+{
+public:
+    Worker(DeckRenderPool& _pool,
+           TimingCounters& _timing,
+           int index
+          ) : juce::Thread("Deck render " + juce::String(index)),
+              pool(_pool),
+              timing(_timing)
+    {
+    }
+
+    void run() override
+    {
+        makeCurrentThreadRealtime();
+        while (!threadShouldExit())
+        {
+            pool.runJobs(timing);
+
+            // flag the sleep before the last look for work: the audio thread posts jobs before
+            // reading the flag, so either this sees the jobs or the audio thread sees the flag
+            sleeping.store(true);
+            if (pool.hasPendingJobs() && sleeping.exchange(false))
+            {
+                continue;
+            }
+            // a post that lands after a timeout only makes the next wait return at once
+            wakeSemaphore.wait(100);
+        }
+    }
+
+    /**Audio thread: lock-free, and only posts if the worker is parked*/
+    void wake()
+    {
+        if (sleeping.exchange(false))
+        {
+            wakeSemaphore.post();
+        }
+    }
+
+    void interrupt()
+    {
+        wakeSemaphore.post();
+    }
+
+private:
+    DeckRenderPool& pool;
+    TimingCounters& timing;
+    std::atomic<bool> sleeping{ false };
+    WakeSemaphore wakeSemaphore;
+};
+
+//==============================================================================
+DeckRenderPool::DeckRenderPool(int numWorkers)
+{
+    timings.add(new TimingCounters());
+    for (int i = 0; i < juce::jmax(0, numWorkers); ++i)
+    {
+        auto* worker = workers.add(new Worker(*this, *timings.add(new TimingCounters()), i + 1));
+        // a real-time thread, as the audio thread is, so the audio thread isn't left waiting on a deck
+        // that was preempted by the GUI; run() raises it to the audio scheduling class where there is one
+        worker->startThread(juce::Thread::realtimeAudioPriority);
+    }
+}
+
+DeckRenderPool::~DeckRenderPool()
+{
+    for (auto* worker : workers)
+    {
+        worker->signalThreadShouldExit();
+        worker->interrupt();
+    }
+    for (auto* worker : workers)
+    {
+        worker->stopThread(2000);
+    }
+}
+
+void DeckRenderPool::render(Client& client, juce::uint32 jobMask, double deadlineSeconds)
+{
+    auto startTicks = juce::Time::getHighResolutionTicks();
+    auto hasDeadline = deadlineSeconds > 0;
+    auto deadlineTicks = startTicks + juce::Time::secondsToHighResolutionTicks(deadlineSeconds);
+    auto numJobs = juce::countNumberOfBits(jobMask);
+
+    if (numJobs < 2 || workers.isEmpty() || serialBlocksLeft > 0)
+    {
+        serialBlocksLeft = juce::jmax(0, serialBlocksLeft - 1);
+        runSerially(client, jobMask);
+        ++serialBlocks;
+        return;
+    }
+
+    // set the client before marking the job pending, which releases it to the workers
+    for (int job = 0; job < maxJobs; ++job)
+    {
+        if ((jobMask & (1u << job)) != 0)
+        {
+            jobs[job].client.store(&client);
+            jobs[job].state.store(jobPending);
+        }
+    }
+    for (int i = 0; i < juce::jmin(workers.size(), numJobs - 1); ++i)
+    {
+        workers.getUnchecked(i)->wake();
+    }
+
+    // takes whatever the workers haven't, so after this only jobs already started remain
+    runJobs(*timings.getUnchecked(0));
+
+    // the worker holds the deck's state mid-block, so the only way to get its audio is to wait;
+    // a late block is better than a deck missing from it
+    auto wasLate = false;
+    for (;;)
+    {
+        auto running = getRunningJobs() & jobMask;
+        if (running == 0)
+        {
+            break;
+        }
+        if (hasDeadline && !wasLate && juce::Time::getHighResolutionTicks() > deadlineTicks)
+        {
+            lateJobs += juce::countNumberOfBits(running);
+            wasLate = true;
+        }
+        juce::Thread::yield();
+    }
+    ++parallelBlocks;
+
+    if (hasDeadline && (wasLate || juce::Time::getHighResolutionTicks() > deadlineTicks))
+    {
+        ++deadlineMisses;
+        serialBlocksLeft = serialFallbackBlocks;
+    }
+}
+
+int DeckRenderPool::getNumWorkers() const
+{
+    return workers.size();
+}
+
+DeckRenderPool::Stats DeckRenderPool::getStats() const
+{
+    Stats stats;
+    for (auto* timing : timings)
+    {
+        ThreadTiming threadTiming;
+        threadTiming.numJobs = timing->numJobs.load();
+        threadTiming.busySeconds = juce::Time::highResolutionTicksToSeconds(timing->busyTicks.load());
+        threadTiming.longestJobSeconds = juce::Time::highResolutionTicksToSeconds(timing->longestJobTicks.load());
+        stats.threads.add(threadTiming);
+    }
+    stats.parallelBlocks = parallelBlocks.load();
+    stats.serialBlocks = serialBlocks.load();
+    stats.deadlineMisses = deadlineMisses.load();
+    stats.lateJobs = lateJobs.load();
+    return stats;
+}
+
+void DeckRenderPool::runJobs(TimingCounters& timing)
+{
+    for (int job = 0; job < maxJobs; ++job)
+    {
+        // claiming is starting: a job is never held by a thread that isn't rendering it
+        int expected = jobPending;
+        if (!jobs[job].state.compare_exchange_strong(expected, jobRunning))
+        {
+            continue;
+        }
+
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        jobs[job].client.load()->renderJob(job);
+        recordJob(timing, startTicks);
+        jobs[job].state.store(jobIdle);
+    }
+}
+
+bool DeckRenderPool::hasPendingJobs() const
+{
+    for (auto& job : jobs)
+    {
+        if (job.state.load() == jobPending)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+juce::uint32 DeckRenderPool::getRunningJobs() const
+{
+    juce::uint32 running = 0;
+    for (int job = 0; job < maxJobs; ++job)
+    {
+        if (jobs[job].state.load() == jobRunning)
+        {
+            running |= 1u << job;
+        }
+    }
+    return running;
+}
+
+void DeckRenderPool::runSerially(Client& client, juce::uint32 jobMask)
+{
+    auto& timing = *timings.getUnchecked(0);
+    for (int job = 0; job < maxJobs; ++job)
+    {
+        if ((jobMask & (1u << job)) != 0)
+        {
+            auto startTicks = juce::Time::getHighResolutionTicks();
+            client.renderJob(job);
+            recordJob(timing, startTicks);
+        }
+    }
+}
+
+void DeckRenderPool::recordJob(TimingCounters& timing, juce::int64 startTicks)
+{
+    auto ticks = juce::Time::getHighResolutionTicks() - startTicks;
+    // only this thread writes its own counters
+    timing.numJobs.store(timing.numJobs.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    timing.busyTicks.store(timing.busyTicks.load(std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+    if (ticks > timing.longestJobTicks.load(std::memory_order_relaxed))
+    {
+        timing.longestJobTicks.store(ticks, std::memory_order_relaxed);
+    }
+}
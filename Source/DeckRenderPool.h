@@ -0,0 +1,113 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Real-time worker threads that render the decks of one audio block in
+    parallel. The audio thread posts a block's jobs, wakes the workers and
+    then works through the jobs alongside them; each job is claimed with one
+    compare-and-swap, so whichever thread is free takes the next deck, and
+    the audio thread ends up taking every job nobody else has started.
+
+    Waking never takes a lock: a worker flags itself asleep before parking
+    on an OS semaphore, and the audio thread only posts to the ones it finds
+    flagged.
+
+    The workers run at the OS's real-time audio priority. The audio thread
+    always waits for every job of the block, so no deck is ever left out of
+    it. A job still running at the deadline it was given, e.g. because its
+    worker was preempted, is waited for in place and counted as late, and
+    the pool then renders serially on the audio thread for a while before
+    trying the workers again.
+*/
+class DeckRenderPool
+{
+public:
+    /**Something with jobs to run once per block, e.g. one job per deck*/
+    class Client
+    {
+    public:
+        virtual ~Client() = default;
+        /**Called from the audio thread or a worker, never twice at once for one index*/
+        virtual void renderJob(int jobIndex) = 0;
+    };
+
+    /**Timing for one thread, the audio thread being thread 0*/
+    struct ThreadTiming
+    {
+        juce::int64 numJobs = 0;
+        double busySeconds = 0;
+        double longestJobSeconds = 0;
+    };
+
+    struct Stats
+    {
+        juce::Array<ThreadTiming> threads;
+        juce::int64 parallelBlocks = 0;
+        juce::int64 serialBlocks = 0;
+        juce::int64 deadlineMisses = 0;
+        juce::int64 lateJobs = 0;
+    };
+
+    static constexpr int maxJobs = 32;
+
+    /**numWorkers defaults to one per core besides the audio thread's*/
+    DeckRenderPool(int numWorkers = juce::SystemStats::getNumCpus() - 1);
+    ~DeckRenderPool();
+
+    /**Audio thread: runs the jobs whose bits are set in jobMask and returns once all of them
+    *  are done. Taking longer than deadlineSeconds makes the next blocks render serially;
+    *  0 is no deadline, e.g. when rendering offline*/
+    void render(Client& client, juce::uint32 jobMask, double deadlineSeconds);
+    int getNumWorkers() const;
+    /**Any thread: a snapshot of the counters so far*/
+    Stats getStats() const;
+
+private:
+    class Worker;
+
+    enum JobState
+    {
+        jobIdle,
+        jobPending,
+        jobRunning
+    };
+
+    struct Job
+    {
+        // only written while the job is idle
+        std::atomic<Client*> client{ nullptr };
+        std::atomic<int> state{ jobIdle };
+    };
+
+    struct TimingCounters
+    {
+        std::atomic<juce::int64> numJobs{ 0 };
+        std::atomic<juce::int64> busyTicks{ 0 };
+        std::atomic<juce::int64> longestJobTicks{ 0 };
+    };
+
+    /**Claims and runs the pending jobs nobody else has started*/
+    void runJobs(TimingCounters& timing);
+    bool hasPendingJobs() const;
+    juce::uint32 getRunningJobs() const;
+    void runSerially(Client& client, juce::uint32 jobMask);
+    void recordJob(TimingCounters& timing, juce::int64 startTicks);
+
+    // how many blocks to stay serial after a missed deadline, about a second at 256 samples
+    static constexpr int serialFallbackBlocks = 200;
+
+    juce::OwnedArray<Worker> workers;
+    juce::OwnedArray<TimingCounters> timings;
+
+    Job jobs[maxJobs];
+    int serialBlocksLeft{ 0 };
+
+    std::atomic<juce::int64> parallelBlocks{ 0 };
+    std::atomic<juce::int64> serialBlocks{ 0 };
+    std::atomic<juce::int64> deadlineMisses{ 0 };
+    std::atomic<juce::int64> lateJobs{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DeckRenderPool)
+};
@@ -0,0 +1,327 @@
+#include <JuceHeader.h>
+#include "DeckResampler.h"
+#include "SimdOps.h"
+
+namespace
+{
+    // input samples kept before the read position, and needed after it, by the widest kernel
+    constexpr int historySize = 8;
+    constexpr int lookAhead = 9;
+
+    constexpr int numTaps = 16;
+    constexpr int numPhases = 256;
+    // one kernel per quarter-octave of ratio, so speeding up never aliases badly
+    constexpr int numBands = 17;
+
+    /**Blackman-windowed sinc kernels, one table per anti-aliasing cutoff*/
+    struct SincTables
+    {
+        SincTables()
+        {
+            coefficients.resize((size_t) (numBands * (numPhases + 1) * numTaps));
+
+            for (int band = 0; band < numBands; ++band)
+            {
+                auto cutoff = 0.92 / std::pow(2.0, band / 4.0);
+
+                for (int phase = 0; phase <= numPhases; ++phase)
+                {
+                    auto frac = (double) phase / numPhases;
+                    auto* row = getRow(band, phase);
+                    double total = 0;
+
+                    for (int tap = 0; tap < numTaps; ++tap)
+                    {
+                        auto t = (tap - (historySize - 1)) - frac;
+                        auto x = t / historySize;
+                        auto window = std::abs(x) >= 1.0 ? 0.0
+                                    : 0.42 + 0.5 * std::cos(juce::MathConstants<double>::pi * x)
+                                           + 0.08 * std::cos(2.0 * juce::MathConstants<double>::pi * x);
+                        auto arg = juce::MathConstants<double>::pi * cutoff * t;
+                        auto sinc = std::abs(arg) < 1.0e-9 ? 1.0 : std::sin(arg) / arg;
+                        row[tap] = (float) (cutoff * sinc * window);
+                        total += row[tap];
+                    }
+
+                    // unity gain at DC
+                    for (int tap = 0; tap < numTaps; ++tap)
+                    {
+                        row[tap] = (float) (row[tap] / total);
+                    }
+                }
+            }
+        }
+
+        float* getRow(int band, int phase)
+        {
+            return coefficients.data() + ((size_t) band * (numPhases + 1) + (size_t) phase) * numTaps;
+        }
+
+        const float* getRow(int band, int phase) const
+        {
+            return coefficients.data() + ((size_t) band * (numPhases + 1) + (size_t) phase) * numTaps;
+        }
+
+        static int getBandForRatio(double ratio)
+        {
+            if (ratio <= 1.0)
+            {
+                return 0;
+            }
+            return juce::jmin(numBands - 1, (int) std::floor(4.0 * std::log2(ratio)));
+        }
+
+        std::vector<float> coefficients;
+    };
+
+    const SincTables& getSincTables()
+    {
+        static const SincTables tables;
+        return tables;
+    }
+}
+
+//==============================================================================
+DeckResampler::DeckResampler(juce::AudioSource* inputSource,
+                             int _numChannels
+                            ) : input(inputSource),
+                                numChannels(_numChannels)
+{
+}
+
+DeckResampler::~DeckResampler()
+{
+}
+
+void DeckResampler::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    // build the kernels here rather than on the first audio callback
+    getSincTables();
+
+    maxBlockSize = samplesPerBlockExpected;
+    auto capacity = historySize + 1 + (int) std::ceil(maxBlockSize * maxRatio) + lookAhead + 1;
+    inputBuffer.setSize(numChannels, capacity);
+
+    input->prepareToPlay(samplesPerBlockExpected, sampleRate);
+    flushBuffers();
+}
+
+void DeckResampler::releaseResources()
+{
+    input->releaseResources();
+    inputBuffer.setSize(numChannels, 0);
+    maxBlockSize = 0;
+}
+
+void DeckResampler::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    if (maxBlockSize <= 0)
+    {
+        bufferToFill.clearActiveBufferRegion();
+        return;
+    }
+
+    // the device may hand us more than it promised, so work in prepared-size chunks
+    auto rampStart = lastRatio;
+    auto rampLength = (double) bufferToFill.numSamples;
+    for (int done = 0; done < bufferToFill.numSamples;)
+    {
+        auto numThisTime = juce::jmin(maxBlockSize, bufferToFill.numSamples - done);
+        auto startRatio = rampStart + (ratio - rampStart) * (done / rampLength);
+        auto endRatio = rampStart + (ratio - rampStart) * ((done + numThisTime) / rampLength);
+
+        processChunk(juce::AudioSourceChannelInfo(bufferToFill.buffer, bufferToFill.startSample + done, numThisTime),
+                     startRatio, endRatio);
+        done += numThisTime;
+    }
+    lastRatio = ratio;
+}
+
+void DeckResampler::setResamplingRatio(double newRatio)
+{
+    ratio = juce::jlimit(1.0 / maxRatio, maxRatio, newRatio);
+}
+
+void DeckResampler::setQuality(Quality newQuality)
+{
+    quality.store((int) newQuality);
+}
+
+DeckResampler::Quality DeckResampler::getQuality() const
+{
+    return (Quality) quality.load();
+}
+
+void DeckResampler::flushBuffers()
+{
+    inputBuffer.clear();
+    // start with silent history so the first kernel has something to look back at
+    numBuffered = historySize;
+    readPos = historySize;
+    lastRatio = ratio;
+}
+
+bool DeckResampler::isResampling() const
+{
+    return ratio != 1.0 || lastRatio != 1.0;
+}
+
+double DeckResampler::getLatency() const
+{
+    // the samples before readPos are only history for the kernel, they have been played
+    return juce::jmax(0.0, numBuffered - readPos);
+}
+
+void DeckResampler::processChunk(const juce::AudioSourceChannelInfo& bufferToFill, double startRatio, double endRatio)
+{
+    if (startRatio == 1.0 && endRatio == 1.0)
+    {
+        copyChunk(bufferToFill);
+        return;
+    }
+
+    auto numOut = bufferToFill.numSamples;
+    auto step = (endRatio - startRatio) / numOut;
+
+    // pull just enough input to cover the last output sample's kernel
+    auto lastPosition = readPos + juce::jmax(startRatio, endRatio) * numOut;
+    auto numNeeded = (int) std::floor(lastPosition) + lookAhead + 1;
+    if (numNeeded > numBuffered)
+    {
+        fillInput(numNeeded - numBuffered);
+    }
+
+    auto numOutChannels = juce::jmin(bufferToFill.buffer->getNumChannels(), numChannels);
+    auto currentQuality = (Quality) quality.load();
+    auto band = SincTables::getBandForRatio(juce::jmax(startRatio, endRatio));
+    auto& tables = getSincTables();
+
+    auto pos = readPos;
+    auto currentRatio = startRatio;
+    for (int i = 0; i < numOut; ++i)
+    {
+        auto index = (int) pos;
+        auto frac = (float) (pos - index);
+
+        if (currentQuality == Quality::sinc)
+        {
+            // blend the two nearest phases so the kernel moves smoothly with frac
+            auto phasePos = frac * numPhases;
+            auto phase = juce::jmin(numPhases - 1, (int) phasePos);
+            auto blend = SimdOps::broadcast(phasePos - phase);
+            auto* rowA = tables.getRow(band, phase);
+            auto* rowB = tables.getRow(band, phase + 1);
+
+            float kernel[numTaps];
+            for (int tap = 0; tap < numTaps; tap += 4)
+            {
+                auto a = SimdOps::load(rowA + tap);
+                auto b = SimdOps::load(rowB + tap);
+                SimdOps::store(kernel + tap, SimdOps::mulAdd(a, SimdOps::sub(b, a), blend));
+            }
+
+            for (int channel = 0; channel < numOutChannels; ++channel)
+            {
+                auto* samples = inputBuffer.getReadPointer(channel, index - (historySize - 1));
+                bufferToFill.buffer->setSample(channel, bufferToFill.startSample + i,
+                                               interpolateSinc(samples, kernel));
+            }
+        }
+        else
+        {
+            for (int channel = 0; channel < numOutChannels; ++channel)
+            {
+                auto* samples = inputBuffer.getReadPointer(channel);
+                auto value = currentQuality == Quality::cubic ? interpolateCubic(samples + index - 1, frac)
+                                                              : interpolateLinear(samples + index, frac);
+                bufferToFill.buffer->setSample(channel, bufferToFill.startSample + i, value);
+            }
+        }
+
+        currentRatio += step;
+        pos += currentRatio;
+    }
+
+    for (int channel = numOutChannels; channel < bufferToFill.buffer->getNumChannels(); ++channel)
+    {
+        bufferToFill.buffer->clear(channel, bufferToFill.startSample, numOut);
+    }
+
+    discardConsumed(pos);
+}
+
+void DeckResampler::copyChunk(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    auto numOut = bufferToFill.numSamples;
+    // after a ramp back to 1 the read position can sit between samples; snapping moves it
+    // by under half a sample, once, rather than interpolating every block from then on
+    auto index = (int) std::lround(readPos);
+    auto numNeeded = index + numOut + lookAhead;
+    if (numNeeded > numBuffered)
+    {
+        fillInput(numNeeded - numBuffered);
+    }
+
+    auto numOutChannels = juce::jmin(bufferToFill.buffer->getNumChannels(), numChannels);
+    for (int channel = 0; channel < numOutChannels; ++channel)
+    {
+        bufferToFill.buffer->copyFrom(channel, bufferToFill.startSample, inputBuffer, channel, index, numOut);
+    }
+    for (int channel = numOutChannels; channel < bufferToFill.buffer->getNumChannels(); ++channel)
+    {
+        bufferToFill.buffer->clear(channel, bufferToFill.startSample, numOut);
+    }
+
+    discardConsumed(index + numOut);
+}
+
+void DeckResampler::discardConsumed(double pos)
+{
+    auto consumed = (int) pos - historySize;
+    if (consumed > 0)
+    {
+        auto remaining = numBuffered - consumed;
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* data = inputBuffer.getWritePointer(channel);
+            std::memmove(data, data + consumed, (size_t) remaining * sizeof(float));
+        }
+        numBuffered = remaining;
+        pos -= consumed;
+    }
+    readPos = pos;
+}
+
+void DeckResampler::fillInput(int numNeeded)
+{
+    input->getNextAudioBlock(juce::AudioSourceChannelInfo(&inputBuffer, numBuffered, numNeeded));
+    numBuffered += numNeeded;
+}
+
+float DeckResampler::interpolateLinear(const float* samples, float frac) const
+{
+    return samples[0] + frac * (samples[1] - samples[0]);
+}
+
+// Catmull-Rom through samples[0..3], frac between samples[1] and samples[2]
+float DeckResampler::interpolateCubic(const float* samples, float frac) const
+{
+    auto y0 = samples[0];
+    auto y1 = samples[1];
+    auto y2 = samples[2];
+    auto y3 = samples[3];
+    auto c1 = 0.5f * (y2 - y0);
+    auto c2 = y0 - 2.5f * y1 + 2.0f * y2 - 0.5f * y3;
+    auto c3 = 0.5f * (y3 - y0) + 1.5f * (y1 - y2);
+    return ((c3 * frac + c2) * frac + c1) * frac + y1;
+}
+
+float DeckResampler::interpolateSinc(const float* samples, const float* kernel) const
+{
+    auto acc = SimdOps::mul(SimdOps::load(samples), SimdOps::load(kernel));
+    for (int tap = 4; tap < numTaps; tap += 4)
+    {
+        acc = SimdOps::mulAdd(acc, SimdOps::load(samples + tap), SimdOps::load(kernel + tap));
+    }
+    return SimdOps::sum(acc);
+}
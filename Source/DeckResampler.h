@@ -0,0 +1,73 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Single-stage resampler for a deck. The track-to-device rate conversion and
+    the speed change are folded into one ratio, so each output sample is
+    interpolated once instead of twice.
+
+    The ratio is the number of input samples consumed per output sample. A new
+    ratio is reached with a per-sample ramp over the following block. At a
+    steady ratio of exactly 1 the input is copied through untouched.
+*/
+class DeckResampler  : public juce::AudioSource
+{
+public:
+    enum class Quality
+    {
+        linear = 1,
+        cubic,
+        sinc
+    };
+
+    DeckResampler(juce::AudioSource* inputSource, int numChannels = 2);
+    ~DeckResampler() override;
+
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+    void releaseResources() override;
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+    /**Audio thread: sets the ratio reached by the end of the next block*/
+    void setResamplingRatio(double ratio);
+    /**Can be called from any thread, takes effect on the next block*/
+    void setQuality(Quality newQuality);
+    Quality getQuality() const;
+    /**Audio thread: forgets buffered input, e.g. when the track changes*/
+    void flushBuffers();
+    /**Audio thread: false while the input is being copied straight through*/
+    bool isResampling() const;
+    /**Audio thread: how many input samples have been read past the next output sample's position*/
+    double getLatency() const;
+
+    /**Highest ratio handled, e.g. 4x speed on a 192k file played at 48k*/
+    static constexpr double maxRatio = 16.0;
+
+private:
+    /**Renders at most one prepared block worth of output*/
+    void processChunk(const juce::AudioSourceChannelInfo& bufferToFill, double startRatio, double endRatio);
+    /**The ratio 1 path: no interpolation, just a copy of the next input samples*/
+    void copyChunk(const juce::AudioSourceChannelInfo& bufferToFill);
+    void fillInput(int numNeeded);
+    /**Drops input before pos, keeping the history the next kernel needs, and makes pos the read position*/
+    void discardConsumed(double pos);
+
+    float interpolateLinear(const float* samples, float frac) const;
+    float interpolateCubic(const float* samples, float frac) const;
+    float interpolateSinc(const float* samples, const float* kernel) const;
+
+    juce::AudioSource* input;
+    int numChannels;
+
+    juce::AudioBuffer<float> inputBuffer;
+    int numBuffered{ 0 };
+    double readPos{ 0 };
+    int maxBlockSize{ 0 };
+
+    double ratio{ 1.0 };
+    double lastRatio{ 1.0 };
+    std::atomic<int> quality{ (int) Quality::sinc };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DeckResampler)
+};
@@ -0,0 +1,523 @@
+#include <JuceHeader.h>
+#include "DeckTransport.h"
+
+//==============================================================================
+DeckTransport::DeckTransport()
+{
+    // free the tracks the audio thread has swapped out
+    startTimer(1000);
+}
+
+DeckTransport::~DeckTransport()
+{
+    stopTimer();
+}
+
+void DeckTransport::prepareToPlay(int samplesPerBlockExpected, double newSampleRate)
+{
+    const juce::ScopedLock sl(prepareLock);
+    blockSize.store(samplesPerBlockExpected);
+    sampleRate.store(newSampleRate);
+    fadeBuffer.setSize(2, fadeLength);
+    numFadeSamples = 0;
+
+    // a track published but not swapped in yet is prepared too: emptying the retire queue makes
+    // sure this swap isn't put off to the audio thread
+    tracks.collectGarbage();
+    updateTrack();
+    if (currentTrack != nullptr)
+    {
+        currentTrack->prepare(samplesPerBlockExpected, newSampleRate);
+    }
+    resetGainSmoothing();
+}
+
+void DeckTransport::releaseResources()
+{
+    const juce::ScopedLock sl(prepareLock);
+    if (currentTrack != nullptr)
+    {
+        currentTrack->getSource()->releaseResources();
+        currentTrack->preparedBlockSize = 0;
+    }
+    blockSize.store(0);
+}
+
+void DeckTransport::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    auto startTicks = juce::Time::getHighResolutionTicks();
+    readBlock(bufferToFill);
+    readTicks += juce::Time::getHighResolutionTicks() - startTicks;
+}
+
+juce::int64 DeckTransport::takeReadTicks()
+{
+    auto ticks = readTicks;
+    readTicks = 0;
+    return ticks;
+}
+
+void DeckTransport::readBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    loopHeads.acquire();
+    cueSets.acquire();
+    if (segment != nullptr && !isSegmentCurrent())
+    {
+        // a new loop head or set of cues replaced the one being played
+        leaveSegment();
+    }
+
+    if (currentTrack == nullptr)
+    {
+        bufferToFill.clearActiveBufferRegion();
+        return;
+    }
+
+    auto* source = currentTrack->getSource();
+    auto seekTo = pendingSeek.exchange(-1);
+    if (seekTo >= 0)
+    {
+        segment = nullptr;
+        numFadeSamples = 0;
+        scheduledCue = -1;
+        source->setNextReadPosition(seekTo);
+    }
+    auto cueTo = pendingCue.exchange(-1);
+    if (cueTo >= 0)
+    {
+        scheduleCue(cueTo);
+    }
+
+    if (playing.load())
+    {
+        readLooped(bufferToFill);
+
+        // stop at the end of the track instead of playing silence forever
+        if (getReadPosition() > currentTrack->lengthInSamples + 1)
+        {
+            playing.store(false);
+        }
+    }
+    else
+    {
+        // stopping drops a cue still waiting for its beat
+        scheduledCue = -1;
+        bufferToFill.clearActiveBufferRegion();
+    }
+
+    smoothedGain.setTargetValue(gain.load());
+    if (smoothedGain.isSmoothing())
+    {
+        // the ramp is linear, so one applyGainRamp per channel follows it exactly
+        auto startGain = smoothedGain.getCurrentValue();
+        auto endGain = smoothedGain.skip(bufferToFill.numSamples);
+        for (int channel = 0; channel < bufferToFill.buffer->getNumChannels(); ++channel)
+        {
+            bufferToFill.buffer->applyGainRamp(channel, bufferToFill.startSample, bufferToFill.numSamples,
+                                               startGain, endGain);
+        }
+    }
+    else
+    {
+        bufferToFill.buffer->applyGain(bufferToFill.startSample, bufferToFill.numSamples,
+                                       smoothedGain.getCurrentValue());
+    }
+
+    playhead.store(getReadPosition());
+}
+
+void DeckTransport::readLooped(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    auto start = loopStart.load();
+    auto end = loopEnd.load();
+    if (start < 0 || end <= start)
+    {
+        start = 0;
+        end = currentTrack->lengthInSamples;
+    }
+    auto isLooping = loopEnabled.load() && end > start;
+
+    for (int done = 0; done < bufferToFill.numSamples;)
+    {
+        if (scheduledCue >= 0 && samplesUntilCue <= 0)
+        {
+            jumpTo(scheduledCue, fadeIntoCue ? fadeLength : 0);
+            scheduledCue = -1;
+        }
+
+        auto pos = getReadPosition();
+        auto numThisTime = bufferToFill.numSamples - done;
+        if (scheduledCue >= 0)
+        {
+            numThisTime = (int) juce::jmin((juce::int64) numThisTime, samplesUntilCue);
+        }
+        // only wrap when playing into the end, not when the loop was set behind the playhead
+        auto wraps = isLooping && pos < end && pos + numThisTime >= end;
+        if (wraps)
+        {
+            numThisTime = (int) (end - pos);
+        }
+
+        auto startSample = bufferToFill.startSample + done;
+        readRaw(*bufferToFill.buffer, startSample, numThisTime);
+
+        // fade the audio jumped to in over what would have followed
+        auto numFading = juce::jmin(numThisTime, numFadeSamples - fadePos);
+        for (int i = 0; i < numFading; ++i)
+        {
+            auto fadeIn = (fadePos + i + 0.5f) / numFadeSamples;
+            for (int channel = 0; channel < bufferToFill.buffer->getNumChannels(); ++channel)
+            {
+                auto tail = fadeBuffer.getSample(juce::jmin(channel, fadeBuffer.getNumChannels() - 1), fadePos + i);
+                auto sample = bufferToFill.buffer->getSample(channel, startSample + i);
+                bufferToFill.buffer->setSample(channel, startSample + i, sample * fadeIn + tail * (1.0f - fadeIn));
+            }
+        }
+        fadePos += juce::jmax(0, numFading);
+
+        done += numThisTime;
+        samplesUntilCue -= numThisTime;
+        if (wraps)
+        {
+            jumpTo(start, (int) juce::jmin((juce::int64) fadeLength, end - start));
+        }
+    }
+}
+
+void DeckTransport::jumpTo(juce::int64 targetSample, int maxFadeSamples)
+{
+    numFadeSamples = juce::jmin(fadeBuffer.getNumSamples(), maxFadeSamples);
+    fadePos = 0;
+    readRaw(fadeBuffer, 0, numFadeSamples);
+
+    if (auto* head = findSegment(targetSample))
+    {
+        // play the start from RAM; the stream seeks to where the segment ends and refills meanwhile
+        segment = head;
+        segmentStart = head->startSample;
+        segmentPos = 0;
+        auto* source = currentTrack->getSource();
+        source->setNextReadPosition(head->getEndSample());
+        // a zero-length read applies the seek now, so the refill starts while the segment plays
+        source->getNextAudioBlock(juce::AudioSourceChannelInfo(&fadeBuffer, 0, 0));
+    }
+    else
+    {
+        segment = nullptr;
+        currentTrack->getSource()->setNextReadPosition(targetSample);
+    }
+}
+
+const DecodedSegment* DeckTransport::findSegment(juce::int64 startSample) const
+{
+    auto matches = [this, startSample](const DecodedSegment* candidate)
+    {
+        return candidate != nullptr && candidate->trackSerial == currentTrack->serial
+                   && candidate->startSample == startSample;
+    };
+
+    if (matches(loopHeads.get()))
+    {
+        return loopHeads.get();
+    }
+    if (auto* cues = cueSets.get())
+    {
+        for (const auto& cue : cues->cues)
+        {
+            if (matches(cue.get()))
+            {
+                return cue.get();
+            }
+        }
+    }
+    return nullptr;
+}
+
+bool DeckTransport::isSegmentCurrent() const
+{
+    if (segment == loopHeads.get())
+    {
+        return true;
+    }
+    if (auto* cues = cueSets.get())
+    {
+        for (const auto& cue : cues->cues)
+        {
+            if (segment == cue.get())
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void DeckTransport::scheduleCue(juce::int64 targetSample)
+{
+    auto wasPlaying = playing.load();
+    auto length = beatLength.load();
+    samplesUntilCue = 0;
+    if (wasPlaying && quantize.load() && length > 0)
+    {
+        // counted in samples played rather than as a position, so a loop wrapping first can't skip it
+        auto pos = (double) getReadPosition();
+        auto origin = firstBeat.load();
+        auto nextBeat = origin + std::ceil((pos - origin) / length) * length;
+        samplesUntilCue = juce::jmax((juce::int64) 0, (juce::int64) std::llround(nextBeat - pos));
+    }
+    scheduledCue = targetSample;
+    // from a stopped deck there is nothing audible to fade out
+    fadeIntoCue = wasPlaying;
+    playing.store(true);
+}
+
+void DeckTransport::readRaw(juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    int done = 0;
+    if (segment != nullptr)
+    {
+        done = juce::jmin(numSamples, segment->audio.getNumSamples() - segmentPos);
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        {
+            buffer.copyFrom(channel, startSample, segment->audio,
+                            juce::jmin(channel, segment->audio.getNumChannels() - 1), segmentPos, done);
+        }
+        segmentPos += done;
+        if (segmentPos >= segment->audio.getNumSamples())
+        {
+            // the stream is already waiting where the segment ends
+            segment = nullptr;
+        }
+    }
+
+    if (done < numSamples)
+    {
+        currentTrack->getSource()->getNextAudioBlock(juce::AudioSourceChannelInfo(&buffer, startSample + done,
+                                                                                  numSamples - done));
+    }
+}
+
+juce::int64 DeckTransport::getReadPosition() const
+{
+    if (segment != nullptr)
+    {
+        return segmentStart + segmentPos;
+    }
+    return currentTrack != nullptr ? currentTrack->getSource()->getNextReadPosition() : 0;
+}
+
+void DeckTransport::leaveSegment()
+{
+    if (currentTrack != nullptr)
+    {
+        currentTrack->getSource()->setNextReadPosition(segmentStart + segmentPos);
+    }
+    segment = nullptr;
+}
+
+juce::uint32 DeckTransport::setTrack(std::unique_ptr<LoadedTrack> track)
+{
+    playing.store(false);
+    pendingSeek.store(-1);
+    pendingCue.store(-1);
+    playhead.store(0);
+    // a loop region belongs to the old track, but looping stays switched on
+    clearLoop();
+    auto serial = trackSerial.load() + 1;
+    if (track != nullptr)
+    {
+        track->serial = serial;
+    }
+    trackSerial.store(serial);
+    trackSampleRate.store(track != nullptr ? track->sampleRate : 0);
+    trackLength.store(track != nullptr ? track->lengthInSamples : 0);
+    {
+        // the loader prepares tracks ahead, but a prepareToPlay may have happened since it looked;
+        // preparing here rather than when the audio thread swaps the track in keeps the swap lock-free
+        const juce::ScopedLock sl(prepareLock);
+        if (track != nullptr && isPrepared())
+        {
+            track->prepare(blockSize.load(), sampleRate.load());
+        }
+        tracks.publish(std::move(track));
+    }
+    return serial;
+}
+
+bool DeckTransport::updateTrack()
+{
+    auto* track = tracks.acquire();
+    if (track == currentTrack)
+    {
+        return false;
+    }
+    currentTrack = track;
+    // positions in the old track mean nothing in the new one
+    segment = nullptr;
+    scheduledCue = -1;
+    numFadeSamples = 0;
+    resetGainSmoothing();
+    return true;
+}
+
+void DeckTransport::resetGainSmoothing()
+{
+    // the gain is applied before the stretcher and resampler, so it runs at the track's rate
+    auto rate = currentTrack != nullptr ? currentTrack->sampleRate : sampleRate.load();
+    if (rate > 0)
+    {
+        smoothedGain.reset(rate, gainRampSecs);
+    }
+    smoothedGain.setCurrentAndTargetValue(gain.load());
+}
+
+double DeckTransport::getCurrentTrackSampleRate() const
+{
+    return currentTrack != nullptr ? currentTrack->sampleRate : 0;
+}
+
+void DeckTransport::start()
+{
+    playing.store(true);
+}
+
+void DeckTransport::stop()
+{
+    playing.store(false);
+}
+
+bool DeckTransport::isPlaying() const
+{
+    return playing.load();
+}
+
+void DeckTransport::setPosition(double posInSecs)
+{
+    pendingSeek.store(getSampleAt(posInSecs));
+}
+
+double DeckTransport::getCurrentPosition() const
+{
+    auto rate = trackSampleRate.load();
+    if (rate <= 0)
+    {
+        return 0;
+    }
+    auto seekTo = pendingSeek.load();
+    return (double) (seekTo >= 0 ? seekTo : playhead.load()) / rate;
+}
+
+double DeckTransport::getLengthInSeconds() const
+{
+    auto rate = trackSampleRate.load();
+    return rate > 0 ? (double) trackLength.load() / rate : 0;
+}
+
+juce::int64 DeckTransport::getSampleAt(double posInSecs) const
+{
+    auto position = (juce::int64) (posInSecs * trackSampleRate.load());
+    return juce::jlimit((juce::int64) 0, trackLength.load(), position);
+}
+
+void DeckTransport::setGain(float newGain)
+{
+    gain.store(newGain);
+}
+
+void DeckTransport::setLoop(double startSecs, double endSecs)
+{
+    loopStart.store(getSampleAt(startSecs));
+    loopEnd.store(getSampleAt(endSecs));
+}
+
+void DeckTransport::clearLoop()
+{
+    loopStart.store(-1);
+    loopEnd.store(-1);
+}
+
+void DeckTransport::setLoopEnabled(bool shouldLoop)
+{
+    loopEnabled.store(shouldLoop);
+}
+
+bool DeckTransport::isLoopEnabled() const
+{
+    return loopEnabled.load();
+}
+
+juce::int64 DeckTransport::getLoopStartSample() const
+{
+    return juce::jmax((juce::int64) 0, loopStart.load());
+}
+
+void DeckTransport::setLoopHead(std::unique_ptr<DecodedSegment> head)
+{
+    loopHeads.publish(std::move(head));
+}
+
+void DeckTransport::triggerCue(juce::int64 targetSample)
+{
+    pendingCue.store(juce::jlimit((juce::int64) 0, trackLength.load(), targetSample));
+}
+
+void DeckTransport::setCueSegments(std::unique_ptr<DecodedCueSet> cues)
+{
+    cueSets.publish(std::move(cues));
+}
+
+void DeckTransport::setBeatGrid(const BeatGrid& grid)
+{
+    auto rate = trackSampleRate.load();
+    beatLength.store(grid.getBeatLengthSecs() * rate);
+    firstBeat.store(grid.firstBeatSecs * rate);
+}
+
+void DeckTransport::setQuantize(bool shouldQuantize)
+{
+    quantize.store(shouldQuantize);
+}
+
+bool DeckTransport::isQuantized() const
+{
+    return quantize.load();
+}
+
+double DeckTransport::getGridBpm() const
+{
+    auto length = beatLength.load();
+    return length > 0 ? 60.0 * trackSampleRate.load() / length : 0;
+}
+
+double DeckTransport::getBeatPosition() const
+{
+    auto length = beatLength.load();
+    return length > 0 ? ((double) playhead.load() - firstBeat.load()) / length : 0;
+}
+
+juce::uint32 DeckTransport::getTrackSerial() const
+{
+    return trackSerial.load();
+}
+
+bool DeckTransport::isPrepared() const
+{
+    return blockSize.load() > 0;
+}
+
+int DeckTransport::getBlockSize() const
+{
+    return blockSize.load();
+}
+
+double DeckTransport::getSampleRate() const
+{
+    return sampleRate.load();
+}
+
+void DeckTransport::timerCallback()
+{
+    tracks.collectGarbage();
+    loopHeads.collectGarbage();
+    cueSets.collectGarbage();
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "LoadedTrack.h"
+#include "DecodedSegment.h"
+#include "RealtimeHandoff.h"
+#include "BeatGrid.h"
+
+//==============================================================================
+/*
+    Start/stop, position and gain for one deck, playing whatever LoadedTrack
+    was last handed to it. Unlike juce::AudioTransportSource a new track is
+    swapped in by the audio thread itself, so loading never takes the callback
+    lock. Output stays at the track's own sample rate.
+
+    Loops are wrapped by the audio thread to the sample, with a short
+    crossfade. The start of the loop can be handed over already decoded, so
+    the jump back plays from RAM while the read-ahead buffer catches up.
+    Hot cues work the same way: the audio at each cue is decoded ahead of
+    time, and triggering one jumps on the next block, or on the next beat
+    when quantizing.
+*/
+class DeckTransport  : public juce::AudioSource,
+                       private juce::Timer
+{
+public:
+    DeckTransport();
+    ~DeckTransport() override;
+
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+    void releaseResources() override;
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+    /**Hands a track to the audio thread and stops playback, like AudioTransportSource::setSource.
+    *  The track is prepared for the device first if it wasn't already. Returns the serial given
+    *  to the track*/
+    juce::uint32 setTrack(std::unique_ptr<LoadedTrack> track);
+    /**Audio thread: swaps in a newly loaded track, which is only a pointer swap as tracks are
+    *  prepared before they are handed over. The owner calls this at the start of every block,
+    *  before getNextAudioBlock. Returns true if the track changed*/
+    bool updateTrack();
+    /**Audio thread: sample rate of the track currently playing, 0 if none*/
+    double getCurrentTrackSampleRate() const;
+
+    void start();
+    void stop();
+    bool isPlaying() const;
+    /**Seeks to a position in seconds, applied at the start of the next block*/
+    void setPosition(double posInSecs);
+    double getCurrentPosition() const;
+    double getLengthInSeconds() const;
+    /**A position in seconds as a sample of the most recently published track, the way
+    *  seeks, loops and cues convert it*/
+    juce::int64 getSampleAt(double posInSecs) const;
+    void setGain(float newGain);
+
+    /**Loops between two positions in seconds. Without a region the whole track loops*/
+    void setLoop(double startSecs, double endSecs);
+    void clearLoop();
+    void setLoopEnabled(bool shouldLoop);
+    bool isLoopEnabled() const;
+    /**Where the loop starts, in samples of the track*/
+    juce::int64 getLoopStartSample() const;
+    /**Passes in the decoded start of the loop, ignored unless it matches the loop and track*/
+    void setLoopHead(std::unique_ptr<DecodedSegment> segment);
+    /**Jumps to a position in samples on the next block and starts playing. When quantizing
+    *  and already playing, the jump waits for the next beat of the grid instead*/
+    void triggerCue(juce::int64 targetSample);
+    /**Passes in the decoded audio at each hot cue, ignored unless it matches the track*/
+    void setCueSegments(std::unique_ptr<DecodedCueSet> cues);
+    /**The grid quantized cues wait for, in the timing of the most recently published track*/
+    void setBeatGrid(const BeatGrid& grid);
+    void setQuantize(bool shouldQuantize);
+    bool isQuantized() const;
+    /**The track's tempo at normal speed from the beat grid, 0 without one*/
+    double getGridBpm() const;
+    /**How many beats of the grid the playhead is past the first beat, for syncing*/
+    double getBeatPosition() const;
+    /**Serial of the most recently published track*/
+    juce::uint32 getTrackSerial() const;
+    /**Audio thread: high resolution ticks spent in getNextAudioBlock since the last call*/
+    juce::int64 takeReadTicks();
+
+    /**Block size and rate of the last prepareToPlay, so tracks can be prepared before they are handed over*/
+    bool isPrepared() const;
+    int getBlockSize() const;
+    double getSampleRate() const;
+
+private:
+    void timerCallback() override;
+    /**Audio thread: the body of getNextAudioBlock, which times it*/
+    void readBlock(const juce::AudioSourceChannelInfo& bufferToFill);
+    /**Audio thread: plays on, wrapping at the loop end if it falls inside the block*/
+    void readLooped(const juce::AudioSourceChannelInfo& bufferToFill);
+    /**Jumps to a position, fading out what would have followed under the audio from there*/
+    void jumpTo(juce::int64 targetSample, int maxFadeSamples);
+    /**A decoded segment of the current track starting exactly at a position, if there is one*/
+    const DecodedSegment* findSegment(juce::int64 startSample) const;
+    /**False once the loop head or cue set the segment came from has been replaced*/
+    bool isSegmentCurrent() const;
+    /**Picks up a triggered cue and works out how far to play before jumping to it*/
+    void scheduleCue(juce::int64 targetSample);
+    /**Reads from the decoded segment while there is one, then from the stream*/
+    void readRaw(juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+    juce::int64 getReadPosition() const;
+    /**Stops playing from the segment and points the stream where it left off*/
+    void leaveSegment();
+    /**Audio thread: times the gain ramp in samples of the current track and ends any ramp*/
+    void resetGainSmoothing();
+
+    static constexpr int fadeLength = 256;
+    static constexpr double gainRampSecs = 0.02;
+
+    RealtimeHandoff<LoadedTrack> tracks;
+    LoadedTrack* currentTrack = nullptr;
+
+    std::atomic<bool> playing{ false };
+    std::atomic<juce::int64> pendingSeek{ -1 };
+    std::atomic<juce::int64> playhead{ 0 };
+    std::atomic<float> gain{ 1.0f };
+    // audio thread: ramps each gain change over a fixed time, whatever the block size
+    juce::SmoothedValue<float> smoothedGain{ 1.0f };
+
+    // -1 when no region is set
+    std::atomic<juce::int64> loopStart{ -1 };
+    std::atomic<juce::int64> loopEnd{ -1 };
+    std::atomic<bool> loopEnabled{ false };
+
+    RealtimeHandoff<DecodedSegment> loopHeads;
+    // audio thread: the segment being played instead of the stream, if any
+    const DecodedSegment* segment = nullptr;
+    juce::int64 segmentStart{ 0 };
+    int segmentPos{ 0 };
+
+    RealtimeHandoff<DecodedCueSet> cueSets;
+    std::atomic<juce::int64> pendingCue{ -1 };
+    std::atomic<bool> quantize{ false };
+    // in samples of the track, no grid when the beat length is 0
+    std::atomic<double> beatLength{ 0 };
+    std::atomic<double> firstBeat{ 0 };
+    // audio thread: a cue waiting for its beat, and how much more to play until then
+    juce::int64 scheduledCue{ -1 };
+    juce::int64 samplesUntilCue{ 0 };
+    bool fadeIntoCue{ false };
+
+    // audio thread: what followed the jump, faded out under the audio jumped to
+    juce::AudioBuffer<float> fadeBuffer;
+    int numFadeSamples{ 0 };
+    int fadePos{ 0 };
+
+    // audio thread: the stretcher may read several times a block, so this adds up until taken
+    juce::int64 readTicks{ 0 };
+
+    // describe the most recently published track, for the message thread
+    std::atomic<double> trackSampleRate{ 0 };
+    std::atomic<juce::int64> trackLength{ 0 };
+    std::atomic<juce::uint32> trackSerial{ 0 };
+
+    std::atomic<int> blockSize{ 0 };
+    std::atomic<double> sampleRate{ 0 };
+    // held while preparing and while a track is prepared and published, never by the audio thread,
+    // so a prepareToPlay either sees a new track or comes before it was prepared
+    juce::CriticalSection prepareLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DeckTransport)
+};
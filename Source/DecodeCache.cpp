@@ -0,0 +1,187 @@
+#include <JuceHeader.h>
+#include "DecodeCache.h"
+
+//==============================================================================
+DecodeCache::DecodeCache(juce::AudioFormatManager& _formatManager,
+                         const juce::File& _directory,
+                         juce::int64 _maxBytes,
+                         int _bitsPerSample
+                        ) : formatManager(_formatManager),
+                            directory(_directory),
+                            maxBytes(_maxBytes),
+                            bitsPerSample(_bitsPerSample)
+{
+    if (bitsPerSample != 16 && bitsPerSample != 32)
+    {
+        DBG("DecodeCache bitsPerSample should be 16 or 32, using 32");
+        bitsPerSample = 32;
+    }
+    directory.createDirectory();
+    // decodes cut short by a crash; nothing of this cache's is decoding yet
+    auto partials = directory.findChildFiles(juce::File::findFiles, false, "*" + juce::String(partialExtension));
+    for (const auto& partial : partials)
+    {
+        partial.deleteFile();
+    }
+    // decoding is never urgent, the decks' threads come first
+    decodePool.setThreadPriorities(2);
+}
+
+DecodeCache::~DecodeCache()
+{
+    decodePool.removeAllJobs(true, 5000);
+}
+
+juce::File DecodeCache::findCachedFile(const juce::File& source)
+{
+    auto cached = getCacheFile(source);
+    if (cached.existsAsFile())
+    {
+        // the modification time is what eviction goes by, so a hit makes the entry the newest
+        cached.setLastModificationTime(juce::Time::getCurrentTime());
+        return cached;
+    }
+    return {};
+}
+
+void DecodeCache::cacheInBackground(const juce::File& source)
+{
+    auto* format = formatManager.findFormatForFileExtension(source.getFileExtension());
+    if (format == nullptr || !format->isCompressed() || getCacheFile(source).existsAsFile())
+    {
+        return;
+    }
+
+    {
+        const juce::ScopedLock sl(queueLock);
+        if (queued.contains(source.getFullPathName()))
+        {
+            return;
+        }
+        queued.add(source.getFullPathName());
+    }
+
+    decodePool.addJob([this, source]
+    {
+        auto target = getCacheFile(source);
+        if (!target.existsAsFile() && decode(source, target))
+        {
+            evictToFit();
+        }
+        const juce::ScopedLock sl(queueLock);
+        queued.removeString(source.getFullPathName());
+    });
+}
+
+juce::int64 DecodeCache::getSizeOnDisk() const
+{
+    juce::int64 total = 0;
+    for (const auto& entry : getEntries())
+    {
+        total += entry.getSize();
+    }
+    return total;
+}
+
+void DecodeCache::clear()
+{
+    for (const auto& entry : getEntries())
+    {
+        entry.deleteFile();
+    }
+}
+
+juce::File DecodeCache::getDefaultDirectory()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("OtoDecks")
+               .getChildFile("DecodeCache");
+}
+
+juce::File DecodeCache::getCacheFile(const juce::File& source) const
+{
+    // anything that changes the file changes the key, so a stale entry is never found
+    juce::String key;
+    key << source.getFullPathName() << "|" << source.getSize()
+        << "|" << source.getLastModificationTime().toMilliseconds();
+    return directory.getChildFile(juce::String::toHexString(key.hashCode64())
+                                  + (bitsPerSample == 32 ? "_f32" : "_i16") + ".wav");
+}
+
+bool DecodeCache::decode(const juce::File& source, const juce::File& target)
+{
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(source));
+    if (reader == nullptr)
+    {
+        DBG("DecodeCache::decode could not open " << source.getFileName());
+        return false;
+    }
+
+    // written beside the target and moved into place whole, so a half-written entry is never found;
+    // named so getEntries doesn't see it either, or eviction could count or delete it mid-write
+    juce::TemporaryFile temp(target, target.getSiblingFile(target.getFileName() + partialExtension)
+                                         .getNonexistentSibling(false));
+    {
+        juce::WavAudioFormat wavFormat;
+        std::unique_ptr<juce::AudioFormatWriter> writer(wavFormat.createWriterFor(
+            new juce::FileOutputStream(temp.getFile()), reader->sampleRate, reader->numChannels,
+            bitsPerSample, {}, 0));
+        if (writer == nullptr)
+        {
+            DBG("DecodeCache::decode could not write " << temp.getFile().getFullPathName());
+            return false;
+        }
+
+        juce::AudioBuffer<float> block((int) reader->numChannels, decodeBlockSize);
+        for (juce::int64 pos = 0; pos < reader->lengthInSamples; pos += decodeBlockSize)
+        {
+            auto* job = juce::ThreadPoolJob::getCurrentThreadPoolJob();
+            if (job != nullptr && job->shouldExit())
+            {
+                return false;
+            }
+            auto numSamples = (int) juce::jmin((juce::int64) decodeBlockSize, reader->lengthInSamples - pos);
+            reader->read(&block, 0, numSamples, pos, true, true);
+            if (!writer->writeFromAudioSampleBuffer(block, 0, numSamples))
+            {
+                DBG("DecodeCache::decode ran out of space for " << source.getFileName());
+                return false;
+            }
+        }
+    }
+    return temp.overwriteTargetFileWithTemporary();
+}
+
+void DecodeCache::evictToFit()
+{
+    auto entries = getEntries();
+    juce::int64 total = 0;
+    for (const auto& entry : entries)
+    {
+        total += entry.getSize();
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const juce::File& a, const juce::File& b)
+    {
+        return a.getLastModificationTime() < b.getLastModificationTime();
+    });
+
+    for (const auto& entry : entries)
+    {
+        if (total <= maxBytes)
+        {
+            break;
+        }
+        auto size = entry.getSize();
+        // a deck may have it mapped; where that stops the delete it is tried again next time
+        if (entry.deleteFile())
+        {
+            total -= size;
+        }
+    }
+}
+
+juce::Array<juce::File> DecodeCache::getEntries() const
+{
+    return directory.findChildFiles(juce::File::findFiles, false, "*.wav");
+}
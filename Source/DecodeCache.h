@@ -0,0 +1,66 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    An on-disk cache of compressed tracks (MP3, OGG, FLAC...) decoded to WAV,
+    so loading one again skips the codec and plays from a memory mapping like
+    any other WAV.
+
+    Entries are keyed by the source file's path, size and modification time,
+    so editing or replacing a file misses the cache. A miss decodes the track
+    on a low priority background thread while it plays as usual; the next load
+    finds it cached. Every hit touches the entry, and after each new entry the
+    least recently used ones are deleted until the cache fits its size cap.
+*/
+class DecodeCache
+{
+public:
+    /**bitsPerSample is 32 for float, or 16 to halve the size*/
+    DecodeCache(juce::AudioFormatManager& _formatManager,
+                const juce::File& _directory,
+                juce::int64 _maxBytes,
+                int _bitsPerSample = 32);
+    ~DecodeCache();
+
+    /**Any thread: the decoded copy of a source file, or a non-existent file on a miss*/
+    juce::File findCachedFile(const juce::File& source);
+    /**Any thread: decodes a compressed file into the cache in the background, unless it is
+    *  already cached or queued. Uncompressed files are ignored, they can be mapped directly*/
+    void cacheInBackground(const juce::File& source);
+
+    /**Total size of the entries on disk*/
+    juce::int64 getSizeOnDisk() const;
+    /**Deletes every entry*/
+    void clear();
+
+    /**Default location, in the user's application data folder*/
+    static juce::File getDefaultDirectory();
+
+private:
+    juce::File getCacheFile(const juce::File& source) const;
+    /**Decode thread: writes the whole track to a temporary file, then moves it into place*/
+    bool decode(const juce::File& source, const juce::File& target);
+    /**Decode thread: deletes the least recently used entries until the cache fits*/
+    void evictToFit();
+    juce::Array<juce::File> getEntries() const;
+
+    static constexpr int decodeBlockSize = 65536;
+    // what a decode is written to until it is complete, e.g. "1a2b_f32.wav.partial"
+    static constexpr const char* partialExtension = ".partial";
+
+    juce::AudioFormatManager& formatManager;
+    juce::File directory;
+    juce::int64 maxBytes;
+    int bitsPerSample;
+
+    // source paths waiting to be decoded, so repeated loads queue one job
+    juce::CriticalSection queueLock;
+    juce::StringArray queued;
+
+    // declared last so queued decodes stop before anything they use is destroyed
+    juce::ThreadPool decodePool{ 1 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DecodeCache)
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    A short stretch of a track decoded into RAM ahead of time, such as the
+    start of a loop. The transport plays from it after a jump while the
+    read-ahead buffer refills behind it.
+*/
+struct DecodedSegment
+{
+    /**The LoadedTrack::serial the audio came from, so stale segments are ignored*/
+    juce::uint32 trackSerial = 0;
+    juce::int64 startSample = 0;
+    juce::AudioBuffer<float> audio;
+
+    juce::int64 getEndSample() const
+    {
+        return startSample + audio.getNumSamples();
+    }
+};
+
+//==============================================================================
+/*
+    The audio at each hot cue of one track, handed to the transport together
+    so a cue can start playing on the very next block.
+*/
+struct DecodedCueSet
+{
+    static constexpr int maxCues = 8;
+
+    juce::uint32 trackSerial = 0;
+    // null where the cue isn't set
+    std::unique_ptr<DecodedSegment> cues[maxCues];
+};
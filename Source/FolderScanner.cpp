@@ -0,0 +1,120 @@
+#include <JuceHeader.h>
+#include "FolderScanner.h"
+
+//==============================================================================
+FolderScanner::FolderScanner(juce::AudioFormatManager& _formatManager,
+                             int _numThreads
+                            ) : formatManager(_formatManager),
+                                scanPool(juce::jmax(1, _numThreads))
+{
+    // scanning is never urgent, the decks' threads come first
+    scanPool.setThreadPriorities(2);
+}
+
+FolderScanner::~FolderScanner()
+{
+    scanPool.removeAllJobs(true, 5000);
+    cancelPendingUpdate();
+}
+
+void FolderScanner::scan(const juce::File& root)
+{
+    auto walk = std::make_shared<Walk>();
+    walk->root = root;
+    // the formats are registered after the scanner is made; each walk keeps its own copy, which
+    // its jobs only read, so a scan started while another runs doesn't change it under them
+    walk->audioExtensions = formatManager.getWildcardForAllFormats().removeCharacters("*");
+    const juce::ScopedLock sl(lock);
+    ++numWalking;
+    if (!root.isDirectory())
+    {
+        DBG("FolderScanner::scan can't find " << root.getFullPathName());
+        walk->complete = false;
+        finished.push_back(walk);
+        triggerAsyncUpdate();
+        return;
+    }
+    addDirectoryJob(walk, root);
+}
+
+bool FolderScanner::isScanning() const
+{
+    const juce::ScopedLock sl(lock);
+    return numWalking > 0;
+}
+
+void FolderScanner::scanDirectory(std::shared_ptr<Walk> walk, const juce::File& directory)
+{
+    std::vector<ScannedFile> files;
+    juce::Array<juce::File> subdirectories;
+    auto* job = juce::ThreadPoolJob::getCurrentThreadPoolJob();
+    // the iterator yields nothing for a directory it can't open, which would look like every
+    // file in it was deleted, so one that can't be read counts as not listed
+    auto listed = directory.isDirectory() && directory.hasReadAccess();
+
+    for (const auto& entry : juce::RangedDirectoryIterator(directory, false, "*",
+                                                           juce::File::findFilesAndDirectories
+                                                               | juce::File::ignoreHiddenFiles))
+    {
+        if (job != nullptr && job->shouldExit())
+        {
+            listed = false;
+            break;
+        }
+        auto file = entry.getFile();
+        if (entry.isDirectory())
+        {
+            // a link back up the tree would be walked forever
+            if (!file.isSymbolicLink())
+            {
+                subdirectories.add(file);
+            }
+        }
+        else if (file.hasFileExtension(walk->audioExtensions))
+        {
+            files.push_back({ file, entry.getFileSize(), entry.getModificationTime().toMilliseconds() });
+        }
+    }
+
+    // and one that went away while it was listed, e.g. with the share it is on, may be cut short
+    listed = listed && directory.isDirectory();
+
+    const juce::ScopedLock sl(lock);
+    walk->files.insert(walk->files.end(), files.begin(), files.end());
+    walk->complete = walk->complete && listed;
+    if (listed)
+    {
+        for (const auto& subdirectory : subdirectories)
+        {
+            addDirectoryJob(walk, subdirectory);
+        }
+    }
+    if (--walk->numPendingDirectories == 0)
+    {
+        finished.push_back(walk);
+        triggerAsyncUpdate();
+    }
+}
+
+void FolderScanner::addDirectoryJob(std::shared_ptr<Walk> walk, const juce::File& directory)
+{
+    ++walk->numPendingDirectories;
+    scanPool.addJob([this, walk, directory] { scanDirectory(walk, directory); });
+}
+
+void FolderScanner::handleAsyncUpdate()
+{
+    std::vector<std::shared_ptr<Walk>> walks;
+    {
+        const juce::ScopedLock sl(lock);
+        walks.swap(finished);
+        numWalking -= (int) walks.size();
+    }
+    for (const auto& walk : walks)
+    {
+        if (onFolderScanned)
+        {
+            onFolderScanned(walk->root, walk->files, walk->complete);
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+//==============================================================================
+/*
+    An audio file found under a folder, with what tells whether it changed.
+*/
+struct ScannedFile
+{
+    juce::File file;
+    juce::int64 size;
+    // milliseconds since 1970
+    juce::int64 modificationTime;
+};
+
+//==============================================================================
+/*
+    Walks folder trees on a pool of background threads to find every audio
+    file in them, e.g. to import a music collection or to rescan one.
+
+    Each directory is listed by its own job, which queues a job for every
+    subdirectory it finds, so deep and wide trees alike keep every thread
+    busy. The size and modification time come with the listing, so a walk
+    never opens a file. A rescan compares them with what the library holds
+    to find the files that are new or have changed.
+*/
+class FolderScanner  : private juce::AsyncUpdater
+{
+public:
+    FolderScanner(juce::AudioFormatManager& _formatManager, int _numThreads);
+    ~FolderScanner() override;
+
+    /**Message thread: finds the audio files in a folder and every folder below it*/
+    void scan(const juce::File& root);
+    /**true while any walk is unfinished*/
+    bool isScanning() const;
+
+    /**Message thread: called with every audio file found under a folder once the whole tree has
+    *  been walked. complete is false if a part of it couldn't be listed, e.g. because the share
+    *  it is on went away, so a missing file can't be told from one that was deleted*/
+    std::function<void(const juce::File& root, const std::vector<ScannedFile>& files, bool complete)> onFolderScanned;
+
+private:
+    /**One folder tree being walked*/
+    struct Walk
+    {
+        juce::File root;
+        // the extensions of every registered format when the walk began, e.g. "wav;mp3"
+        juce::String audioExtensions;
+        std::vector<ScannedFile> files;
+        int numPendingDirectories = 0;
+        bool complete = true;
+    };
+
+    /**Pool thread: lists one directory, queueing its subdirectories*/
+    void scanDirectory(std::shared_ptr<Walk> walk, const juce::File& directory);
+    /**Called with the lock held*/
+    void addDirectoryJob(std::shared_ptr<Walk> walk, const juce::File& directory);
+    void handleAsyncUpdate() override;
+
+    juce::AudioFormatManager& formatManager;
+
+    juce::CriticalSection lock;
+    int numWalking{ 0 };
+    std::vector<std::shared_ptr<Walk>> finished;
+
+    // declared last so walks stop before anything they use is destroyed
+    juce::ThreadPool scanPool;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FolderScanner)
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    The hot cue points of one track, in seconds. The library keeps them with
+    the track, so they come back whenever it is loaded.
+*/
+struct HotCues
+{
+    static constexpr int numCues = 8;
+
+    HotCues()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        std::fill(std::begin(positions), std::end(positions), -1.0);
+    }
+
+    bool isSet(int index) const
+    {
+        return positions[index] >= 0;
+    }
+
+    bool operator==(const HotCues& other) const
+    {
+        return std::equal(std::begin(positions), std::end(positions), std::begin(other.positions));
+    }
+
+    bool operator!=(const HotCues& other) const
+    {
+        return !(*this == other);
+    }
+
+    /**Positions separated by semicolons, -1 for a cue that isn't set*/
+    juce::String toString() const
+    {
+        juce::StringArray tokens;
+        for (auto pos : positions)
+        {
+            tokens.add(juce::String(pos));
+        }
+        return tokens.joinIntoString(";");
+    }
+
+    static HotCues fromString(const juce::String& text)
+    {
+        HotCues cues;
+        auto tokens = juce::StringArray::fromTokens(text, ";", "");
+        for (int i = 0; i < juce::jmin(numCues, tokens.size()); ++i)
+        {
+            cues.positions[i] = tokens[i].isEmpty() ? -1.0 : tokens[i].getDoubleValue();
+        }
+        return cues;
+    }
+
+    double positions[numCues];
+};
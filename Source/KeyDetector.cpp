@@ -0,0 +1,205 @@
+#include <JuceHeader.h>
+#include "KeyDetector.h"
+
+namespace
+{
+    // Krumhansl and Kessler's ratings of how well each pitch class fits a key, tonic first
+    const double majorProfile[12] = { 6.35, 2.23, 3.48, 2.33, 4.38, 4.09, 2.52, 5.19, 2.39, 3.66, 2.29, 2.88 };
+    const double minorProfile[12] = { 6.33, 2.68, 3.52, 5.38, 2.60, 3.53, 2.54, 4.75, 3.98, 2.69, 3.34, 3.17 };
+
+    /**Pearson correlation of the chromagram with a profile moved up to a tonic*/
+    double correlate(const double (&chroma)[12], const double (&profile)[12], int tonic)
+    {
+        double chromaMean = 0;
+        double profileMean = 0;
+        for (int i = 0; i < 12; ++i)
+        {
+            chromaMean += chroma[i] / 12.0;
+            profileMean += profile[i] / 12.0;
+        }
+        double covariance = 0;
+        double chromaVariance = 0;
+        double profileVariance = 0;
+        for (int i = 0; i < 12; ++i)
+        {
+            auto c = chroma[(i + tonic) % 12] - chromaMean;
+            auto p = profile[i] - profileMean;
+            covariance += c * p;
+            chromaVariance += c * c;
+            profileVariance += p * p;
+        }
+        return chromaVariance > 0 ? covariance / std::sqrt(chromaVariance * profileVariance) : 0;
+    }
+}
+
+//==============================================================================
+KeyDetector::KeyDetector(double _sampleRate)
+{
+    decimation = juce::jmax(1, juce::roundToInt(_sampleRate / targetRate));
+    analysisRate = _sampleRate / decimation;
+
+    // cut off at a quarter of the analysis rate: above maxFreq, and anything that would fold down
+    // onto the notes is past three quarters of it, where the cascade has taken off about 80dB
+    auto k = std::tan(juce::MathConstants<double>::pi * 0.25 * analysisRate / _sampleRate);
+    for (int section = 0; section < numLowpassSections; ++section)
+    {
+        // each section takes a conjugate pair of the Butterworth poles
+        auto q = 1.0 / (2.0 * std::sin((2 * section + 1) * juce::MathConstants<double>::pi / (4 * numLowpassSections)));
+        auto norm = 1.0 / (1.0 + k / q + k * k);
+        auto& biquad = lowpass[section];
+        biquad.b0 = k * k * norm;
+        biquad.b1 = 2.0 * biquad.b0;
+        biquad.b2 = biquad.b0;
+        biquad.a1 = 2.0 * (k * k - 1.0) * norm;
+        biquad.a2 = (1.0 - k / q + k * k) * norm;
+    }
+
+    frame.resize(fftSize, 0.0f);
+    fftData.resize(fftSize);
+    window.resize(fftSize);
+    twiddles.resize(fftSize / 2);
+    for (int i = 0; i < fftSize; ++i)
+    {
+        window[(size_t) i] = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * i / fftSize);
+    }
+    for (int i = 0; i < fftSize / 2; ++i)
+    {
+        twiddles[(size_t) i] = std::polar(1.0f, -juce::MathConstants<float>::twoPi * i / fftSize);
+    }
+
+    binPitchClass.resize(fftSize / 2, -1);
+    for (int bin = 1; bin < fftSize / 2; ++bin)
+    {
+        auto freq = bin * analysisRate / fftSize;
+        if (freq >= minFreq && freq <= maxFreq)
+        {
+            // MIDI note numbers, so C is a multiple of 12
+            auto note = juce::roundToInt(69.0 + 12.0 * std::log2(freq / 440.0));
+            binPitchClass[(size_t) bin] = note % 12;
+        }
+    }
+}
+
+KeyDetector::~KeyDetector()
+{
+}
+
+void KeyDetector::process(const float* samples, int numSamples)
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto filtered = (double) samples[i];
+        for (auto& biquad : lowpass)
+        {
+            filtered = biquad.process(filtered);
+        }
+        if (++decimationPos < decimation)
+        {
+            continue;
+        }
+        frame[(size_t) framePos++] = (float) filtered;
+        decimationPos = 0;
+
+        if (framePos == fftSize)
+        {
+            analyzeFrame();
+            // the second half becomes the first half of the next frame
+            std::copy(frame.begin() + hopSize, frame.end(), frame.begin());
+            framePos = fftSize - hopSize;
+        }
+    }
+}
+
+MusicalKey KeyDetector::getKey() const
+{
+    if (numFrames == 0)
+    {
+        return {};
+    }
+
+    MusicalKey best;
+    auto bestCorrelation = 0.0;
+    for (int tonic = 0; tonic < 12; ++tonic)
+    {
+        auto major = correlate(chroma, majorProfile, tonic);
+        auto minor = correlate(chroma, minorProfile, tonic);
+        if (major > bestCorrelation)
+        {
+            best.tonic = tonic;
+            best.isMinor = false;
+            bestCorrelation = major;
+        }
+        if (minor > bestCorrelation)
+        {
+            best.tonic = tonic;
+            best.isMinor = true;
+            bestCorrelation = minor;
+        }
+    }
+    return best;
+}
+
+void KeyDetector::analyzeFrame()
+{
+    for (int i = 0; i < fftSize; ++i)
+    {
+        fftData[(size_t) i] = { frame[(size_t) i] * window[(size_t) i], 0.0f };
+    }
+    performFFT();
+
+    double frameChroma[12]{};
+    double total = 0;
+    for (int bin = 1; bin < fftSize / 2; ++bin)
+    {
+        auto pitchClass = binPitchClass[(size_t) bin];
+        if (pitchClass >= 0)
+        {
+            auto magnitude = (double) std::abs(fftData[(size_t) bin]);
+            frameChroma[pitchClass] += magnitude;
+            total += magnitude;
+        }
+    }
+
+    // each frame counts the same, so loud sections don't outvote the rest; near-silence doesn't count
+    if (total > 1.0e-3)
+    {
+        for (int i = 0; i < 12; ++i)
+        {
+            chroma[i] += frameChroma[i] / total;
+        }
+        ++numFrames;
+    }
+}
+
+void KeyDetector::performFFT()
+{
+    // bit-reversed order first
+    for (int i = 1, j = 0; i < fftSize; ++i)
+    {
+        auto bit = fftSize >> 1;
+        for (; (j & bit) != 0; bit >>= 1)
+        {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j)
+        {
+            std::swap(fftData[(size_t) i], fftData[(size_t) j]);
+        }
+    }
+
+    for (int length = 2; length <= fftSize; length <<= 1)
+    {
+        auto twiddleStep = fftSize / length;
+        for (int start = 0; start < fftSize; start += length)
+        {
+            for (int k = 0; k < length / 2; ++k)
+            {
+                auto even = fftData[(size_t) (start + k)];
+                auto odd = fftData[(size_t) (start + k + length / 2)] * twiddles[(size_t) (k * twiddleStep)];
+                fftData[(size_t) (start + k)] = even + odd;
+                fftData[(size_t) (start + k + length / 2)] = even - odd;
+            }
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <complex>
+#include <vector>
+#include "MusicalKey.h"
+
+//==============================================================================
+/*
+    Finds the key of a track fed in block by block.
+
+    The audio is decimated to about 11kHz, where the notes that carry the key
+    still are, and cut into overlapping frames for an FFT. Each frame's
+    spectrum between C2 and C7 is folded into the twelve pitch classes, and
+    the normalised frames are summed into a chromagram for the whole track.
+    The key is the major or minor Krumhansl-Kessler profile, rotated to each
+    tonic, that correlates best with it. Only the chromagram and one frame
+    are kept, whatever the length of the track.
+*/
+class KeyDetector
+{
+public:
+    explicit KeyDetector(double _sampleRate);
+    ~KeyDetector();
+
+    /**Feeds in the next block of the track, mixed down to mono*/
+    void process(const float* samples, int numSamples);
+    /**The best matching key, invalid if nothing tonal was fed in*/
+    MusicalKey getKey() const;
+
+private:
+    /**One section of the anti-aliasing lowpass, transposed direct form II*/
+    struct Biquad
+    {
+        double b0{ 1 }, b1{ 0 }, b2{ 0 }, a1{ 0 }, a2{ 0 };
+        double z1{ 0 }, z2{ 0 };
+
+        double process(double in)
+        {
+            auto out = b0 * in + z1;
+            z1 = b1 * in - a1 * out + z2;
+            z2 = b2 * in - a2 * out;
+            return out;
+        }
+    };
+
+    void analyzeFrame();
+    /**In-place radix-2 FFT of fftData*/
+    void performFFT();
+
+    static constexpr int fftOrder = 12;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = fftSize / 2;
+    static constexpr double targetRate = 11025.0;
+    static constexpr double minFreq = 65.4;
+    static constexpr double maxFreq = 2093.0;
+    static constexpr int numLowpassSections = 4;
+
+    int decimation;
+    double analysisRate;
+    // an 8th-order Butterworth lowpass well under the decimated Nyquist keeps aliases out of the notes
+    Biquad lowpass[numLowpassSections];
+    int decimationPos{ 0 };
+
+    std::vector<float> frame;
+    int framePos{ 0 };
+    std::vector<float> window;
+    std::vector<std::complex<float>> fftData;
+    std::vector<std::complex<float>> twiddles;
+    // the pitch class each FFT bin is folded into, -1 outside the range used
+    std::vector<int> binPitchClass;
+    double chroma[12]{};
+    int numFrames{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (KeyDetector)
+};
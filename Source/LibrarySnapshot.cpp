@@ -0,0 +1,676 @@
+#include <JuceHeader.h>
+#include "LibrarySnapshot.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <vector>
+
+namespace
+{
+    const int snapshotMagic = 0x4c4f544f; // "OTOL"
+    const int formatVersion = 4;
+    // the same but for the analysis stamps, so a section fewer
+    const int previousFormatVersion = 3;
+
+    // where each field is in the header; the section offsets follow one another from sectionsField
+    enum HeaderField
+    {
+        magicField = 0,
+        versionField = 4,
+        generationField = 8,
+        numRowsField = 16,
+        numFoldersField = 20,
+        numBpmEntriesField = 24,
+        numKeyEntriesField = 28,
+        nextTrackIdField = 32,
+        foldersChecksumField = 36,
+        stringsSizeField = 40,
+        sectionsField = 48,
+        headerChecksumField = 184
+    };
+
+    // a name is the folder it is in, then where the name is in the strings, its length and its title's
+    enum NameField
+    {
+        folderField = 0,
+        nameOffsetField = 4,
+        nameBytesField = 8,
+        titleBytesField = 10
+    };
+
+    // the columns from idColumn to analysisStampColumn laid end to end, which is what a row's checksum covers
+    enum RowImageField
+    {
+        idAt = 0,
+        nameAt = 4,
+        lengthAt = 16,
+        keyAt = 20,
+        bpmAt = 21,
+        firstBeatAt = 29,
+        cuesAt = 37,
+        fileSizeAt = 101,
+        modificationTimeAt = 109,
+        analysisStampAt = 117,
+        rowImageSize = 125
+    };
+
+    /**The size of a section's entries; the strings are counted in bytes*/
+    int getEntrySize(LibrarySnapshot::Section section)
+    {
+        switch (section)
+        {
+            case LibrarySnapshot::idColumn:               return 4;
+            case LibrarySnapshot::nameColumn:             return 12;
+            case LibrarySnapshot::lengthColumn:           return 4;
+            case LibrarySnapshot::keyColumn:              return 1;
+            case LibrarySnapshot::bpmColumn:              return 8;
+            case LibrarySnapshot::firstBeatColumn:        return 8;
+            case LibrarySnapshot::cuesColumn:             return 8 * HotCues::numCues;
+            case LibrarySnapshot::fileSizeColumn:         return 8;
+            case LibrarySnapshot::modificationTimeColumn: return 8;
+            case LibrarySnapshot::analysisStampColumn:    return 8;
+            case LibrarySnapshot::checksumColumn:         return 4;
+            case LibrarySnapshot::folderTable:            return 8;
+            case LibrarySnapshot::strings:                return 1;
+            case LibrarySnapshot::pathIndex:              return 16;
+            case LibrarySnapshot::titleIndex:             return 16;
+            case LibrarySnapshot::bpmIndex:               return 16;
+            case LibrarySnapshot::keyIndex:               return 8;
+            case LibrarySnapshot::numSections:            break;
+        }
+        return 0;
+    }
+
+    juce::uint32 getUInt32(const char* p)
+    {
+        return juce::ByteOrder::littleEndianInt(p);
+    }
+
+    juce::uint16 getUInt16(const char* p)
+    {
+        return juce::ByteOrder::littleEndianShort(p);
+    }
+
+    juce::int64 getInt64(const char* p)
+    {
+        return (juce::int64) juce::ByteOrder::littleEndianInt64(p);
+    }
+
+    double getDouble(const char* p)
+    {
+        auto bits = juce::ByteOrder::littleEndianInt64(p);
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    void putUInt32(char* p, juce::uint32 value)
+    {
+        value = juce::ByteOrder::swapIfBigEndian(value);
+        std::memcpy(p, &value, sizeof(value));
+    }
+
+    void putUInt16(char* p, juce::uint16 value)
+    {
+        value = juce::ByteOrder::swapIfBigEndian(value);
+        std::memcpy(p, &value, sizeof(value));
+    }
+
+    void putInt64(char* p, juce::int64 value)
+    {
+        auto bits = juce::ByteOrder::swapIfBigEndian((juce::uint64) value);
+        std::memcpy(p, &bits, sizeof(bits));
+    }
+
+    void putDouble(char* p, double value)
+    {
+        juce::uint64 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        putInt64(p, (juce::int64) bits);
+    }
+
+    juce::int64 alignTo8(juce::int64 offset)
+    {
+        return (offset + 7) & ~(juce::int64) 7;
+    }
+}
+
+//==============================================================================
+TrackRecord TrackRecord::fromSong(const Song& song)
+{
+    TrackRecord record;
+    record.path = song.file.getFullPathName();
+    record.lengthMs = song.lengthMs;
+    record.beatGrid = song.beatGrid;
+    record.hotCues = song.hotCues;
+    record.key = song.key;
+    record.fileSize = song.fileSize;
+    record.modificationTime = song.modificationTime;
+    return record;
+}
+
+Song TrackRecord::toSong() const
+{
+    Song song{ juce::File(path) };
+    song.lengthMs = lengthMs;
+    song.beatGrid = beatGrid;
+    song.hotCues = hotCues;
+    song.key = key;
+    song.fileSize = fileSize;
+    song.modificationTime = modificationTime;
+    return song;
+}
+
+//==============================================================================
+LibrarySnapshot::LibrarySnapshot()
+{
+}
+
+LibrarySnapshot::~LibrarySnapshot()
+{
+}
+
+bool LibrarySnapshot::open(const juce::File& file)
+{
+    close();
+    mappedFile = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+    data = static_cast<const char*>(mappedFile->getData());
+    dataSize = (juce::int64) mappedFile->getSize();
+
+    if (data == nullptr || dataSize < headerSize
+        || (int) getUInt32(data + magicField) != snapshotMagic)
+    {
+        close();
+        return false;
+    }
+    // the previous version's header is the same up to its one section fewer, then its checksum
+    auto version = (int) getUInt32(data + versionField);
+    hasAnalysisStamps = version == formatVersion;
+    auto checksumAt = hasAnalysisStamps ? (int) headerChecksumField : (int) headerChecksumField - 8;
+    if ((version != formatVersion && version != previousFormatVersion)
+        || getUInt32(data + checksumAt) != checksum(data, (size_t) checksumAt))
+    {
+        close();
+        return false;
+    }
+
+    generation = getInt64(data + generationField);
+    numRows = (int) getUInt32(data + numRowsField);
+    auto numFolders = (int) getUInt32(data + numFoldersField);
+    numBpmEntries = (int) getUInt32(data + numBpmEntriesField);
+    numKeyEntries = (int) getUInt32(data + numKeyEntriesField);
+    nextTrackId = getUInt32(data + nextTrackIdField);
+    stringsSize = getInt64(data + stringsSizeField);
+    for (int section = 0, stored = 0; section < numSections; ++section)
+    {
+        if (section == analysisStampColumn && !hasAnalysisStamps)
+        {
+            continue;
+        }
+        sectionOffsets[section] = getInt64(data + sectionsField + 8 * stored++);
+    }
+
+    // every section has to be inside the file, or the file was cut short
+    if (numRows < 0 || numFolders < 0 || numBpmEntries < 0 || numKeyEntries < 0 || stringsSize < 0)
+    {
+        close();
+        return false;
+    }
+    for (int section = 0; section < numSections; ++section)
+    {
+        if (section == analysisStampColumn && !hasAnalysisStamps)
+        {
+            continue;
+        }
+        auto numEntries = section == folderTable ? (juce::int64) numFolders
+                        : section == strings ? stringsSize
+                        : section == bpmIndex ? (juce::int64) numBpmEntries
+                        : section == keyIndex ? (juce::int64) numKeyEntries
+                        : (juce::int64) numRows;
+        auto size = numEntries * getEntrySize((Section) section);
+        if (sectionOffsets[section] < headerSize || sectionOffsets[section] + size > dataSize)
+        {
+            close();
+            return false;
+        }
+    }
+
+    // every path needs its folder, so a damaged folder table makes the whole snapshot unusable
+    const auto* table = data + sectionOffsets[folderTable];
+    auto sum = checksum(table, (size_t) numFolders * (size_t) getEntrySize(folderTable));
+    for (int i = 0; i < numFolders; ++i)
+    {
+        auto offset = getUInt32(table + 8 * i);
+        auto numBytes = getUInt32(table + 8 * i + 4);
+        if ((juce::int64) offset + numBytes > stringsSize)
+        {
+            close();
+            return false;
+        }
+        sum = checksum(data + sectionOffsets[strings] + offset, numBytes, sum);
+        folders.add(readString(offset, numBytes));
+    }
+    if (sum != getUInt32(data + foldersChecksumField))
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void LibrarySnapshot::close()
+{
+    mappedFile.reset();
+    data = nullptr;
+    dataSize = 0;
+    hasAnalysisStamps = true;
+    generation = 0;
+    nextTrackId = 1;
+    numRows = 0;
+    numBpmEntries = 0;
+    numKeyEntries = 0;
+    stringsSize = 0;
+    std::fill(std::begin(sectionOffsets), std::end(sectionOffsets), 0);
+    folders.clear();
+}
+
+bool LibrarySnapshot::isCurrentFormat() const
+{
+    return hasAnalysisStamps;
+}
+
+int LibrarySnapshot::getNumRows() const
+{
+    return numRows;
+}
+
+juce::int64 LibrarySnapshot::getGeneration() const
+{
+    return generation;
+}
+
+TrackId LibrarySnapshot::getNextTrackId() const
+{
+    return nextTrackId;
+}
+
+TrackRecord LibrarySnapshot::readRecord(int row) const
+{
+    TrackRecord record;
+    record.id = getId(row);
+
+    char image[rowImageSize] = {};
+    auto* field = image;
+    auto lastColumn = hasAnalysisStamps ? analysisStampColumn : modificationTimeColumn;
+    for (int column = idColumn; column <= lastColumn; ++column)
+    {
+        auto size = getEntrySize((Section) column);
+        std::memcpy(field, getField((Section) column, row), (size_t) size);
+        field += size;
+    }
+    auto imageSize = (size_t) (field - image);
+    auto folder = (int) getUInt32(image + nameAt + folderField);
+    auto nameOffset = getUInt32(image + nameAt + nameOffsetField);
+    auto nameBytes = getUInt16(image + nameAt + nameBytesField);
+    if (folder >= folders.size() || (juce::int64) nameOffset + nameBytes > stringsSize
+        || checksum(data + sectionOffsets[strings] + nameOffset, nameBytes, checksum(image, imageSize))
+               != getUInt32(getField(checksumColumn, row)))
+    {
+        DBG("LibrarySnapshot::readRecord row " << row << " is damaged");
+        return record;
+    }
+
+    record.path = folders[folder] + readString(nameOffset, nameBytes);
+    record.lengthMs = (int) getUInt32(image + lengthAt);
+    record.key = MusicalKey::fromIndex((juce::int8) image[keyAt]);
+    record.beatGrid.bpm = getDouble(image + bpmAt);
+    record.beatGrid.firstBeatSecs = getDouble(image + firstBeatAt);
+    for (int i = 0; i < HotCues::numCues; ++i)
+    {
+        record.hotCues.positions[i] = getDouble(image + cuesAt + 8 * i);
+    }
+    record.fileSize = getInt64(image + fileSizeAt);
+    record.modificationTime = getInt64(image + modificationTimeAt);
+    record.analysisStamp = getInt64(image + analysisStampAt);
+    return record;
+}
+
+TrackId LibrarySnapshot::getId(int row) const
+{
+    return getUInt32(getField(idColumn, row));
+}
+
+juce::String LibrarySnapshot::getPath(int row) const
+{
+    const auto* name = getField(nameColumn, row);
+    auto folder = (int) getUInt32(name + folderField);
+    if (folder >= folders.size())
+    {
+        return {};
+    }
+    return folders[folder] + readString(getUInt32(name + nameOffsetField), getUInt16(name + nameBytesField));
+}
+
+juce::String LibrarySnapshot::getTitle(int row) const
+{
+    const auto* name = getField(nameColumn, row);
+    return readString(getUInt32(name + nameOffsetField), getUInt16(name + titleBytesField));
+}
+
+int LibrarySnapshot::getLengthMs(int row) const
+{
+    return (int) getUInt32(getField(lengthColumn, row));
+}
+
+BeatGrid LibrarySnapshot::getBeatGrid(int row) const
+{
+    BeatGrid grid;
+    grid.bpm = getDouble(getField(bpmColumn, row));
+    grid.firstBeatSecs = getDouble(getField(firstBeatColumn, row));
+    return grid;
+}
+
+MusicalKey LibrarySnapshot::getKey(int row) const
+{
+    return MusicalKey::fromIndex((juce::int8) *getField(keyColumn, row));
+}
+
+juce::int64 LibrarySnapshot::getFileSize(int row) const
+{
+    return getInt64(getField(fileSizeColumn, row));
+}
+
+juce::int64 LibrarySnapshot::getModificationTime(int row) const
+{
+    return getInt64(getField(modificationTimeColumn, row));
+}
+
+juce::int64 LibrarySnapshot::getAnalysisStamp(int row) const
+{
+    return hasAnalysisStamps ? getInt64(getField(analysisStampColumn, row)) : 0;
+}
+
+int LibrarySnapshot::findId(TrackId id) const
+{
+    // rows are in order of their ids
+    int low = 0;
+    int high = numRows;
+    while (low < high)
+    {
+        auto middle = low + (high - low) / 2;
+        if (getId(middle) < id)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low < numRows && getId(low) == id ? low : -1;
+}
+
+int LibrarySnapshot::findPath(const juce::String& path) const
+{
+    auto hash = (juce::uint64) path.hashCode64();
+    auto rows = findInIndex(pathIndex, numRows, [hash](const char* entry)
+    {
+        auto entryHash = juce::ByteOrder::littleEndianInt64(entry);
+        return entryHash < hash ? -1 : (entryHash > hash ? 1 : 0);
+    });
+    // a hash can be shared, the path can't
+    for (auto row : rows)
+    {
+        if (getPath(row) == path)
+        {
+            return row;
+        }
+    }
+    return -1;
+}
+
+juce::Array<int> LibrarySnapshot::findTitle(const juce::String& title) const
+{
+    auto hash = (juce::uint64) title.hashCode64();
+    auto rows = findInIndex(titleIndex, numRows, [hash](const char* entry)
+    {
+        auto entryHash = juce::ByteOrder::littleEndianInt64(entry);
+        return entryHash < hash ? -1 : (entryHash > hash ? 1 : 0);
+    });
+    rows.removeIf([this, &title](int row) { return getTitle(row) != title; });
+    return rows;
+}
+
+juce::Array<int> LibrarySnapshot::findTempo(double minBpm, double maxBpm) const
+{
+    return findInIndex(bpmIndex, numBpmEntries, [minBpm, maxBpm](const char* entry)
+    {
+        auto bpm = getDouble(entry);
+        return bpm < minBpm ? -1 : (bpm > maxBpm ? 1 : 0);
+    });
+}
+
+juce::Array<int> LibrarySnapshot::findKey(const MusicalKey& key) const
+{
+    auto keyIndexValue = key.toIndex();
+    return findInIndex(keyIndex, numKeyEntries, [keyIndexValue](const char* entry)
+    {
+        auto entryKey = (int) getUInt32(entry);
+        return entryKey < keyIndexValue ? -1 : (entryKey > keyIndexValue ? 1 : 0);
+    });
+}
+
+juce::MemoryBlock LibrarySnapshot::build(juce::int64 generation, TrackId nextTrackId, int numRecords,
+                                         const std::function<TrackRecord(int)>& getRecord)
+{
+    juce::MemoryOutputStream sections[numSections];
+    juce::StringArray folderList;
+    std::map<juce::String, int> folderIds;
+    std::vector<juce::uint32> folderOffsets;
+    std::vector<std::pair<juce::uint64, int>> pathHashes;
+    std::vector<std::pair<juce::uint64, int>> titleHashes;
+    std::vector<std::pair<double, int>> bpms;
+    std::vector<std::pair<int, int>> keys;
+
+    auto& stringData = sections[strings];
+    auto addString = [&stringData](const juce::String& text)
+    {
+        auto offset = (juce::uint32) stringData.getDataSize();
+        stringData.write(text.toRawUTF8(), text.getNumBytesAsUTF8());
+        return offset;
+    };
+
+    TrackId lastId = 0;
+    for (int i = 0; i < numRecords; ++i)
+    {
+        auto record = getRecord(i);
+        jassert (record.id > lastId);
+        lastId = record.id;
+
+        // the folder keeps its trailing separator, so the folder and name put back together are the path exactly
+        auto folder = record.path.upToLastOccurrenceOf(juce::File::getSeparatorString(), true, false);
+        auto name = record.path.substring(folder.length());
+        auto title = juce::File(record.path).getFileNameWithoutExtension();
+        auto folderId = folderIds.find(folder);
+        if (folderId == folderIds.end())
+        {
+            folderId = folderIds.emplace(folder, folderList.size()).first;
+            folderList.add(folder);
+            folderOffsets.push_back(addString(folder));
+        }
+
+        char image[rowImageSize] = {};
+        auto nameBytes = (juce::uint16) juce::jmin((size_t) 65535, name.getNumBytesAsUTF8());
+        putUInt32(image + idAt, record.id);
+        putUInt32(image + nameAt + folderField, (juce::uint32) folderId->second);
+        putUInt32(image + nameAt + nameOffsetField, addString(name));
+        putUInt16(image + nameAt + nameBytesField, nameBytes);
+        putUInt16(image + nameAt + titleBytesField,
+                  name.startsWith(title) ? (juce::uint16) title.getNumBytesAsUTF8() : nameBytes);
+        putUInt32(image + lengthAt, (juce::uint32) record.lengthMs);
+        image[keyAt] = (char) record.key.toIndex();
+        putDouble(image + bpmAt, record.beatGrid.bpm);
+        putDouble(image + firstBeatAt, record.beatGrid.firstBeatSecs);
+        for (int cue = 0; cue < HotCues::numCues; ++cue)
+        {
+            putDouble(image + cuesAt + 8 * cue, record.hotCues.positions[cue]);
+        }
+        putInt64(image + fileSizeAt, record.fileSize);
+        putInt64(image + modificationTimeAt, record.modificationTime);
+        putInt64(image + analysisStampAt, record.analysisStamp);
+
+        const auto* field = image;
+        for (int column = idColumn; column <= analysisStampColumn; ++column)
+        {
+            auto size = getEntrySize((Section) column);
+            sections[column].write(field, (size_t) size);
+            field += size;
+        }
+        char rowChecksum[4];
+        putUInt32(rowChecksum, checksum(name.toRawUTF8(), nameBytes, checksum(image, rowImageSize)));
+        sections[checksumColumn].write(rowChecksum, sizeof(rowChecksum));
+
+        pathHashes.push_back({ (juce::uint64) record.path.hashCode64(), i });
+        titleHashes.push_back({ (juce::uint64) title.hashCode64(), i });
+        if (record.beatGrid.isValid())
+        {
+            bpms.push_back({ record.beatGrid.bpm, i });
+        }
+        if (record.key.isValid())
+        {
+            keys.push_back({ record.key.toIndex(), i });
+        }
+    }
+    std::sort(pathHashes.begin(), pathHashes.end());
+    std::sort(titleHashes.begin(), titleHashes.end());
+    std::sort(bpms.begin(), bpms.end());
+    std::sort(keys.begin(), keys.end());
+
+    auto& table = sections[folderTable];
+    for (int i = 0; i < folderList.size(); ++i)
+    {
+        char entry[8];
+        putUInt32(entry, folderOffsets[(size_t) i]);
+        putUInt32(entry + 4, (juce::uint32) folderList[i].getNumBytesAsUTF8());
+        table.write(entry, sizeof(entry));
+    }
+    auto foldersChecksum = checksum(table.getData(), table.getDataSize());
+    for (const auto& folder : folderList)
+    {
+        foldersChecksum = checksum(folder.toRawUTF8(), folder.getNumBytesAsUTF8(), foldersChecksum);
+    }
+    for (const auto& hashes : { std::make_pair(&pathHashes, pathIndex), std::make_pair(&titleHashes, titleIndex) })
+    {
+        for (const auto& entry : *hashes.first)
+        {
+            char indexEntry[16] = {};
+            putInt64(indexEntry, (juce::int64) entry.first);
+            putUInt32(indexEntry + 8, (juce::uint32) entry.second);
+            sections[hashes.second].write(indexEntry, sizeof(indexEntry));
+        }
+    }
+    for (const auto& entry : bpms)
+    {
+        char indexEntry[16] = {};
+        putDouble(indexEntry, entry.first);
+        putUInt32(indexEntry + 8, (juce::uint32) entry.second);
+        sections[bpmIndex].write(indexEntry, sizeof(indexEntry));
+    }
+    for (const auto& entry : keys)
+    {
+        char indexEntry[8] = {};
+        putUInt32(indexEntry, (juce::uint32) entry.first);
+        putUInt32(indexEntry + 4, (juce::uint32) entry.second);
+        sections[keyIndex].write(indexEntry, sizeof(indexEntry));
+    }
+
+    char header[headerSize] = {};
+    putUInt32(header + magicField, (juce::uint32) snapshotMagic);
+    putUInt32(header + versionField, (juce::uint32) formatVersion);
+    putInt64(header + generationField, generation);
+    putUInt32(header + numRowsField, (juce::uint32) numRecords);
+    putUInt32(header + numFoldersField, (juce::uint32) folderList.size());
+    putUInt32(header + numBpmEntriesField, (juce::uint32) bpms.size());
+    putUInt32(header + numKeyEntriesField, (juce::uint32) keys.size());
+    putUInt32(header + nextTrackIdField, nextTrackId);
+    putUInt32(header + foldersChecksumField, foldersChecksum);
+    putInt64(header + stringsSizeField, (juce::int64) stringData.getDataSize());
+    auto offset = (juce::int64) headerSize;
+    for (int section = 0; section < numSections; ++section)
+    {
+        putInt64(header + sectionsField + 8 * section, offset);
+        offset = alignTo8(offset + (juce::int64) sections[section].getDataSize());
+    }
+    putUInt32(header + headerChecksumField, checksum(header, headerChecksumField));
+
+    juce::MemoryOutputStream out;
+    out.preallocate((size_t) offset);
+    out.write(header, headerSize);
+    for (int section = 0; section < numSections; ++section)
+    {
+        auto size = (juce::int64) sections[section].getDataSize();
+        out.write(sections[section].getData(), (size_t) size);
+        out.writeRepeatedByte(0, (size_t) (alignTo8(size) - size));
+    }
+    return out.getMemoryBlock();
+}
+
+juce::uint32 LibrarySnapshot::checksum(const void* data, size_t numBytes, juce::uint32 hash)
+{
+    for (size_t i = 0; i < numBytes; ++i)
+    {
+        hash = (hash ^ static_cast<const juce::uint8*>(data)[i]) * 16777619u;
+    }
+    return hash;
+}
+
+const char* LibrarySnapshot::getField(Section column, int row) const
+{
+    jassert (row >= 0 && row < numRows);
+    return data + sectionOffsets[column] + (juce::int64) row * getEntrySize(column);
+}
+
+juce::String LibrarySnapshot::readString(juce::uint32 offset, juce::uint32 numBytes) const
+{
+    if ((juce::int64) offset + numBytes > stringsSize)
+    {
+        return {};
+    }
+    return juce::String::fromUTF8(data + sectionOffsets[strings] + offset, (int) numBytes);
+}
+
+juce::Array<int> LibrarySnapshot::findInIndex(Section index, int numEntries,
+                                              const std::function<int(const char* entry)>& compareToRange) const
+{
+    auto entrySize = getEntrySize(index);
+    const auto* entries = data + sectionOffsets[index];
+
+    // the first entry that isn't below the range
+    int low = 0;
+    int high = numEntries;
+    while (low < high)
+    {
+        auto middle = low + (high - low) / 2;
+        if (compareToRange(entries + (juce::int64) middle * entrySize) < 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    // the row follows the 4-byte key of a key entry and the 8-byte one of the rest
+    auto rowOffset = index == keyIndex ? 4 : 8;
+    juce::Array<int> rows;
+    for (auto i = low; i < numEntries && compareToRange(entries + (juce::int64) i * entrySize) == 0; ++i)
+    {
+        auto row = (int) getUInt32(entries + (juce::int64) i * entrySize + rowOffset);
+        if (row >= 0 && row < numRows)
+        {
+            rows.add(row);
+        }
+    }
+    return rows;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Song.h"
+
+/**A track keeps the id it was given when it was added for as long as it is in the library.
+*  Ids only ever grow, and 0 is never given out*/
+using TrackId = juce::uint32;
+
+//==============================================================================
+/*
+    What the library stores about a track. A Song is only built from it when
+    the track is shown or used.
+*/
+struct TrackRecord
+{
+    TrackId id = 0;
+    juce::String path;
+    int lengthMs = 0;
+    BeatGrid beatGrid;
+    HotCues hotCues;
+    MusicalKey key;
+    juce::int64 fileSize = 0;
+    juce::int64 modificationTime = 0;
+    // the modification time of the file when it was last analyzed, 0 if it never was
+    juce::int64 analysisStamp = 0;
+
+    static TrackRecord fromSong(const Song& song);
+    Song toSong() const;
+};
+
+//==============================================================================
+/*
+    The library's snapshot file, memory-mapped so opening it only reads its
+    header and folder table, and a track is paged in when it is first used.
+
+    The tracks are stored a column per field rather than a row per track, so
+    the nth value of a field is found without reading anything else, and a
+    pass over the tempos or keys of every track reads only those. A path is
+    stored as one of a table of folders and the file name, and the title is
+    the start of the name, so no string is stored twice. The snapshot
+    carries its own indexes, sorted so a lookup is a binary search touching
+    a few pages: the hashes of paths and of titles, tempos and keys. Tracks
+    are in order of their ids, so the ids need no index of their own. Each
+    track has a checksum, checked when its whole record is read.
+
+    Snapshots of the previous version, which had no analysis stamps, are
+    still read, with every stamp 0.
+*/
+class LibrarySnapshot
+{
+public:
+    LibrarySnapshot();
+    ~LibrarySnapshot();
+
+    /**Maps a snapshot file, false if it isn't one or is cut short*/
+    bool open(const juce::File& file);
+    /**false for a snapshot of the previous version, which should be rewritten*/
+    bool isCurrentFormat() const;
+    void close();
+    int getNumRows() const;
+    juce::int64 getGeneration() const;
+    /**The id the next track added will get*/
+    TrackId getNextTrackId() const;
+
+    /**The whole record, with only the id set if the row is damaged*/
+    TrackRecord readRecord(int row) const;
+    TrackId getId(int row) const;
+    juce::String getPath(int row) const;
+    juce::String getTitle(int row) const;
+    int getLengthMs(int row) const;
+    BeatGrid getBeatGrid(int row) const;
+    MusicalKey getKey(int row) const;
+    juce::int64 getFileSize(int row) const;
+    juce::int64 getModificationTime(int row) const;
+    juce::int64 getAnalysisStamp(int row) const;
+
+    /**The row of the track with this id, or -1*/
+    int findId(TrackId id) const;
+    /**The row with this path, or -1*/
+    int findPath(const juce::String& path) const;
+    /**Rows with this title*/
+    juce::Array<int> findTitle(const juce::String& title) const;
+    /**Rows with a tempo in the range, slowest first*/
+    juce::Array<int> findTempo(double minBpm, double maxBpm) const;
+    /**Rows in a key*/
+    juce::Array<int> findKey(const MusicalKey& key) const;
+
+    /**The contents of a snapshot holding these records, in order of ascending id*/
+    static juce::MemoryBlock build(juce::int64 generation, TrackId nextTrackId, int numRecords,
+                                   const std::function<TrackRecord(int)>& getRecord);
+    /**FNV-1a, enough to tell data that was cut short or overwritten*/
+    static juce::uint32 checksum(const void* data, size_t numBytes, juce::uint32 hash = 2166136261u);
+
+    static constexpr int headerSize = 192;
+
+    /**The parts of a snapshot after the header, each starting 8-byte aligned*/
+    enum Section
+    {
+        idColumn,
+        nameColumn,
+        lengthColumn,
+        keyColumn,
+        bpmColumn,
+        firstBeatColumn,
+        cuesColumn,
+        fileSizeColumn,
+        modificationTimeColumn,
+        analysisStampColumn,
+        checksumColumn,
+        folderTable,
+        strings,
+        pathIndex,
+        titleIndex,
+        bpmIndex,
+        keyIndex,
+        numSections
+    };
+
+private:
+    const char* getField(Section column, int row) const;
+    juce::String readString(juce::uint32 offset, juce::uint32 numBytes) const;
+    /**The rows in a sorted index whose keys lie in a range*/
+    juce::Array<int> findInIndex(Section index, int numEntries,
+                                 const std::function<int(const char* entry)>& compareToRange) const;
+
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    const char* data{ nullptr };
+    juce::int64 dataSize{ 0 };
+    bool hasAnalysisStamps{ true };
+    juce::int64 generation{ 0 };
+    TrackId nextTrackId{ 1 };
+    int numRows{ 0 };
+    int numBpmEntries{ 0 };
+    int numKeyEntries{ 0 };
+    juce::int64 stringsSize{ 0 };
+    juce::int64 sectionOffsets[numSections] = {};
+    // the folders every path starts with, read whole when the snapshot is opened
+    juce::StringArray folders;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LibrarySnapshot)
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "ReadAheadSource.h"
+#include "MappedAudioSource.h"
+#include "PreloadedAudioSource.h"
+
+//==============================================================================
+/*
+    Everything a deck needs to play one file. Built off the audio thread by the
+    loader, then handed to the deck's transport in one piece.
+*/
+struct LoadedTrack
+{
+    juce::URL url;
+    /**Set by DeckTransport::setTrack, different for every track it is given*/
+    juce::uint32 serial = 0;
+    double sampleRate = 0;
+    juce::int64 lengthInSamples = 0;
+    /**What the source was last prepared with, 0 if it hasn't been*/
+    int preparedBlockSize = 0;
+    double preparedSampleRate = 0;
+
+    // set instead of the others when the whole track is decoded in RAM
+    std::unique_ptr<PreloadedAudioSource> memorySource;
+    // set instead of the streamed sources when the file is played from a memory mapping
+    std::unique_ptr<MappedAudioSource> mappedSource;
+    std::unique_ptr<juce::AudioFormatReaderSource> readerSource;
+    // declared after readerSource so it is destroyed first; null when rendering offline
+    std::unique_ptr<ReadAheadSource> readAheadSource;
+
+    /**The source the transport reads from*/
+    juce::PositionableAudioSource* getSource() const
+    {
+        if (memorySource != nullptr)
+        {
+            return memorySource.get();
+        }
+        if (mappedSource != nullptr)
+        {
+            return mappedSource.get();
+        }
+        if (readAheadSource != nullptr)
+        {
+            return readAheadSource.get();
+        }
+        return readerSource.get();
+    }
+
+    /**Prepares the source unless it already was with these settings*/
+    void prepare(int blockSize, double rate)
+    {
+        if (blockSize != preparedBlockSize || rate != preparedSampleRate)
+        {
+            getSource()->prepareToPlay(blockSize, rate);
+            preparedBlockSize = blockSize;
+            preparedSampleRate = rate;
+        }
+    }
+};
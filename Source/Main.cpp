@@ -1,6 +1,7 @@
 
 #include <JuceHeader.h>
 #include "MainComponent.h"
+#include "OfflineRenderer.h"
 
 //==============================================================================
 class OtoDecksApplication  : public juce::JUCEApplication
@@ -18,6 +19,14 @@ public:
     {
         // This method is where you should put your application's initialisation code..
 
+        // headless export: render the session and exit without opening a window
+        if (commandLine.contains("--render"))
+        {
+            setApplicationReturnValue(OfflineRenderer::runFromCommandLine(commandLine));
+            quit();
+            return;
+        }
+
         mainWindow.reset (new MainWindow (getApplicationName()));
     }
 
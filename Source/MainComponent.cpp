@@ -6,7 +6,7 @@ MainComponent::MainComponent()
 {
     // Make sure you set the size of the component after
     // you add any child components.
-    setSize (944, 600);
+    setSize (1280, 800);
 
     // Some platforms require permissions to open input channels so request that here
     if (juce::RuntimePermissions::isRequired (juce::RuntimePermissions::recordAudio)
@@ -21,9 +21,35 @@ MainComponent::MainComponent()
         setAudioChannels (2, 2);
     }
 
-    addAndMakeVisible(deckGUI1);
-    addAndMakeVisible(deckGUI2);
     addAndMakeVisible(playlistComponent);
+    addAndMakeVisible(telemetryPanel);
+    addAndMakeVisible(addDeckButton);
+    addAndMakeVisible(removeDeckButton);
+    addAndMakeVisible(clockSlider);
+
+    addDeckButton.setColour(juce::ComboBox::outlineColourId, juce::Colours::deepskyblue);
+    addDeckButton.setColour(juce::TextButton::textColourOffId, juce::Colours::deepskyblue);
+    removeDeckButton.setColour(juce::ComboBox::outlineColourId, juce::Colours::deepskyblue);
+    removeDeckButton.setColour(juce::TextButton::textColourOffId, juce::Colours::deepskyblue);
+    addDeckButton.addListener(this);
+    removeDeckButton.addListener(this);
+
+    // the sync clock's tempo, used while no master deck is playing
+    clockSlider.setRange(SyncEngine::minTempo, SyncEngine::maxTempo, 0.1);
+    clockSlider.setTextBoxStyle(juce::Slider::TextBoxLeft, false, 80, buttonHeight);
+    clockSlider.setTextValueSuffix(" BPM");
+    clockSlider.setValue(syncEngine.getTempo(), juce::dontSendNotification);
+    clockSlider.setTooltip("Sync clock tempo, followed by synced decks while no master deck plays");
+    clockSlider.addListener(this);
+    mixer.setSyncEngine(&syncEngine);
+    startTimerHz(4);
+
+    deckManager.addChangeListener(this);
+    for (int i = 0; i < defaultNumDecks; ++i)
+    {
+        deckManager.addDeck();
+    }
+    showDecks();
 
     formatManager.registerBasicFormats();
 }
@@ -31,7 +57,9 @@ MainComponent::MainComponent()
 MainComponent::~MainComponent()
 {
     // This shuts down the audio device and clears the audio source.
+    stopTimer();
     shutdownAudio();
+    deckManager.removeChangeListener(this);
 }
 
 //==============================================================================
@@ -45,15 +73,15 @@ void MainComponent::prepareToPlay (int samplesPerBlockExpected, double sampleRat
 
     // For more details, see the help for AudioProcessor::prepareToPlay()
 
-    mixerSource.addInputSource(&player1, false);
-    mixerSource.addInputSource(&player2, false);
-    player1.prepareToPlay(samplesPerBlockExpected, sampleRate);
-    player2.prepareToPlay(samplesPerBlockExpected, sampleRate);
-
+    telemetry.prepare(sampleRate);
+    syncEngine.prepare(sampleRate);
+    mixer.prepareToPlay(samplesPerBlockExpected, sampleRate);
 }
 void MainComponent::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
 {
-    mixerSource.getNextAudioBlock(bufferToFill);
+    auto startTicks = telemetry.beginBlock();
+    mixer.getNextAudioBlock(bufferToFill);
+    telemetry.endBlock(startTicks, bufferToFill.numSamples);
 }
 
 void MainComponent::releaseResources()
@@ -62,10 +90,7 @@ void MainComponent::releaseResources()
     // restarted due to a setting change.
 
     // For more details, see the help for AudioProcessor::releaseResources()
-    mixerSource.removeAllInputs();
-    mixerSource.releaseResources();
-    player1.releaseResources();
-    player2.releaseResources();
+    mixer.releaseResources();
 }
 
 //==============================================================================
@@ -81,8 +106,76 @@ void MainComponent::resized()
 {
     int columns = 100;
     auto playlistWidth = 28* getWidth() / columns;
-    auto deckRight = getWidth() - playlistWidth;
-    playlistComponent.setBounds(getWidth() - playlistWidth, 0, playlistWidth, getHeight());
-    deckGUI1.setBounds(0, 0, getWidth() - playlistWidth, getHeight() / 2);
-    deckGUI2.setBounds(0, getHeight() / 2, getWidth() - playlistWidth, getHeight() / 2);
-}
\ No newline at end of file
+    auto deckWidth = getWidth() - playlistWidth;
+    playlistComponent.setBounds(deckWidth, 0, playlistWidth, getHeight() - telemetryHeight);
+    telemetryPanel.setBounds(deckWidth, getHeight() - telemetryHeight, playlistWidth, telemetryHeight);
+    addDeckButton.setBounds(0, getHeight() - buttonHeight, deckWidth / 3, buttonHeight);
+    removeDeckButton.setBounds(deckWidth / 3, getHeight() - buttonHeight, deckWidth / 3, buttonHeight);
+    clockSlider.setBounds(2 * deckWidth / 3, getHeight() - buttonHeight, deckWidth - 2 * deckWidth / 3, buttonHeight);
+
+    // one column for two decks, then a grid two decks wide
+    auto numDecks = deckManager.getNumDecks();
+    auto deckColumns = numDecks > 2 ? 2 : 1;
+    auto deckRows = juce::jmax(1, (numDecks + deckColumns - 1) / deckColumns);
+    auto deckAreaHeight = getHeight() - buttonHeight;
+    for (int i = 0; i < numDecks; ++i)
+    {
+        auto column = i % deckColumns;
+        auto row = i / deckColumns;
+        deckManager.getDeckGUI(i)->setBounds(column * deckWidth / deckColumns,
+                                             row * deckAreaHeight / deckRows,
+                                             deckWidth / deckColumns,
+                                             deckAreaHeight / deckRows);
+    }
+}
+
+void MainComponent::buttonClicked(juce::Button* button)
+{
+    if (button == &addDeckButton)
+    {
+        DBG("Add deck button was clicked ");
+        deckManager.addDeck();
+    }
+    if (button == &removeDeckButton)
+    {
+        DBG("Remove deck button was clicked ");
+        deckManager.removeLastDeck();
+    }
+}
+
+void MainComponent::sliderValueChanged(juce::Slider* slider)
+{
+    if (slider == &clockSlider)
+    {
+        DBG("Clock slider moved " << slider->getValue());
+        syncEngine.setTempo(slider->getValue());
+    }
+}
+
+void MainComponent::timerCallback()
+{
+    // while dragging, the slider is what sets the tempo
+    if (!clockSlider.isMouseButtonDown())
+    {
+        clockSlider.setValue(syncEngine.getTempo(), juce::dontSendNotification);
+    }
+}
+
+void MainComponent::changeListenerCallback(juce::ChangeBroadcaster* source)
+{
+    if (source == &deckManager)
+    {
+        showDecks();
+    }
+}
+
+void MainComponent::showDecks()
+{
+    for (int i = 0; i < deckManager.getNumDecks(); ++i)
+    {
+        addAndMakeVisible(deckManager.getDeckGUI(i));
+    }
+    addDeckButton.setEnabled(deckManager.getNumDecks() < DeckManager::maxDecks);
+    removeDeckButton.setEnabled(deckManager.getNumDecks() > DeckManager::minDecks);
+    resized();
+}
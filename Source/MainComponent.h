@@ -4,14 +4,26 @@
 #include <juce_gui_basics\juce_gui_basics.h>
 #include "DJAudioPlayer.h"
 #include "DeckGUI.h"
+#include "DeckManager.h"
+#include "DeckMixer.h"
 #include "PlaylistComponent.h"
+#include "AudioTelemetry.h"
+#include "TelemetryPanel.h"
+#include "TrackAnalyzer.h"
+#include "MetadataScanner.h"
+#include "FolderScanner.h"
+#include "SyncEngine.h"
 
 //==============================================================================
 /*
     This component lives inside our window, and this is where you should put all
     your controls and content.
 */
-class MainComponent  : public juce::AudioAppComponent
+class MainComponent  : public juce::AudioAppComponent,
+                       public juce::Button::Listener,
+                       public juce::Slider::Listener,
+                       public juce::ChangeListener,
+                       private juce::Timer
 {
 public:
     //==============================================================================
@@ -27,6 +39,12 @@ public:
     void paint (juce::Graphics& g) override;
     void resized() override;
 
+    void buttonClicked(juce::Button* button) override;
+    /**Sets the sync clock's tempo*/
+    void sliderValueChanged(juce::Slider* slider) override;
+    /**Lays the decks out again after one is added or removed*/
+    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
+
 private:
     //==============================================================================
     // Your private member variables go here...
@@ -34,13 +52,45 @@ private:
     juce::AudioFormatManager formatManager;
     juce::AudioThumbnailCache thumbCache{100};
 
-    DJAudioPlayer player1{formatManager};
-    DJAudioPlayer player2{formatManager};
-    DJAudioPlayer playerForParsingMetaData{formatManager};
-    DeckGUI deckGUI1{1, &player1, formatManager, thumbCache};
-    DeckGUI deckGUI2{2, &player2, formatManager, thumbCache};
-    PlaylistComponent playlistComponent{ &deckGUI1, &deckGUI2, &playerForParsingMetaData };
+    ReadAheadPool readAheadPool;
+
+    static constexpr juce::int64 decodeCacheBytes = (juce::int64) 2 << 30;
+    DecodeCache decodeCache{ formatManager, DecodeCache::getDefaultDirectory(), decodeCacheBytes };
+
+    // shared by every deck in preload mode and the playlist's preloads
+    static constexpr juce::int64 preloadBudgetBytes = (juce::int64) 1536 << 20;
+    PreloadCache preloadCache{ formatManager, preloadBudgetBytes, &decodeCache };
+
+    // leaves a core for the audio and the GUI
+    TrackAnalyzer trackAnalyzer{ formatManager, TrackAnalyzer::getDefaultNumThreads() };
+
+    // reading headers mostly waits on the disk, so more threads than cores still helps
+    static constexpr int metadataScanThreads = 8;
+    MetadataScanner metadataScanner{ formatManager, metadataScanThreads };
+    FolderScanner folderScanner{ formatManager, metadataScanThreads };
+
+    static constexpr int defaultNumDecks = 4;
+
+    /**Shows any new decks and lays them all out*/
+    void showDecks();
+    /**Shows the sync clock's tempo, which follows the master deck*/
+    void timerCallback() override;
+
+    static constexpr int telemetryHeight = 260;
+    static constexpr int buttonHeight = 24;
+
+    // declared before the decks so they outlive them
+    AudioTelemetry telemetry;
+    SyncEngine syncEngine;
+    DeckMixer mixer;
+    DeckManager deckManager{ mixer, telemetry, readAheadPool, decodeCache, preloadCache, syncEngine,
+                             formatManager, thumbCache };
+    PlaylistComponent playlistComponent{ deckManager, metadataScanner, folderScanner, preloadCache, trackAnalyzer };
+    TelemetryPanel telemetryPanel{ telemetry, mixer, deckManager, deviceManager };
+
+    juce::TextButton addDeckButton{ "+ DECK" };
+    juce::TextButton removeDeckButton{ "- DECK" };
+    juce::Slider clockSlider;
 
-    juce::MixerAudioSource mixerSource;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainComponent)
 };
@@ -0,0 +1,162 @@
+#include <JuceHeader.h>
+#include "MappedAudioSource.h"
+
+#if JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#else
+ #include <unistd.h>
+#endif
+
+//==============================================================================
+std::unique_ptr<MappedAudioSource> MappedAudioSource::create(juce::AudioFormatManager& formatManager,
+                                                             const juce::File& file,
+                                                             juce::TimeSliceThread* prefaultThread,
+                                                             int prefaultAheadSamples)
+{
+    auto* format = formatManager.findFormatForFileExtension(file.getFileExtension());
+    if (format == nullptr)
+    {
+        return nullptr;
+    }
+
+    // only the uncompressed formats implement this, the rest return nullptr
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader(format->createMemoryMappedReader(file));
+    if (reader == nullptr)
+    {
+        return nullptr;
+    }
+    if (reader->lengthInSamples <= 0 || !reader->mapEntireFile())
+    {
+        DBG("MappedAudioSource::create could not map " << file.getFileName());
+        return nullptr;
+    }
+    return std::unique_ptr<MappedAudioSource>(new MappedAudioSource(reader.release(), prefaultThread,
+                                                                    prefaultAheadSamples));
+}
+
+MappedAudioSource::MappedAudioSource(juce::MemoryMappedAudioFormatReader* _reader,
+                                     juce::TimeSliceThread* _prefaultThread,
+                                     int _prefaultAheadSamples
+                                    ) : reader(_reader),
+                                        prefaultThread(_prefaultThread),
+                                        prefaultAheadSamples(_prefaultAheadSamples)
+{
+    auto bytesPerFrame = juce::jmax(1, (int) (reader->numChannels * reader->bitsPerSample / 8));
+    samplesPerPage = juce::jmax(1, getPageSize() / bytesPerFrame);
+}
+
+int MappedAudioSource::getPageSize()
+{
+    // 4KB on x86 and most Linux, but 16KB on Apple silicon, so ask the OS
+    static const int pageSize = []
+    {
+       #if JUCE_WINDOWS
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        auto size = (long) info.dwPageSize;
+       #else
+        auto size = sysconf(_SC_PAGESIZE);
+       #endif
+        return size > 0 ? (int) size : 4096;
+    }();
+    return pageSize;
+}
+
+MappedAudioSource::~MappedAudioSource()
+{
+    releaseResources();
+}
+
+void MappedAudioSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    if (prefaultThread != nullptr && !isPrepared)
+    {
+        prefaultThread->addTimeSliceClient(this);
+    }
+    isPrepared = true;
+}
+
+void MappedAudioSource::releaseResources()
+{
+    if (prefaultThread != nullptr && isPrepared)
+    {
+        prefaultThread->removeTimeSliceClient(this);
+    }
+    isPrepared = false;
+}
+
+void MappedAudioSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    auto pos = playPos.load(std::memory_order_relaxed);
+    auto numValid = (int) juce::jlimit((juce::int64) 0, (juce::int64) bufferToFill.numSamples,
+                                       reader->lengthInSamples - pos);
+    if (numValid > 0)
+    {
+        // converts straight from the mapped pages; a mono file fills both channels
+        reader->read(bufferToFill.buffer, bufferToFill.startSample, numValid, pos, true, true);
+    }
+    if (numValid < bufferToFill.numSamples)
+    {
+        bufferToFill.buffer->clear(bufferToFill.startSample + numValid, bufferToFill.numSamples - numValid);
+    }
+    playPos.store(pos + bufferToFill.numSamples, std::memory_order_release);
+}
+
+void MappedAudioSource::setNextReadPosition(juce::int64 newPosition)
+{
+    playPos.store(juce::jmax((juce::int64) 0, newPosition), std::memory_order_release);
+}
+
+juce::int64 MappedAudioSource::getNextReadPosition() const
+{
+    return playPos.load();
+}
+
+juce::int64 MappedAudioSource::getTotalLength() const
+{
+    return reader->lengthInSamples;
+}
+
+bool MappedAudioSource::isLooping() const
+{
+    return false;
+}
+
+void MappedAudioSource::prefault(juce::int64 startSample, juce::int64 numSamples) const
+{
+    auto end = juce::jmin(startSample + numSamples, reader->lengthInSamples);
+    for (auto sample = juce::jmax((juce::int64) 0, startSample); sample < end; sample += samplesPerPage)
+    {
+        reader->touchSample(sample);
+    }
+}
+
+double MappedAudioSource::getSampleRate() const
+{
+    return reader->sampleRate;
+}
+
+const juce::File& MappedAudioSource::getFile() const
+{
+    return reader->getFile();
+}
+
+// prefault thread: the window ahead of the playhead first, then the next stretch of the sweep
+int MappedAudioSource::useTimeSlice()
+{
+    // touching pages that are already resident is only a memory read, so the window is cheap to repeat
+    prefault(playPos.load(std::memory_order_acquire), prefaultAheadSamples);
+
+    if (sweepPos >= reader->lengthInSamples)
+    {
+        return 20;
+    }
+    // about 1MB a slice, so the sweep doesn't hog the disk the other decks read from
+    auto sweepSamples = (juce::int64) samplesPerPage * 256;
+    prefault(sweepPos, sweepSamples);
+    sweepPos += sweepSamples;
+    return 2;
+}
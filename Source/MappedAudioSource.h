@@ -0,0 +1,67 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Plays an uncompressed file (WAV or AIFF) straight from a memory mapping of
+    the whole file. Reads convert the samples in place from the mapped pages,
+    with no stream or ring buffer in between, and a seek is just a new
+    position.
+
+    Reading a page that is not yet in RAM would stall the audio thread on the
+    disk, so a background TimeSliceThread keeps touching the pages just ahead
+    of the playhead, and in between works through the rest of the file. Soon
+    after loading the whole track is resident and cues and seeks land on
+    pages that are already there.
+*/
+class MappedAudioSource  : public juce::PositionableAudioSource,
+                           private juce::TimeSliceClient
+{
+public:
+    /**Maps the file with the format's memory-mapped reader. Returns nullptr if the format
+    *  can't be mapped, e.g. because it is compressed, or the mapping fails.
+    *  Without a thread nothing is prefaulted in the background, e.g. for offline rendering*/
+    static std::unique_ptr<MappedAudioSource> create(juce::AudioFormatManager& formatManager,
+                                                     const juce::File& file,
+                                                     juce::TimeSliceThread* prefaultThread,
+                                                     int prefaultAheadSamples);
+    ~MappedAudioSource() override;
+
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+    void releaseResources() override;
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+    void setNextReadPosition(juce::int64 newPosition) override;
+    juce::int64 getNextReadPosition() const override;
+    juce::int64 getTotalLength() const override;
+    bool isLooping() const override;
+
+    /**Any thread: touches every page of a range so reading it won't have to wait for the disk*/
+    void prefault(juce::int64 startSample, juce::int64 numSamples) const;
+    double getSampleRate() const;
+    const juce::File& getFile() const;
+
+private:
+    MappedAudioSource(juce::MemoryMappedAudioFormatReader* _reader,
+                      juce::TimeSliceThread* _prefaultThread,
+                      int _prefaultAheadSamples);
+
+    int useTimeSlice() override;
+
+    /**The VM page size, which is what one touch faults in*/
+    static int getPageSize();
+
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader;
+    juce::TimeSliceThread* prefaultThread;
+    int prefaultAheadSamples;
+    int samplesPerPage;
+    bool isPrepared{ false };
+
+    // owned by the audio thread, read by the prefault thread
+    std::atomic<juce::int64> playPos{ 0 };
+    // prefault thread: how far the sweep through the whole file has got
+    juce::int64 sweepPos{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MappedAudioSource)
+};
@@ -0,0 +1,99 @@
+#include <JuceHeader.h>
+#include "MetadataScanner.h"
+
+//==============================================================================
+MetadataScanner::MetadataScanner(juce::AudioFormatManager& _formatManager,
+                                 int _numThreads
+                                ) : formatManager(_formatManager),
+                                    scanPool(juce::jmax(1, _numThreads))
+{
+    // scanning is never urgent, the decks' threads come first
+    scanPool.setThreadPriorities(2);
+}
+
+MetadataScanner::~MetadataScanner()
+{
+    scanPool.removeAllJobs(true, 5000);
+    cancelPendingUpdate();
+}
+
+void MetadataScanner::scan(const juce::Array<juce::File>& files)
+{
+    {
+        const juce::ScopedLock sl(lock);
+        numQueued += files.size();
+    }
+
+    for (int start = 0; start < files.size(); start += filesPerJob)
+    {
+        juce::Array<juce::File> chunk;
+        chunk.addArray(files, start, filesPerJob);
+        scanPool.addJob([this, chunk]
+        {
+            for (const auto& file : chunk)
+            {
+                auto* job = juce::ThreadPoolJob::getCurrentThreadPoolJob();
+                if (job != nullptr && job->shouldExit())
+                {
+                    return;
+                }
+                auto metadata = probe(file);
+                {
+                    const juce::ScopedLock sl(lock);
+                    results.add(metadata);
+                    ++numScanned;
+                }
+                triggerAsyncUpdate();
+            }
+        });
+    }
+}
+
+int MetadataScanner::getNumPending() const
+{
+    const juce::ScopedLock sl(lock);
+    return numQueued - numScanned;
+}
+
+TrackMetadata MetadataScanner::probe(const juce::File& file) const
+{
+    TrackMetadata metadata;
+    metadata.file = file;
+    metadata.fileSize = file.getSize();
+    metadata.modificationTime = file.getLastModificationTime().toMilliseconds();
+
+    // creating the reader parses the header; nothing is read past it
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr || reader->sampleRate <= 0)
+    {
+        DBG("MetadataScanner::probe could not read " << file.getFileName());
+        return metadata;
+    }
+    metadata.sampleRate = reader->sampleRate;
+    metadata.numChannels = (int) reader->numChannels;
+    metadata.lengthSecs = reader->lengthInSamples / reader->sampleRate;
+    return metadata;
+}
+
+void MetadataScanner::handleAsyncUpdate()
+{
+    juce::Array<TrackMetadata> batch;
+    int scanned;
+    int queued;
+    {
+        const juce::ScopedLock sl(lock);
+        batch.swapWith(results);
+        scanned = numScanned;
+        queued = numQueued;
+        // the next import counts from zero
+        if (numScanned == numQueued)
+        {
+            numScanned = 0;
+            numQueued = 0;
+        }
+    }
+    if (onFilesScanned)
+    {
+        onFilesScanned(batch, scanned, queued);
+    }
+}
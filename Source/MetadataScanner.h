@@ -0,0 +1,71 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    What a format's header says about a track, without decoding any audio.
+*/
+struct TrackMetadata
+{
+    juce::File file;
+    double lengthSecs = 0;
+    double sampleRate = 0;
+    int numChannels = 0;
+    // what a rescan compares to see if the file has changed since
+    juce::int64 fileSize = 0;
+    juce::int64 modificationTime = 0;
+
+    /**false if no format could read the file*/
+    bool isValid() const
+    {
+        return sampleRate > 0;
+    }
+};
+
+//==============================================================================
+/*
+    Reads the headers of files being imported on a pool of background
+    threads, so importing thousands of tracks keeps the GUI responsive.
+
+    Each file only gets a reader created for it, which parses the header
+    for the length, sample rate and channels, and is closed again without a
+    sample being decoded. Results are handed to the message thread in
+    batches as they complete, in no particular order, with how far the
+    import has got.
+*/
+class MetadataScanner  : private juce::AsyncUpdater
+{
+public:
+    MetadataScanner(juce::AudioFormatManager& _formatManager, int _numThreads);
+    ~MetadataScanner() override;
+
+    /**Any thread: queues files to have their headers read*/
+    void scan(const juce::Array<juce::File>& files);
+    /**Files queued or being read*/
+    int getNumPending() const;
+    /**Reads a file's header on the calling thread*/
+    TrackMetadata probe(const juce::File& file) const;
+
+    /**Message thread: called with each batch of results, how many files have been read and
+    *  how many were queued in all since the scanner was last idle*/
+    std::function<void(const juce::Array<TrackMetadata>& batch, int numScanned, int numQueued)> onFilesScanned;
+
+private:
+    void handleAsyncUpdate() override;
+
+    // files per pool job, so a big import isn't thousands of jobs
+    static constexpr int filesPerJob = 32;
+
+    juce::AudioFormatManager& formatManager;
+
+    juce::CriticalSection lock;
+    juce::Array<TrackMetadata> results;
+    int numQueued{ 0 };
+    int numScanned{ 0 };
+
+    // declared last so scans stop before anything they use is destroyed
+    juce::ThreadPool scanPool;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MetadataScanner)
+};
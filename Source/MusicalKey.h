@@ -0,0 +1,80 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    The key of a track, with the Camelot and Open Key names DJs mix by: keys
+    with the same number or a number one apart sound right together.
+*/
+struct MusicalKey
+{
+    // pitch class of the tonic, C = 0, or -1 if the key isn't known
+    int tonic = -1;
+    bool isMinor = false;
+
+    bool isValid() const
+    {
+        return tonic >= 0;
+    }
+
+    /**1 to 12 round the circle of fifths, C major and A minor being 8*/
+    int getCamelotNumber() const
+    {
+        // a minor key shares its number with its relative major, three semitones up
+        auto majorTonic = isMinor ? (tonic + 3) % 12 : tonic;
+        return (majorTonic * 7 + 7) % 12 + 1;
+    }
+
+    /**e.g. "8A" for A minor, empty if unknown*/
+    juce::String getCamelot() const
+    {
+        return isValid() ? juce::String(getCamelotNumber()) + (isMinor ? "A" : "B") : juce::String();
+    }
+
+    /**e.g. "1m" for A minor, empty if unknown*/
+    juce::String getOpenKey() const
+    {
+        return isValid() ? juce::String((getCamelotNumber() + 4) % 12 + 1) + (isMinor ? "m" : "d") : juce::String();
+    }
+
+    /**e.g. "Am", empty if unknown*/
+    juce::String getName() const
+    {
+        static const char* const names[] = { "C", "Db", "D", "Eb", "E", "F", "F#", "G", "Ab", "A", "Bb", "B" };
+        return isValid() ? juce::String(names[tonic]) + (isMinor ? "m" : "") : juce::String();
+    }
+
+    /**0 to 23 for storing, -1 if unknown*/
+    int toIndex() const
+    {
+        return isValid() ? tonic + (isMinor ? 12 : 0) : -1;
+    }
+
+    /**The key a Camelot or Open Key code or a name like "Am" stands for, ignoring case;
+    *  invalid if it isn't one*/
+    static MusicalKey fromName(const juce::String& name)
+    {
+        for (int index = 0; index < 24; ++index)
+        {
+            auto key = fromIndex(index);
+            if (name.equalsIgnoreCase(key.getCamelot()) || name.equalsIgnoreCase(key.getOpenKey())
+                || name == key.getName())
+            {
+                return key;
+            }
+        }
+        return {};
+    }
+
+    static MusicalKey fromIndex(int index)
+    {
+        MusicalKey key;
+        if (index >= 0 && index < 24)
+        {
+            key.tonic = index % 12;
+            key.isMinor = index >= 12;
+        }
+        return key;
+    }
+};
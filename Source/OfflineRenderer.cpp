@@ -0,0 +1,264 @@
+#include <JuceHeader.h>
+#include "OfflineRenderer.h"
+#include "DJAudioPlayer.h"
+#include "DeckMixer.h"
+#include "ReadAheadPool.h"
+#include <iostream>
+
+//==============================================================================
+OfflineRenderer::OfflineRenderer(juce::AudioFormatManager& _formatManager) : formatManager(_formatManager)
+{
+}
+
+OfflineRenderer::~OfflineRenderer()
+{
+}
+
+bool OfflineRenderer::loadSession(const juce::File& sessionFile, Session& session, juce::String& error)
+{
+    auto json = juce::JSON::parse(sessionFile);
+    if (!json.isObject())
+    {
+        error = "Could not read a session from " + sessionFile.getFullPathName();
+        return false;
+    }
+
+    session.sampleRate = json.getProperty("sampleRate", 44100.0);
+    session.lengthInSeconds = json.getProperty("length", 0.0);
+    session.blockSize = json.getProperty("blockSize", 512);
+    if (session.sampleRate < 8000 || session.blockSize < 16 || session.lengthInSeconds < 0)
+    {
+        error = "The sample rate, block size or length is out of range";
+        return false;
+    }
+
+    auto decks = json["decks"];
+    if (!decks.isArray() || decks.size() == 0 || decks.size() > DeckMixer::maxDecks)
+    {
+        error = "A session needs between 1 and " + juce::String(DeckMixer::maxDecks) + " decks";
+        return false;
+    }
+
+    session.decks.clear();
+    for (int i = 0; i < decks.size(); ++i)
+    {
+        auto& deck = decks[i];
+        DeckSettings settings;
+        auto path = deck["file"].toString();
+        if (path.isEmpty())
+        {
+            error = "Deck " + juce::String(i + 1) + " has no file";
+            return false;
+        }
+        settings.file = sessionFile.getParentDirectory().getChildFile(path);
+        settings.startInMix = deck.getProperty("at", 0.0);
+        settings.startInFile = deck.getProperty("start", 0.0);
+        settings.gain = deck.getProperty("gain", 1.0);
+        settings.speed = deck.getProperty("speed", 1.0);
+        settings.pitchSemitones = deck.getProperty("pitch", 0.0);
+        settings.keyLock = deck.getProperty("keyLock", false);
+        settings.roomSize = deck.getProperty("roomSize", 0.0);
+        settings.damping = deck.getProperty("damping", 0.0);
+        settings.wetLevel = deck.getProperty("wetLevel", 0.0);
+        settings.dryLevel = deck.getProperty("dryLevel", 1.0);
+
+        auto quality = deck.getProperty("quality", "sinc").toString();
+        settings.quality = quality == "linear" ? DeckResampler::Quality::linear
+                         : quality == "cubic" ? DeckResampler::Quality::cubic
+                                              : DeckResampler::Quality::sinc;
+
+        if (settings.startInMix < 0 || settings.startInFile < 0
+            || settings.speed < 0.25 || settings.speed > 4.0
+            || std::abs(settings.pitchSemitones) > 12.0)
+        {
+            error = "Deck " + juce::String(i + 1) + " has a position, speed or pitch out of range";
+            return false;
+        }
+        session.decks.push_back(settings);
+    }
+    return true;
+}
+
+bool OfflineRenderer::render(const Session& session, const juce::File& output,
+                             std::function<void(double progress)> onProgress, juce::String& error)
+{
+    renderedLength = 0;
+    auto* format = formatManager.findFormatForFileExtension(output.getFileExtension());
+    if (format == nullptr)
+    {
+        error = "Can't write " + output.getFileExtension() + " files";
+        return false;
+    }
+
+    // declared in this order so the mixer lets go of the players before they are deleted,
+    // and the players of the read-ahead pool, which they ask for a thread but never use offline
+    ReadAheadPool readAheadPool(1);
+    juce::OwnedArray<DJAudioPlayer> players;
+    DeckMixer mixer;
+    mixer.setRealtime(false);
+    mixer.prepareToPlay(session.blockSize, session.sampleRate);
+
+    std::vector<juce::int64> startSamples;
+    auto endSample = (juce::int64) std::llround(session.lengthInSeconds * session.sampleRate);
+    auto findEnd = endSample == 0;
+
+    for (int i = 0; i < (int) session.decks.size(); ++i)
+    {
+        auto& settings = session.decks[(size_t) i];
+        auto* player = players.add(new DJAudioPlayer(formatManager, readAheadPool));
+        player->setRealtime(false);
+        mixer.addDeck(i, player);
+
+        player->loadURL(juce::URL(settings.file));
+        auto length = player->getLengthInSeconds();
+        if (length <= 0)
+        {
+            error = "Could not open " + settings.file.getFullPathName();
+            return false;
+        }
+
+        player->setGain(settings.gain);
+        player->setSpeed(settings.speed);
+        player->setPitchSemitones(settings.pitchSemitones);
+        player->setKeyLock(settings.keyLock);
+        player->setResamplingQuality(settings.quality);
+        player->setRoomSize(settings.roomSize);
+        player->setDamping(settings.damping);
+        player->setWetLevel(settings.wetLevel);
+        player->setDryLevel(settings.dryLevel);
+        if (settings.startInFile > 0)
+        {
+            player->setPositionRelative(juce::jmin(1.0, settings.startInFile / length));
+        }
+
+        startSamples.push_back((juce::int64) std::llround(settings.startInMix * session.sampleRate));
+        if (findEnd)
+        {
+            // pitch changes are tempo neutral, so only the speed changes how long the deck plays
+            auto playingTime = juce::jmax(0.0, length - settings.startInFile) / settings.speed;
+            endSample = juce::jmax(endSample, startSamples.back()
+                                              + (juce::int64) std::ceil(playingTime * session.sampleRate));
+        }
+    }
+
+    output.deleteFile();
+    auto fileStream = std::make_unique<juce::FileOutputStream>(output);
+    if (!fileStream->openedOk())
+    {
+        error = "Could not create " + output.getFullPathName();
+        return false;
+    }
+    std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(fileStream.get(), session.sampleRate,
+                                                                            2, 24, {}, 0));
+    if (writer == nullptr)
+    {
+        error = "Could not write " + format->getFormatName() + " at this sample rate";
+        return false;
+    }
+    // the writer owns the stream now
+    fileStream.release();
+
+    juce::AudioBuffer<float> block(2, session.blockSize);
+    std::vector<bool> started(session.decks.size(), false);
+    for (juce::int64 pos = 0; pos < endSample;)
+    {
+        auto numThisTime = (int) juce::jmin((juce::int64) session.blockSize, endSample - pos);
+        for (int i = 0; i < players.size(); ++i)
+        {
+            if (!started[(size_t) i] && startSamples[(size_t) i] <= pos)
+            {
+                players[i]->play();
+                started[(size_t) i] = true;
+            }
+        }
+        // end the block where the next deck comes in, so it starts on the sample
+        for (int i = 0; i < players.size(); ++i)
+        {
+            if (!started[(size_t) i])
+            {
+                numThisTime = (int) juce::jmin((juce::int64) numThisTime, startSamples[(size_t) i] - pos);
+            }
+        }
+
+        mixer.getNextAudioBlock(juce::AudioSourceChannelInfo(&block, 0, numThisTime));
+        if (!writer->writeFromAudioSampleBuffer(block, 0, numThisTime))
+        {
+            error = "Could not write to " + output.getFullPathName();
+            return false;
+        }
+        pos += numThisTime;
+
+        if (onProgress != nullptr)
+        {
+            onProgress((double) pos / endSample);
+        }
+    }
+
+    for (int i = 0; i < players.size(); ++i)
+    {
+        mixer.removeDeck(i);
+    }
+    renderedLength = endSample / session.sampleRate;
+    return true;
+}
+
+double OfflineRenderer::getRenderedLength() const
+{
+    return renderedLength;
+}
+
+int OfflineRenderer::runFromCommandLine(const juce::String& commandLine)
+{
+    juce::ArgumentList args("OtoDecks", commandLine);
+    if (!args.containsOption("--output"))
+    {
+        std::cerr << "Usage: OtoDecks --render session.json --output mix.wav"
+                     " [--sample-rate 48000] [--block-size 512]" << std::endl;
+        return 1;
+    }
+
+    Session session;
+    juce::String error;
+    if (!loadSession(args.getFileForOption("--render"), session, error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    if (args.containsOption("--sample-rate"))
+    {
+        session.sampleRate = args.getValueForOption("--sample-rate").getDoubleValue();
+    }
+    if (args.containsOption("--block-size"))
+    {
+        session.blockSize = args.getValueForOption("--block-size").getIntValue();
+    }
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+    OfflineRenderer renderer(formatManager);
+
+    auto output = args.getFileForOption("--output");
+    auto startTime = juce::Time::getMillisecondCounterHiRes();
+    int lastTenth = -1;
+    auto printProgress = [&lastTenth](double progress)
+    {
+        auto tenth = (int) (progress * 10);
+        if (tenth != lastTenth)
+        {
+            std::cout << tenth * 10 << "%" << std::endl;
+            lastTenth = tenth;
+        }
+    };
+
+    if (!renderer.render(session, output, printProgress, error))
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    auto seconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+    std::cout << "Rendered " << renderer.getRenderedLength() << "s to " << output.getFullPathName()
+              << " in " << seconds << "s (" << renderer.getRenderedLength() / juce::jmax(seconds, 0.001)
+              << "x real time)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "DeckResampler.h"
+
+//==============================================================================
+/*
+    Renders a deck session to a WAV or FLAC file as fast as the CPU allows,
+    with no audio device. Each deck is a DJAudioPlayer mixed by a DeckMixer,
+    exactly as in the app, so the decks render in parallel and the file
+    matches what would have been heard. The mixer runs without a deadline,
+    so the same session renders to the same file however busy the machine is.
+
+    A session is a JSON file:
+        { "sampleRate": 44100, "length": 3600,
+          "decks": [ { "file": "a.mp3", "at": 0, "start": 30, "gain": 1, "speed": 1,
+                       "pitch": 0, "keyLock": false, "quality": "sinc",
+                       "roomSize": 0, "damping": 0, "wetLevel": 0, "dryLevel": 1 } ] }
+    "at" is when the deck starts in the mix and "start" where it starts in its
+    file, both in seconds. Everything but "file" is optional; without a
+    length the render stops when the last deck does.
+*/
+class OfflineRenderer
+{
+public:
+    struct DeckSettings
+    {
+        juce::File file;
+        double startInMix = 0;
+        double startInFile = 0;
+        double gain = 1.0;
+        double speed = 1.0;
+        double pitchSemitones = 0;
+        bool keyLock = false;
+        DeckResampler::Quality quality = DeckResampler::Quality::sinc;
+        float roomSize = 0;
+        float damping = 0;
+        float wetLevel = 0;
+        float dryLevel = 1.0f;
+    };
+
+    struct Session
+    {
+        double sampleRate = 44100.0;
+        /**0 renders until the last deck ends*/
+        double lengthInSeconds = 0;
+        int blockSize = 512;
+        std::vector<DeckSettings> decks;
+    };
+
+    OfflineRenderer(juce::AudioFormatManager& _formatManager);
+    ~OfflineRenderer();
+
+    /**Reads a session file, file paths being relative to it. Returns false and sets error if it can't*/
+    static bool loadSession(const juce::File& sessionFile, Session& session, juce::String& error);
+    /**Renders the session into output, reporting progress from 0 to 1 on the calling thread*/
+    bool render(const Session& session, const juce::File& output,
+                std::function<void(double progress)> onProgress, juce::String& error);
+    /**Seconds of audio written by the last successful render*/
+    double getRenderedLength() const;
+
+    /**Handles "--render session.json --output mix.wav [--sample-rate 48000] [--block-size 512]".
+    *  Returns the process exit code*/
+    static int runFromCommandLine(const juce::String& commandLine);
+
+private:
+    juce::AudioFormatManager& formatManager;
+    double renderedLength{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfflineRenderer)
+};
@@ -4,37 +4,72 @@
 #include "PlaylistComponent.h"
 
 //==============================================================================
-PlaylistComponent::PlaylistComponent(DeckGUI* _deckGUI1, 
-                                     DeckGUI* _deckGUI2,
-                                     DJAudioPlayer* _playerForParsingMetaData
-                                    ) : deckGUI1(_deckGUI1),
-                                        deckGUI2(_deckGUI2),
-                                        playerForParsingMetaData(_playerForParsingMetaData)
+PlaylistComponent::PlaylistComponent(DeckManager& _deckManager,
+                                     MetadataScanner& _metadataScanner,
+                                     FolderScanner& _folderScanner,
+                                     PreloadCache& _preloadCache,
+                                     TrackAnalyzer& _trackAnalyzer
+                                    ) : deckManager(_deckManager),
+                                        metadataScanner(_metadataScanner),
+                                        folderScanner(_folderScanner),
+                                        preloadCache(_preloadCache),
+                                        trackAnalyzer(_trackAnalyzer)
 {
     // In your constructor, you should add any child components, and
     // initialise any special settings that your component needs.
     
     // add components
     addAndMakeVisible(importButton);
+    addAndMakeVisible(importFolderButton);
+    addAndMakeVisible(rescanButton);
+    addAndMakeVisible(watchButton);
     addAndMakeVisible(searchField);
     addAndMakeVisible(library);
-    addAndMakeVisible(addToDeck1Button);
-    addAndMakeVisible(addToDeck2Button);
+    addAndMakeVisible(deckBox);
+    addAndMakeVisible(addToDeckButton);
+    addAndMakeVisible(preloadButton);
+    addAndMakeVisible(analysisThreadsBox);
 
 
     // buttons styling
     importButton.setColour(ComboBox::outlineColourId, Colours::deepskyblue);
     importButton.setColour(TextButton::textColourOffId, Colours::deepskyblue);
-    addToDeck1Button.setColour(ComboBox::outlineColourId, Colours::deepskyblue);
-    addToDeck1Button.setColour(TextButton::textColourOffId, Colours::deepskyblue);
-    addToDeck2Button.setColour(ComboBox::outlineColourId, Colours::deepskyblue);
-    addToDeck2Button.setColour(TextButton::textColourOffId, Colours::deepskyblue);
+    importFolderButton.setColour(ComboBox::outlineColourId, Colours::deepskyblue);
+    importFolderButton.setColour(TextButton::textColourOffId, Colours::deepskyblue);
+    rescanButton.setColour(ComboBox::outlineColourId, Colours::deepskyblue);
+    rescanButton.setColour(TextButton::textColourOffId, Colours::deepskyblue);
+    watchButton.setColour(ComboBox::outlineColourId, Colours::deepskyblue);
+    watchButton.setColour(TextButton::textColourOffId, Colours::deepskyblue);
+    watchButton.setColour(TextButton::textColourOnId, Colours::limegreen);
+    addToDeckButton.setColour(ComboBox::outlineColourId, Colours::deepskyblue);
+    addToDeckButton.setColour(TextButton::textColourOffId, Colours::deepskyblue);
+    preloadButton.setColour(ComboBox::outlineColourId, Colours::deepskyblue);
+    preloadButton.setColour(TextButton::textColourOffId, Colours::deepskyblue);
+    deckBox.setColour(ComboBox::outlineColourId, Colours::deepskyblue);
+    deckBox.setColour(ComboBox::textColourId, Colours::deepskyblue);
+    analysisThreadsBox.setColour(ComboBox::outlineColourId, Colours::deepskyblue);
+    analysisThreadsBox.setColour(ComboBox::textColourId, Colours::deepskyblue);
 
     // attach listeners
     importButton.addListener(this);
+    importFolderButton.addListener(this);
+    rescanButton.addListener(this);
+    watchButton.addListener(this);
     searchField.addListener(this);
-    addToDeck1Button.addListener(this);
-    addToDeck2Button.addListener(this);
+    addToDeckButton.addListener(this);
+    preloadButton.addListener(this);
+    deckManager.addChangeListener(this);
+
+    // the decks that exist right now; kept up to date by changeListenerCallback
+    updateDeckBox();
+
+    // how many cores analyzing the library may take from everything else
+    for (int i = 1; i <= juce::SystemStats::getNumCpus(); ++i)
+    {
+        analysisThreadsBox.addItem(juce::String(i) + (i == 1 ? " ANALYSIS THREAD" : " ANALYSIS THREADS"), i);
+    }
+    analysisThreadsBox.setSelectedId(trackAnalyzer.getNumThreads(), juce::dontSendNotification);
+    analysisThreadsBox.onChange = [this] { trackAnalyzer.setNumThreads(analysisThreadsBox.getSelectedId()); };
 
     // R3C searchField configuration
     searchField.setTextToShowWhenEmpty("Search track (Press enter to submit)", 
@@ -44,15 +79,34 @@ PlaylistComponent::PlaylistComponent(DeckGUI* _deckGUI1,
     // R3B setup table and load library from file
     library.getHeader().addColumn("Tracks", 1, 1);
     library.getHeader().addColumn("Length", 2, 1);
+    library.getHeader().addColumn("BPM", 4, 1);
+    library.getHeader().addColumn("Camelot", 5, 1);
     library.getHeader().addColumn("X", 3, 1);
     library.setModel(this);
 
+    trackAnalyzer.onTrackAnalyzed = [this](const juce::File& file, const TrackAnalysis& analysis)
+    {
+        applyAnalysis(file, analysis);
+    };
+    metadataScanner.onFilesScanned = [this](const juce::Array<TrackMetadata>& batch, int numScanned, int numQueued)
+    {
+        addScannedTracks(batch, numScanned, numQueued);
+    };
+    folderScanner.onFolderScanned = [this](const juce::File& root, const std::vector<ScannedFile>& files, bool complete)
+    {
+        applyFolderScan(root, files, complete);
+    };
+
     //R3E 
     loadToLibrary();
 }
 
 PlaylistComponent::~PlaylistComponent()
 {
+    trackAnalyzer.onTrackAnalyzed = nullptr;
+    metadataScanner.onFilesScanned = nullptr;
+    folderScanner.onFolderScanned = nullptr;
+    deckManager.removeChangeListener(this);
     // R3E record the songs
     saveToLibrary();
 }
@@ -84,15 +138,22 @@ void PlaylistComponent::resized()
 
 
     //                      (x start, y start, width, height)
-    importButton.setBounds(0, 15 * getHeight() / 16, getWidth(), getHeight() / 16);
+    importButton.setBounds(0, 15 * getHeight() / 16, getWidth() / 4, getHeight() / 16);
+    importFolderButton.setBounds(getWidth() / 4, 15 * getHeight() / 16, getWidth() / 4, getHeight() / 16);
+    rescanButton.setBounds(getWidth() / 2, 15 * getHeight() / 16, getWidth() / 8, getHeight() / 16);
+    watchButton.setBounds(5 * getWidth() / 8, 15 * getHeight() / 16, getWidth() / 8, getHeight() / 16);
+    analysisThreadsBox.setBounds(3 * getWidth() / 4, 15 * getHeight() / 16, getWidth() - 3 * getWidth() / 4, getHeight() / 16);
     library.setBounds(0, 1 * getHeight() / 16, getWidth(), 13 * getHeight() / 16);
     searchField.setBounds(0, 14 * getHeight() / 16, getWidth(), getHeight() / 16);
-    addToDeck1Button.setBounds(0, 0, getWidth()/2, getHeight() / 16);
-    addToDeck2Button.setBounds(getWidth() / 2, 0, getWidth() / 2, getHeight() / 16);  
+    deckBox.setBounds(0, 0, getWidth() / 3, getHeight() / 16);
+    addToDeckButton.setBounds(getWidth() / 3, 0, getWidth() / 3, getHeight() / 16);
+    preloadButton.setBounds(2 * getWidth() / 3, 0, getWidth() - 2 * getWidth() / 3, getHeight() / 16);
 
     //set columns
-    library.getHeader().setColumnWidth(1, 12.8 * getWidth() / 20);
-    library.getHeader().setColumnWidth(2, 5 * getWidth() / 20);
+    library.getHeader().setColumnWidth(1, 8.8 * getWidth() / 20);
+    library.getHeader().setColumnWidth(2, 3 * getWidth() / 20);
+    library.getHeader().setColumnWidth(4, 3 * getWidth() / 20);
+    library.getHeader().setColumnWidth(5, 3 * getWidth() / 20);
     library.getHeader().setColumnWidth(3, 2 * getWidth() / 20);
 }
 
@@ -134,7 +195,7 @@ void PlaylistComponent::paintCell(juce::Graphics& g,
     {
         if (columnId == 1)
         {
-            g.drawText(tracks[rowNumber].title,
+            g.drawText(tracks.getTrack(rowNumber).title,
                 2,
                 0,
                 width - 4,
@@ -145,7 +206,34 @@ void PlaylistComponent::paintCell(juce::Graphics& g,
         }
         if (columnId == 2)
         {
-            g.drawText(tracks[rowNumber].length,
+            g.drawText(secondsToMinutes(tracks.getLengthMs(rowNumber) / 1000.0),
+                2,
+                0,
+                width - 4,
+                height,
+                juce::Justification::centred,
+                true
+            );
+        }
+        // a dash until the analyzer has found the tempo
+        if (columnId == 4)
+        {
+            auto grid = tracks.getBeatGrid(rowNumber);
+            g.drawText(grid.isValid() ? juce::String(grid.bpm, 1) : juce::String("-"),
+                2,
+                0,
+                width - 4,
+                height,
+                juce::Justification::centred,
+                true
+            );
+        }
+        // the number and letter to mix by, then the key's name
+        if (columnId == 5)
+        {
+            auto key = tracks.getKey(rowNumber);
+            g.drawText(key.isValid() ? (showOpenKey ? key.getOpenKey() : key.getCamelot()) + "  " + key.getName()
+                                     : juce::String("-"),
                 2,
                 0,
                 width - 4,
@@ -157,6 +245,18 @@ void PlaylistComponent::paintCell(juce::Graphics& g,
     }
 }
 
+void PlaylistComponent::sortOrderChanged(int newSortColumnId, bool isForwards)
+{
+    if (newSortColumnId == 5)
+    {
+        showOpenKey = !showOpenKey;
+        library.getHeader().setColumnName(5, showOpenKey ? "Open Key" : "Camelot");
+        // the library isn't sorted, so no column should look like it is
+        library.getHeader().setSortColumnId(0, true);
+        library.repaint();
+    }
+}
+
 // delete the selected song using an X button
 juce::Component* PlaylistComponent::refreshComponentForCell(int rowNumber,
                                                       int columnId,
@@ -169,11 +269,14 @@ juce::Component* PlaylistComponent::refreshComponentForCell(int rowNumber,
         {
             // create X button and link it to each song index
             juce::TextButton* btn = new juce::TextButton{ "X" };
-            juce::String id{ std::to_string(rowNumber) };
-            btn->setComponentID(id);
             btn->addListener(this);
             existingComponentToUpdate = btn;
         }
+        // a reused button is linked to its new row's track, by id so removing rows above doesn't move it
+        if (rowNumber < getNumRows())
+        {
+            existingComponentToUpdate->setComponentID(juce::String(tracks.getId(rowNumber)));
+        }
     }
     return existingComponentToUpdate;
 }
@@ -188,38 +291,172 @@ void PlaylistComponent::buttonClicked(juce::Button* button)
         //update the library
         library.updateContent();
     }
+    else if (button == &importFolderButton)
+    {
+        DBG("Import folder button clicked");
+        importFolder();
+    }
+    else if (button == &rescanButton)
+    {
+        DBG("Rescan button clicked");
+        rescanFolders();
+    }
+    else if (button == &watchButton)
+    {
+        DBG("Watch button clicked");
+        watchButton.setToggleState(!watchButton.getToggleState(), juce::dontSendNotification);
+        if (watchButton.getToggleState())
+        {
+            rescanFolders();
+            startTimer(watchIntervalMs);
+        }
+        else
+        {
+            stopTimer();
+        }
+    }
     // R3D load the song into the chosen Deck
-    else if (button == &addToDeck1Button)
+    else if (button == &addToDeckButton)
     {
-        DBG("Add to Deck 1 clicked");
-        loadInDeck(deckGUI1);
+        DBG("Add to Deck " << deckBox.getSelectedId() << " clicked");
+        loadInDeck(deckManager.findDeckGUI(deckBox.getSelectedId()));
     }
-    else if (button == &addToDeck2Button)
+    else if (button == &preloadButton)
     {
-        DBG("Add to Deck 2 clicked");
-        loadInDeck(deckGUI2);
+        DBG("Preload clicked");
+        preloadSelected();
     }
     else
     {
         // remove the song from library
-        int id = std::stoi(button->getComponentID().toStdString());
-        DBG(tracks[id].title + " removed from Library");
+        int id = tracks.indexOf((TrackId) button->getComponentID().getLargeIntValue());
+        if (id < 0)
+        {
+            return;
+        }
+        DBG(tracks.getTitle(id) + " removed from Library");
         deleteSongs(id);
         // update the library
         library.updateContent();
     }
 }
 
+void PlaylistComponent::changeListenerCallback(juce::ChangeBroadcaster* source)
+{
+    if (source == &deckManager)
+    {
+        updateDeckBox();
+    }
+}
+
+// one item per deck, its id being the deck number; keeps the chosen deck if it still exists
+void PlaylistComponent::updateDeckBox()
+{
+    auto selectedDeck = deckBox.getSelectedId();
+    deckBox.clear(juce::dontSendNotification);
+    for (int i = 0; i < deckManager.getNumDecks(); ++i)
+    {
+        auto deckNumber = deckManager.getDeckNumber(i);
+        deckBox.addItem("DECK " + juce::String(deckNumber), deckNumber);
+        connectDeck(deckManager.findDeckGUI(deckNumber));
+    }
+    if (deckManager.findDeckGUI(selectedDeck) != nullptr)
+    {
+        deckBox.setSelectedId(selectedDeck, juce::dontSendNotification);
+    }
+    else
+    {
+        deckBox.setSelectedItemIndex(0, juce::dontSendNotification);
+    }
+}
+
+// a deck gets the cues and grid stored for whatever it loads, and its cue changes are stored back
+void PlaylistComponent::connectDeck(DeckGUI* deckGUI)
+{
+    juce::Component::SafePointer<DeckGUI> safeDeck{ deckGUI };
+    deckGUI->onTrackLoading = [this, safeDeck](const juce::URL& audioURL)
+    {
+        auto index = audioURL.isLocalFile() ? tracks.indexOf(audioURL.getLocalFile()) : -1;
+        if (safeDeck != nullptr && index >= 0)
+        {
+            auto song = tracks.getTrack(index);
+            safeDeck->setTrackInfo(song.hotCues, song.beatGrid);
+        }
+        // a track about to be played can't wait behind the rest of an import
+        if (audioURL.isLocalFile() && (index < 0 || needsAnalysis(index)))
+        {
+            trackAnalyzer.prioritize(audioURL.getLocalFile());
+        }
+    };
+    deckGUI->onHotCuesChanged = [this](const juce::URL& audioURL, const HotCues& cues)
+    {
+        auto index = audioURL.isLocalFile() ? tracks.indexOf(audioURL.getLocalFile()) : -1;
+        if (index >= 0)
+        {
+            tracks.setHotCues(index, cues);
+            commitLibrary();
+        }
+    };
+}
+
+void PlaylistComponent::applyAnalysis(const juce::File& file, const TrackAnalysis& analysis)
+{
+    auto index = tracks.indexOf(file);
+    if (index >= 0)
+    {
+        tracks.setBeatGrid(index, analysis.beatGrid);
+        tracks.setKey(index, analysis.key);
+        // tracks from before files were stamped get their stamp here, so the analysis has one to match
+        if (tracks.getModificationTime(index) == 0)
+        {
+            tracks.setFileStamp(index, file.getSize(), file.getLastModificationTime().toMilliseconds());
+        }
+        tracks.setAnalysisStamp(index, tracks.getModificationTime(index));
+        commitLibrary();
+        library.repaint();
+    }
+    for (int i = 0; i < deckManager.getNumDecks(); ++i)
+    {
+        deckManager.findDeckGUI(deckManager.getDeckNumber(i))->updateBeatGrid(juce::URL{ file }, analysis.beatGrid);
+    }
+}
+
+bool PlaylistComponent::needsAnalysis(int index) const
+{
+    if (tracks.getBeatGrid(index).isValid() && tracks.getKey(index).isValid())
+    {
+        return false;
+    }
+    // one with no grid or key to find was still analyzed, and is only tried again once the file changes
+    auto stamp = tracks.getAnalysisStamp(index);
+    return stamp == 0 || stamp != tracks.getModificationTime(index);
+}
+
+void PlaylistComponent::commitLibrary()
+{
+    tracks.commit();
+    // the edits since the snapshot are kept in memory, so they are folded into it once there are many
+    if (tracks.shouldCompact())
+    {
+        tracks.compact();
+    }
+}
+
 // R3D load the song into the chosen deck 
 void PlaylistComponent::loadInDeck(DeckGUI* deckGUI)
 {
     // identify the selected song by user
     int selectedRow{ library.getSelectedRow() };
-    if (selectedRow != -1)
+    if (deckGUI == nullptr)
+    {
+        DBG("PlaylistComponent::loadInDeck no deck chosen");
+    }
+    else if (selectedRow != -1)
     {
         // load the chosen song to the deck
-        DBG("Adding: " << tracks[selectedRow].title << " to Player");
-        deckGUI->loadFile(tracks[selectedRow].URL);
+        auto song = tracks.getTrack(selectedRow);
+        DBG("Adding: " << song.title << " to Player");
+        deckGUI->loadFile(song.URL);
     }
     else
     {
@@ -233,65 +470,235 @@ void PlaylistComponent::loadInDeck(DeckGUI* deckGUI)
     }
 }
 
+void PlaylistComponent::preloadSelected()
+{
+    int selectedRow{ library.getSelectedRow() };
+    if (selectedRow == -1)
+    {
+        DBG("PlaylistComponent::preloadSelected no track selected");
+    }
+    else
+    {
+        preloadCache.preloadInBackground(tracks.getFile(selectedRow));
+    }
+}
+
 // R3A load the song file to the library
 void PlaylistComponent::importToLibrary()
 {
     DBG("PlaylistComponent::importToLibrary called");
 
-    //initialize file chooser
-    juce::FileChooser chooser{ "Select files" };
-    if (chooser.browseForMultipleFilesToOpen())
+    // the chooser doesn't hold up the message thread, and scanning what was chosen doesn't either
+    fileChooser = std::make_unique<juce::FileChooser>("Select files");
+    fileChooser->launchAsync(juce::FileBrowserComponent::openMode
+                                 | juce::FileBrowserComponent::canSelectFiles
+                                 | juce::FileBrowserComponent::canSelectMultipleItems,
+                             [this](const juce::FileChooser& chooser)
+                             {
+                                 importFiles(chooser.getResults());
+                             });
+}
+
+void PlaylistComponent::importFiles(const juce::Array<juce::File>& files)
+{
+    juce::Array<juce::File> newFiles;
+    juce::StringArray alreadyLoaded;
+    std::set<juce::String> chosenTitles;
+    for (const juce::File& file : files)
     {
-        for (const juce::File& file : chooser.getResults())
+        // parse the file name to obtain the name of the song
+        juce::String fileName{ file.getFileNameWithoutExtension() };
+        // if not already loaded or on its way then add into library
+        if (!isInPlaylist(fileName) && chosenTitles.insert(fileName).second
+            && importingPaths.insert(file.getFullPathName()).second)
+        {
+            newFiles.add(file);
+        }
+        else
         {
-            // parse the file name to obtain the name of the song
-            juce::String fileName{ file.getFileNameWithoutExtension() };
-            // if not already loaded then add into library
-            if (!isInPlaylist(fileName)) 
+            alreadyLoaded.add(fileName);
+        }
+    }
+    metadataScanner.scan(newFiles);
+
+    // display one message for every replica of a song to inform users
+    if (!alreadyLoaded.isEmpty())
+    {
+        auto numListed = juce::jmin(alreadyLoaded.size(), 10);
+        auto message = alreadyLoaded.joinIntoString("\n", 0, numListed);
+        if (alreadyLoaded.size() > numListed)
+        {
+            message << "\nand " << (alreadyLoaded.size() - numListed) << " more";
+        }
+        juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::AlertIconType::InfoIcon,
+            "Load information:",
+            message + "\nalready loaded",
+            "OK"
+        );
+    }
+}
+
+void PlaylistComponent::addScannedTracks(const juce::Array<TrackMetadata>& batch, int numScanned, int numQueued)
+{
+    for (const auto& metadata : batch)
+    {
+        importingPaths.erase(metadata.file.getFullPathName());
+        if (!metadata.isValid())
+        {
+            DBG("PlaylistComponent::addScannedTracks skipped " << metadata.file.getFileName());
+            continue;
+        }
+
+        // a rescan found the file changed
+        auto index = tracks.indexOf(metadata.file);
+        if (index >= 0)
+        {
+            auto fileSize = tracks.getFileSize(index);
+            // libraries saved before files were stamped just get their stamps, the rest is still right
+            auto isEdited = fileSize != 0
+                                && (fileSize != metadata.fileSize
+                                    || tracks.getModificationTime(index) != metadata.modificationTime);
+            tracks.setLength(index, juce::roundToInt(metadata.lengthSecs * 1000.0));
+            tracks.setFileStamp(index, metadata.fileSize, metadata.modificationTime);
+            if (isEdited)
             {
-                // parse the file data
-                Song newSong{ file };
-                juce::URL audioURL{ file };
-                newSong.length = getLength(audioURL) ;
-                //add the song data to library
-                tracks.push_back(newSong);
-                DBG("loaded file: " << newSong.title);
+                tracks.setBeatGrid(index, {});
+                tracks.setKey(index, {});
+                trackAnalyzer.analyzeInBackground(metadata.file);
             }
-            else // display message when theres a replica of the song to inform users.
+            continue;
+        }
+
+        // parse the file data
+        Song newSong{ metadata.file };
+        newSong.lengthMs = juce::roundToInt(metadata.lengthSecs * 1000.0);
+        newSong.fileSize = metadata.fileSize;
+        newSong.modificationTime = metadata.modificationTime;
+        //add the song data to library
+        tracks.add(newSong);
+        trackAnalyzer.analyzeInBackground(metadata.file);
+    }
+    // the whole batch is one commit
+    commitLibrary();
+    library.updateContent();
+
+    importButton.setButtonText(numScanned < numQueued
+                                   ? "IMPORTING " + juce::String(numScanned) + " / " + juce::String(numQueued)
+                                   : juce::String("BROWSE FOR FILES"));
+}
+
+void PlaylistComponent::importFolder()
+{
+    fileChooser = std::make_unique<juce::FileChooser>("Select a folder");
+    fileChooser->launchAsync(juce::FileBrowserComponent::openMode
+                                 | juce::FileBrowserComponent::canSelectDirectories,
+                             [this](const juce::FileChooser& chooser)
+                             {
+                                 auto folder = chooser.getResult();
+                                 // cancelled
+                                 if (folder == juce::File())
+                                 {
+                                     return;
+                                 }
+                                 libraryFolders.addIfNotAlreadyThere(folder.getFullPathName());
+                                 folderScanner.scan(folder);
+                                 rescanButton.setButtonText("SCANNING");
+                             });
+}
+
+void PlaylistComponent::rescanFolders()
+{
+    if (folderScanner.isScanning())
+    {
+        DBG("PlaylistComponent::rescanFolders the last scan hasn't finished");
+        return;
+    }
+    for (const auto& folder : libraryFolders)
+    {
+        folderScanner.scan(juce::File(folder));
+        rescanButton.setButtonText("SCANNING");
+    }
+}
+
+void PlaylistComponent::applyFolderScan(const juce::File& root, const std::vector<ScannedFile>& files, bool complete)
+{
+    // a walk finds the folder's files by path, so they don't have to be unique by title like chosen ones
+    std::vector<bool> isFound((size_t) tracks.size(), false);
+    juce::Array<juce::File> toRead;
+    for (const auto& scanned : files)
+    {
+        auto index = tracks.indexOf(scanned.file);
+        if (index >= 0)
+        {
+            isFound[(size_t) index] = true;
+            // the same size and modification time as when it was read, the common case for a rescan
+            if (tracks.getFileSize(index) == scanned.size
+                && tracks.getModificationTime(index) == scanned.modificationTime)
             {
-                juce::AlertWindow::showMessageBox(juce::AlertWindow::AlertIconType::InfoIcon,
-                    "Load information:",
-                    fileName + " already loaded",
-                    "OK",
-                    nullptr
-                );
+                continue;
             }
         }
+        if (importingPaths.insert(scanned.file.getFullPathName()).second)
+        {
+            toRead.add(scanned.file);
+        }
+    }
+    metadataScanner.scan(toRead);
+
+    // a part that couldn't be listed may only be offline, so nothing is removed for it
+    if (complete)
+    {
+        std::vector<bool> isDeleted((size_t) tracks.size(), false);
+        int numDeleted = 0;
+        for (int i = 0; i < tracks.size(); ++i)
+        {
+            if (!isFound[(size_t) i] && tracks.getFile(i).isAChildOf(root))
+            {
+                isDeleted[(size_t) i] = true;
+                ++numDeleted;
+            }
+        }
+        if (numDeleted > 0)
+        {
+            DBG("PlaylistComponent::applyFolderScan removing " << numDeleted << " deleted tracks");
+            tracks.removeIf([&isDeleted](int index)
+            {
+                return isDeleted[(size_t) index];
+            });
+            commitLibrary();
+            library.updateContent();
+        }
+    }
+
+    if (!folderScanner.isScanning())
+    {
+        rescanButton.setButtonText("RESCAN");
+    }
+}
+
+void PlaylistComponent::timerCallback()
+{
+    // the next rescan waits until the last one and the files it found have been read
+    if (!folderScanner.isScanning() && metadataScanner.getNumPending() == 0)
+    {
+        rescanFolders();
     }
 }
 
 // R3A compare the names inside the playlist and return true when theres a exact copy to ensure theres no replicates
 bool PlaylistComponent::isInPlaylist(juce::String fileName)
 {
-    return (std::find(tracks.begin(), tracks.end(), fileName) != tracks.end());
+    return tracks.contains(fileName);
 }
 
 // remove the song form playlist
 void PlaylistComponent::deleteSongs(int id)
 {
-    tracks.erase(tracks.begin() + id);
+    tracks.remove(id);
+    commitLibrary();
 }
 
-// R3B get the length of the song
-juce::String PlaylistComponent::getLength(juce::URL audioURL)
-{
-    playerForParsingMetaData->loadURL(audioURL);
-    // the full song length in seconds
-    double seconds{ playerForParsingMetaData->getLengthInSeconds() };
-    // record the string
-    juce::String minutes{ secondsToMinutes(seconds) };
-    return minutes;
-}
+// R3B the length of the song as minutes and seconds
 juce::String PlaylistComponent::secondsToMinutes(double seconds)
 {
     //find seconds and minutes and make into string
@@ -316,6 +723,18 @@ void PlaylistComponent::searchLibrary(juce::String searchText)
     {
         // using whereInPLaylist to obtain the index of the song which allow us to choose which row it is by using selectRow
         int rowNumber = whereInPlaylist(searchText);
+        // a key like "8A" or a tempo like "128" finds the first track in it
+        if (rowNumber == -1)
+        {
+            auto key = MusicalKey::fromName(searchText.trim());
+            auto bpm = searchText.trim().getDoubleValue();
+            auto matches = key.isValid() ? tracks.findKey(key)
+                                         : bpm > 0 ? tracks.findTempo(bpm - 0.5, bpm + 0.5) : juce::Array<int>();
+            if (!matches.isEmpty())
+            {
+                rowNumber = matches.getFirst();
+            }
+        }
         library.selectRow(rowNumber);
     }
     else
@@ -330,54 +749,70 @@ int PlaylistComponent::whereInPlaylist(juce::String searchText)
 {
     // finds index where track title contains searchText
     // it is case insensitive
-    auto chosenSong = find_if(tracks.begin(), tracks.end(), 
-        [&searchText](const Song& obj) 
-        {
-            return obj.title.containsIgnoreCase(searchText); 
-        });
-    int i = -1;
-
-    if (chosenSong != tracks.end())
-    {
-        i = std::distance(tracks.begin(), chosenSong);
-    }
-
-    return i;
+    return tracks.find(searchText);
 }
 
 // R3E store the data of the library locally to allow the library to persist
 void PlaylistComponent::saveToLibrary()
 {
-    // create .csv to save library
-    std::ofstream my_Library("my_library.csv");
-
-    // save library to file
-    for (Song& t : tracks)
-    {
-        my_Library << t.file.getFullPathName() << "," << t.length << "\n";
-    }
+    // every edit is in the journal already; folding it into the snapshot keeps the next start quick
+    commitLibrary();
+    getFoldersFile().replaceWithText(libraryFolders.joinIntoString("\n"));
 }
 
 //R3E load the saved library to the current one. Allowing the program to "remember" what songs were added
 void PlaylistComponent::loadToLibrary()
 {
-    // create input stream from saved library
-    std::ifstream my_Library("my_library.csv");
-    std::string filePath;
-    std::string length;
-
-    // Read data, line by line
-    if (my_Library.is_open())
+    // add each songs found in the store to the library
+    auto isNewStore = !getLibraryFile().existsAsFile();
+    if (!tracks.open(getLibraryFile()))
     {
-        // add each songs found in the .csv to the library
-        while (getline(my_Library, filePath, ',')) {
-            juce::File file{ filePath };
-            Song newSong{ file };
-
-            getline(my_Library, length);
-            newSong.length = length;
-            tracks.push_back(newSong);
+        DBG("PlaylistComponent::loadToLibrary could not open " << getLibraryFile().getFullPathName());
+    }
+    else
+    {
+        auto unreadableStore = tracks.getUnreadableStore();
+        auto hasTextLibrary = getTextLibraryFile().existsAsFile();
+        if (unreadableStore != juce::File())
+        {
+            juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::AlertIconType::WarningIcon,
+                "Library information:",
+                "The library could not be read, so it was moved to\n" + unreadableStore.getFullPathName()
+                    + (hasTextLibrary ? "\nand started again from " + getTextLibraryFile().getFileName()
+                                      : juce::String("\nand a new one started")),
+                "OK"
+            );
+        }
+        // a library kept as .csv before the store is moved into it once, or again if the store is lost
+        if ((isNewStore || unreadableStore != juce::File()) && hasTextLibrary)
+        {
+            tracks.load(getTextLibraryFile());
+            tracks.compact();
+        }
+    }
+    libraryFolders.addLines(getFoldersFile().loadFileAsString());
+    libraryFolders.removeEmptyStrings();
+    // tracks saved before they were analyzed; only their grid and key are read, not the whole track
+    for (int i = 0; i < tracks.size(); ++i)
+    {
+        if (needsAnalysis(i))
+        {
+            trackAnalyzer.analyzeInBackground(tracks.getFile(i));
         }
     }
-    my_Library.close();
-}
\ No newline at end of file
+}
+
+juce::File PlaylistComponent::getLibraryFile() const
+{
+    return juce::File::getCurrentWorkingDirectory().getChildFile("my_library.otolib");
+}
+
+juce::File PlaylistComponent::getTextLibraryFile() const
+{
+    return juce::File::getCurrentWorkingDirectory().getChildFile("my_library.csv");
+}
+
+juce::File PlaylistComponent::getFoldersFile() const
+{
+    return juce::File::getCurrentWorkingDirectory().getChildFile("my_library_folders.txt");
+}
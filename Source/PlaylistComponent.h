@@ -3,12 +3,15 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include <vector>
-#include <algorithm>
-#include <fstream>
+#include <set>
 #include "Song.h"
+#include "TrackLibrary.h"
 #include "DeckGUI.h"
 #include "DJAudioPlayer.h"
+#include "DeckManager.h"
+#include "TrackAnalyzer.h"
+#include "MetadataScanner.h"
+#include "FolderScanner.h"
 
 //==============================================================================
 /*
@@ -16,12 +19,16 @@
 class PlaylistComponent  : public juce::Component,
                            public juce::TableListBoxModel,
                            public juce::Button::Listener,
-                           public juce::TextEditor::Listener
+                           public juce::TextEditor::Listener,
+                           public juce::ChangeListener,
+                           private juce::Timer
 {
 public:
-    PlaylistComponent(DeckGUI* _deckGUI1, 
-                      DeckGUI* _deckGUI2, 
-                      DJAudioPlayer* _playerForParsingMetaData
+    PlaylistComponent(DeckManager& _deckManager,
+                      MetadataScanner& _metadataScanner,
+                      FolderScanner& _folderScanner,
+                      PreloadCache& _preloadCache,
+                      TrackAnalyzer& _trackAnalyzer
                      );
     ~PlaylistComponent() override;
 
@@ -42,38 +49,86 @@ public:
                    int height,
                    bool rowIsSelected
                   ) override;
+    /**Clicking the key column's header switches between Camelot and Open Key*/
+    void sortOrderChanged(int newSortColumnId, bool isForwards) override;
     
     Component* refreshComponentForCell(int rowNumber, 
                                        int columnId, 
                                        bool isRowSelected, 
                                        Component* existingComponentToUpdate) override;
     void buttonClicked(juce::Button* button) override;
+    /**Lists the decks again when one is added or removed*/
+    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
 private:
 
     // parse the file data
-    std::vector<Song> tracks;
+    TrackLibrary tracks;
     
     juce::TextButton importButton{ "BROWSE FOR FILES" };
+    juce::TextButton importFolderButton{ "IMPORT FOLDER" };
+    juce::TextButton rescanButton{ "RESCAN" };
+    juce::TextButton watchButton{ "WATCH" };
     juce::TextEditor searchField;
     juce::TableListBox library;
-    juce::TextButton addToDeck1Button{ "ADD TO DECK 1" };
-    juce::TextButton addToDeck2Button{ "ADD TO DECK 2" };
+    juce::ComboBox deckBox;
+    juce::TextButton addToDeckButton{ "ADD TO DECK" };
+    juce::TextButton preloadButton{ "PRELOAD" };
+    juce::ComboBox analysisThreadsBox;
+    // keys are shown in Camelot notation unless switched to Open Key
+    bool showOpenKey{ false };
 
-    DeckGUI* deckGUI1;
-    DeckGUI* deckGUI2;
-    DJAudioPlayer* playerForParsingMetaData;
+    DeckManager& deckManager;
+    MetadataScanner& metadataScanner;
+    FolderScanner& folderScanner;
+    PreloadCache& preloadCache;
+    TrackAnalyzer& trackAnalyzer;
     
-    juce::String getLength(juce::URL audioURL);
     juce::String secondsToMinutes(double seconds);
 
+    std::unique_ptr<juce::FileChooser> fileChooser;
+    // paths of the files still being scanned, so one can't be queued twice meanwhile
+    std::set<juce::String> importingPaths;
+    // the folders imported whole, which rescans walk again
+    juce::StringArray libraryFolders;
+    // how often watched folders are rescanned; JUCE has no notifications of file changes to wait for
+    static constexpr int watchIntervalMs = 30000;
+
     void importToLibrary();
+    /**Queues the files that aren't in the library yet to have their headers read*/
+    void importFiles(const juce::Array<juce::File>& files);
+    /**Adds the tracks the scanner has read to the library and shows how far the import has got*/
+    void addScannedTracks(const juce::Array<TrackMetadata>& batch, int numScanned, int numQueued);
+    /**Asks for a folder and imports everything under it*/
+    void importFolder();
+    /**Walks every imported folder again for new, changed and deleted files*/
+    void rescanFolders();
+    /**Compares what a walk found with the library: new and changed files are read again and
+    *  tracks whose files are gone are removed, if the whole folder could be walked*/
+    void applyFolderScan(const juce::File& root, const std::vector<ScannedFile>& files, bool complete);
+    /**Rescans the folders while watching them*/
+    void timerCallback() override;
     void searchLibrary(juce::String searchText);
     void saveToLibrary();
     void loadToLibrary();
     void deleteSongs(int id);
     bool isInPlaylist(juce::String fileName);
     int whereInPlaylist(juce::String searchText);
+    /**where the library is kept between sessions*/
+    juce::File getLibraryFile() const;
+    /**where it was kept before, as text*/
+    juce::File getTextLibraryFile() const;
+    juce::File getFoldersFile() const;
     void loadInDeck(DeckGUI* deckGUI);
+    /**Decodes the selected track into RAM in the background, ready for a deck in preload mode*/
+    void preloadSelected();
+    void updateDeckBox();
+    void connectDeck(DeckGUI* deckGUI);
+    /**Stores what the analyzer found in the library and passes the grid to any deck playing the track*/
+    void applyAnalysis(const juce::File& file, const TrackAnalysis& analysis);
+    /**true until both the grid and the key of a track have been found, or the file as it is now analyzed*/
+    bool needsAnalysis(int index) const;
+    /**Commits the library's edits, compacting it once it should be*/
+    void commitLibrary();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PlaylistComponent)
 };
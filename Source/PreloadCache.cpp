@@ -0,0 +1,184 @@
+#include <JuceHeader.h>
+#include "PreloadCache.h"
+
+//==============================================================================
+PreloadCache::PreloadCache(juce::AudioFormatManager& _formatManager,
+                           juce::int64 _budgetBytes,
+                           DecodeCache* _decodeCache
+                          ) : formatManager(_formatManager),
+                              budgetBytes(_budgetBytes),
+                              decodeCache(_decodeCache)
+{
+    // preloading ahead is never urgent, the decks' threads come first
+    preloadPool.setThreadPriorities(2);
+}
+
+PreloadCache::~PreloadCache()
+{
+    preloadPool.removeAllJobs(true, 5000);
+}
+
+std::shared_ptr<const PreloadedTrack> PreloadCache::acquire(const juce::File& source,
+                                                            const juce::File& decodeFrom,
+                                                            const std::function<void(double)>& reportProgress)
+{
+    auto key = getKey(source);
+    {
+        const juce::ScopedLock sl(lock);
+        if (auto* entry = findEntry(key))
+        {
+            entry->lastUsed = ++useCounter;
+            return entry->track;
+        }
+    }
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(decodeFrom));
+    if (reader == nullptr || reader->lengthInSamples <= 0
+        || reader->lengthInSamples > std::numeric_limits<int>::max())
+    {
+        DBG("PreloadCache::acquire could not read " << decodeFrom.getFileName());
+        return nullptr;
+    }
+
+    auto numBytes = reader->lengthInSamples * (juce::int64) juce::jmax(1, (int) reader->numChannels)
+                        * (juce::int64) sizeof(float);
+    {
+        const juce::ScopedLock sl(lock);
+        if (!makeRoom(numBytes))
+        {
+            DBG("PreloadCache::acquire no room for " << source.getFileName() << " in the budget");
+            return nullptr;
+        }
+        bytesReserved += numBytes;
+    }
+
+    auto track = decode(*reader, reportProgress);
+
+    const juce::ScopedLock sl(lock);
+    bytesReserved -= numBytes;
+    if (track == nullptr)
+    {
+        return nullptr;
+    }
+    // another load of the same file may have finished first
+    if (auto* entry = findEntry(key))
+    {
+        entry->lastUsed = ++useCounter;
+        return entry->track;
+    }
+    entries.push_back({ key, track, ++useCounter });
+    bytesUsed += track->getSizeInBytes();
+    return track;
+}
+
+void PreloadCache::preloadInBackground(const juce::File& source)
+{
+    if (contains(source))
+    {
+        return;
+    }
+    preloadPool.addJob([this, source]
+    {
+        // a decoded copy skips the codec, like a deck loading the track itself
+        auto decodeFrom = source;
+        if (decodeCache != nullptr)
+        {
+            auto cached = decodeCache->findCachedFile(source);
+            if (cached.existsAsFile())
+            {
+                decodeFrom = cached;
+            }
+        }
+        acquire(source, decodeFrom, [](double) {});
+    });
+}
+
+bool PreloadCache::contains(const juce::File& source) const
+{
+    auto key = getKey(source);
+    const juce::ScopedLock sl(lock);
+    for (const auto& entry : entries)
+    {
+        if (entry.key == key)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+juce::int64 PreloadCache::getBytesUsed() const
+{
+    const juce::ScopedLock sl(lock);
+    return bytesUsed;
+}
+
+juce::int64 PreloadCache::getBudget() const
+{
+    return budgetBytes;
+}
+
+juce::String PreloadCache::getKey(const juce::File& source)
+{
+    // a file edited since it was preloaded is decoded again
+    juce::String key;
+    key << source.getFullPathName() << "|" << source.getSize()
+        << "|" << source.getLastModificationTime().toMilliseconds();
+    return key;
+}
+
+bool PreloadCache::makeRoom(juce::int64 numBytes)
+{
+    while (bytesUsed + bytesReserved + numBytes > budgetBytes)
+    {
+        // only the cache holds a track no deck is playing, and only the cache hands out more holders
+        auto oldest = entries.end();
+        for (auto it = entries.begin(); it != entries.end(); ++it)
+        {
+            if (it->track.use_count() == 1 && (oldest == entries.end() || it->lastUsed < oldest->lastUsed))
+            {
+                oldest = it;
+            }
+        }
+        if (oldest == entries.end())
+        {
+            return false;
+        }
+        bytesUsed -= oldest->track->getSizeInBytes();
+        entries.erase(oldest);
+    }
+    return true;
+}
+
+std::shared_ptr<PreloadedTrack> PreloadCache::decode(juce::AudioFormatReader& reader,
+                                                     const std::function<void(double)>& reportProgress)
+{
+    auto track = std::make_shared<PreloadedTrack>();
+    track->sampleRate = reader.sampleRate;
+    track->audio.setSize(juce::jmax(1, (int) reader.numChannels), (int) reader.lengthInSamples);
+
+    for (int pos = 0; pos < track->audio.getNumSamples(); pos += decodeBlockSize)
+    {
+        auto* job = juce::ThreadPoolJob::getCurrentThreadPoolJob();
+        if (job != nullptr && job->shouldExit())
+        {
+            return nullptr;
+        }
+        auto numSamples = juce::jmin(decodeBlockSize, track->audio.getNumSamples() - pos);
+        reader.read(&track->audio, pos, numSamples, pos, true, true);
+        reportProgress((double) (pos + numSamples) / track->audio.getNumSamples());
+    }
+    return track;
+}
+
+PreloadCache::Entry* PreloadCache::findEntry(const juce::String& key)
+{
+    for (auto& entry : entries)
+    {
+        if (entry.key == key)
+        {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "DecodeCache.h"
+
+//==============================================================================
+/*
+    A whole track decoded into RAM, shared by the cache and any deck playing it.
+*/
+struct PreloadedTrack
+{
+    double sampleRate = 0;
+    juce::AudioBuffer<float> audio;
+
+    juce::int64 getSizeInBytes() const
+    {
+        return (juce::int64) audio.getNumChannels() * audio.getNumSamples() * (juce::int64) sizeof(float);
+    }
+};
+
+//==============================================================================
+/*
+    Tracks fully decoded into RAM, so a deck can play without touching the
+    disk or a codec at all, even if the drive the file is on goes away.
+
+    Decks load through the cache, and the playlist can preload likely next
+    tracks ahead of time. All of them share one memory budget. To make room
+    the least recently used tracks that no deck is playing are dropped; a
+    track a deck holds is never freed under it. When the budget is taken by
+    tracks that are playing, a new track isn't preloaded and the deck
+    streams it instead.
+*/
+class PreloadCache
+{
+public:
+    /**Background preloads decode from the decode cache's copy of a track when it has one*/
+    PreloadCache(juce::AudioFormatManager& _formatManager, juce::int64 _budgetBytes,
+                 DecodeCache* _decodeCache = nullptr);
+    ~PreloadCache();
+
+    /**Loader thread: the track in RAM, decoding it first if it isn't there yet. decodeFrom is
+    *  the source itself or a decoded copy of it. Null if it can't be read or won't fit*/
+    std::shared_ptr<const PreloadedTrack> acquire(const juce::File& source,
+                                                  const juce::File& decodeFrom,
+                                                  const std::function<void(double)>& reportProgress);
+    /**Any thread: decodes a track likely to be played soon on a background thread*/
+    void preloadInBackground(const juce::File& source);
+    bool contains(const juce::File& source) const;
+
+    juce::int64 getBytesUsed() const;
+    juce::int64 getBudget() const;
+
+private:
+    struct Entry
+    {
+        juce::String key;
+        std::shared_ptr<const PreloadedTrack> track;
+        juce::uint32 lastUsed;
+    };
+
+    static juce::String getKey(const juce::File& source);
+    /**Called with the lock held: drops unused tracks, oldest first, until the bytes fit*/
+    bool makeRoom(juce::int64 numBytes);
+    std::shared_ptr<PreloadedTrack> decode(juce::AudioFormatReader& reader,
+                                           const std::function<void(double)>& reportProgress);
+    /**Called with the lock held*/
+    Entry* findEntry(const juce::String& key);
+
+    static constexpr int decodeBlockSize = 65536;
+
+    juce::AudioFormatManager& formatManager;
+    juce::int64 budgetBytes;
+    DecodeCache* decodeCache;
+
+    juce::CriticalSection lock;
+    std::vector<Entry> entries;
+    juce::int64 bytesUsed{ 0 };
+    // set aside for tracks being decoded, so two decodes can't both take the last of the budget
+    juce::int64 bytesReserved{ 0 };
+    juce::uint32 useCounter{ 0 };
+
+    // declared last so background preloads stop before anything they use is destroyed
+    juce::ThreadPool preloadPool{ 1 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PreloadCache)
+};
@@ -0,0 +1,67 @@
+#include <JuceHeader.h>
+#include "PreloadedAudioSource.h"
+
+//==============================================================================
+PreloadedAudioSource::PreloadedAudioSource(std::shared_ptr<const PreloadedTrack> _track
+                                          ) : track(std::move(_track))
+{
+}
+
+PreloadedAudioSource::~PreloadedAudioSource()
+{
+}
+
+void PreloadedAudioSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+}
+
+void PreloadedAudioSource::releaseResources()
+{
+}
+
+void PreloadedAudioSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    auto pos = playPos.load(std::memory_order_relaxed);
+    auto numValid = (int) juce::jlimit((juce::int64) 0, (juce::int64) bufferToFill.numSamples,
+                                       getTotalLength() - pos);
+    if (numValid > 0)
+    {
+        // a mono track fills every channel
+        for (int channel = 0; channel < bufferToFill.buffer->getNumChannels(); ++channel)
+        {
+            bufferToFill.buffer->copyFrom(channel, bufferToFill.startSample, track->audio,
+                                          juce::jmin(channel, track->audio.getNumChannels() - 1),
+                                          (int) pos, numValid);
+        }
+    }
+    if (numValid < bufferToFill.numSamples)
+    {
+        bufferToFill.buffer->clear(bufferToFill.startSample + numValid, bufferToFill.numSamples - numValid);
+    }
+    playPos.store(pos + bufferToFill.numSamples, std::memory_order_release);
+}
+
+void PreloadedAudioSource::setNextReadPosition(juce::int64 newPosition)
+{
+    playPos.store(juce::jmax((juce::int64) 0, newPosition), std::memory_order_release);
+}
+
+juce::int64 PreloadedAudioSource::getNextReadPosition() const
+{
+    return playPos.load();
+}
+
+juce::int64 PreloadedAudioSource::getTotalLength() const
+{
+    return track->audio.getNumSamples();
+}
+
+bool PreloadedAudioSource::isLooping() const
+{
+    return false;
+}
+
+double PreloadedAudioSource::getSampleRate() const
+{
+    return track->sampleRate;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "PreloadCache.h"
+
+//==============================================================================
+/*
+    Plays a track that is already decoded in RAM. Every read is a copy out of
+    the shared buffer, so the audio thread never waits on a disk or a codec.
+*/
+class PreloadedAudioSource  : public juce::PositionableAudioSource
+{
+public:
+    explicit PreloadedAudioSource(std::shared_ptr<const PreloadedTrack> _track);
+    ~PreloadedAudioSource() override;
+
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+    void releaseResources() override;
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+    void setNextReadPosition(juce::int64 newPosition) override;
+    juce::int64 getNextReadPosition() const override;
+    juce::int64 getTotalLength() const override;
+    bool isLooping() const override;
+
+    double getSampleRate() const;
+
+private:
+    std::shared_ptr<const PreloadedTrack> track;
+    std::atomic<juce::int64> playPos{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PreloadedAudioSource)
+};
@@ -0,0 +1,44 @@
+#include <JuceHeader.h>
+#include "ReadAheadPool.h"
+
+//==============================================================================
+ReadAheadPool::ReadAheadPool(int numThreads, int bufferSizeSamples) : bufferSize(bufferSizeSamples)
+{
+    for (int i = 0; i < juce::jmax(1, numThreads); ++i)
+    {
+        auto* thread = threads.add(new juce::TimeSliceThread("Deck read-ahead " + juce::String(i + 1)));
+        // above normal so disk reads win against the GUI, below the audio thread
+        thread->startThread(7);
+    }
+}
+
+ReadAheadPool::~ReadAheadPool()
+{
+    for (auto* thread : threads)
+    {
+        thread->stopThread(2000);
+    }
+}
+
+juce::TimeSliceThread& ReadAheadPool::getNextThread()
+{
+    auto* thread = threads[nextThread];
+    nextThread = (nextThread + 1) % threads.size();
+    return *thread;
+}
+
+void ReadAheadPool::setBufferSize(int numSamples)
+{
+    if (numSamples < 4096)
+    {
+        DBG("ReadAheadPool::setBufferSize size should be at least 4096 samples");
+    }
+    else {
+        bufferSize.store(numSamples);
+    }
+}
+
+int ReadAheadPool::getBufferSize() const
+{
+    return bufferSize.load();
+}
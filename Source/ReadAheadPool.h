@@ -0,0 +1,30 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Owns the background threads that decode audio ahead of the decks' playheads.
+    Decks are spread across the threads round-robin so one slow file can't
+    starve every deck.
+*/
+class ReadAheadPool
+{
+public:
+    ReadAheadPool(int numThreads = 2, int bufferSizeSamples = 65536);
+    ~ReadAheadPool();
+
+    /**Returns the thread the next deck should decode on*/
+    juce::TimeSliceThread& getNextThread();
+    /**Sets the read-ahead size used for tracks loaded from now on*/
+    void setBufferSize(int numSamples);
+    /**Gets the read-ahead size in samples*/
+    int getBufferSize() const;
+
+private:
+    juce::OwnedArray<juce::TimeSliceThread> threads;
+    int nextThread{ 0 };
+    std::atomic<int> bufferSize;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ReadAheadPool)
+};
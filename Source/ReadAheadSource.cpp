@@ -0,0 +1,234 @@
+#include <JuceHeader.h>
+#include "ReadAheadSource.h"
+
+//==============================================================================
+ReadAheadSource::ReadAheadSource(juce::PositionableAudioSource* _source,
+                                 juce::TimeSliceThread& thread,
+                                 bool deleteSourceWhenDeleted,
+                                 int bufferSizeSamples,
+                                 std::atomic<int>& underrunCounter,
+                                 int _numChannels
+                                ) : source(_source, deleteSourceWhenDeleted),
+                                    backgroundThread(thread),
+                                    underruns(underrunCounter),
+                                    ringSize(juce::jmax(4096, bufferSizeSamples)),
+                                    numChannels(_numChannels),
+                                    totalLength(_source->getTotalLength())
+{
+}
+
+ReadAheadSource::~ReadAheadSource()
+{
+    releaseResources();
+}
+
+void ReadAheadSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    // the background thread must not touch the ring while it is resized
+    if (isPrepared)
+    {
+        backgroundThread.removeTimeSliceClient(this);
+    }
+
+    source->prepareToPlay(samplesPerBlockExpected, sampleRate);
+    ring.setSize(numChannels, ringSize);
+    ring.clear();
+    sourcePos = -1;
+    restartFillAt(getNextReadPosition());
+    seekRequest.store(-1);
+
+    backgroundThread.addTimeSliceClient(this);
+    isPrepared = true;
+}
+
+void ReadAheadSource::releaseResources()
+{
+    if (isPrepared)
+    {
+        backgroundThread.removeTimeSliceClient(this);
+        source->releaseResources();
+        isPrepared = false;
+    }
+}
+
+void ReadAheadSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    applyPendingSeek();
+
+    auto pos = playPos.load(std::memory_order_relaxed);
+    // samples that exist in the file; anything after the end is silence, not an underrun
+    auto numWanted = (int) juce::jlimit((juce::int64) 0, (juce::int64) bufferToFill.numSamples, totalLength - pos);
+    int numValid = 0;
+
+    if (ackSerial.load(std::memory_order_acquire) == fillSerial.load(std::memory_order_relaxed))
+    {
+        numValid = (int) juce::jlimit((juce::int64) 0, (juce::int64) numWanted,
+                                      validEnd.load(std::memory_order_acquire) - pos);
+    }
+
+    auto numDestChannels = bufferToFill.buffer->getNumChannels();
+    if (numValid > 0)
+    {
+        auto slot = (int) (pos % ringSize);
+        auto firstPart = juce::jmin(numValid, ringSize - slot);
+
+        for (int channel = 0; channel < numDestChannels; ++channel)
+        {
+            auto srcChannel = juce::jmin(channel, numChannels - 1);
+            bufferToFill.buffer->copyFrom(channel, bufferToFill.startSample, ring, srcChannel, slot, firstPart);
+            if (firstPart < numValid)
+            {
+                bufferToFill.buffer->copyFrom(channel, bufferToFill.startSample + firstPart,
+                                              ring, srcChannel, 0, numValid - firstPart);
+            }
+        }
+    }
+
+    if (numValid < bufferToFill.numSamples)
+    {
+        bufferToFill.buffer->clear(bufferToFill.startSample + numValid, bufferToFill.numSamples - numValid);
+    }
+
+    if (numValid < numWanted)
+    {
+        // hold the playhead so playback resumes where the data ran out
+        underruns.fetch_add(1, std::memory_order_relaxed);
+        playPos.store(pos + numValid, std::memory_order_release);
+    }
+    else
+    {
+        playPos.store(pos + bufferToFill.numSamples, std::memory_order_release);
+    }
+}
+
+void ReadAheadSource::setNextReadPosition(juce::int64 newPosition)
+{
+    seekRequest.store(juce::jmax((juce::int64) 0, newPosition));
+}
+
+juce::int64 ReadAheadSource::getNextReadPosition() const
+{
+    auto pending = seekRequest.load();
+    return pending >= 0 ? pending : playPos.load();
+}
+
+juce::int64 ReadAheadSource::getTotalLength() const
+{
+    return totalLength;
+}
+
+bool ReadAheadSource::isLooping() const
+{
+    return false;
+}
+
+bool ReadAheadSource::waitUntilBuffered(int timeoutMs)
+{
+    if (!isPrepared)
+    {
+        return false;
+    }
+
+    auto target = (int) juce::jmin((juce::int64) ringSize / 2, totalLength - getNextReadPosition());
+    auto startTime = juce::Time::getMillisecondCounter();
+
+    while (getNumBufferedSamples() < target)
+    {
+        if (juce::Time::getMillisecondCounter() - startTime > (juce::uint32) timeoutMs)
+        {
+            return false;
+        }
+        backgroundThread.moveToFrontOfQueue(this);
+        juce::Thread::sleep(2);
+    }
+    return true;
+}
+
+int ReadAheadSource::getNumBufferedSamples() const
+{
+    if (seekRequest.load() >= 0
+        || ackSerial.load(std::memory_order_acquire) != fillSerial.load(std::memory_order_acquire))
+    {
+        return 0;
+    }
+    auto buffered = validEnd.load(std::memory_order_acquire) - playPos.load(std::memory_order_acquire);
+    return (int) juce::jlimit((juce::int64) 0, (juce::int64) ringSize, buffered);
+}
+
+// background thread: decode the next chunk after the buffered range
+int ReadAheadSource::useTimeSlice()
+{
+    constexpr int minChunk = 1024;
+    constexpr int maxChunk = 8192;
+
+    auto serial = fillSerial.load(std::memory_order_acquire);
+    if (serial != ackSerial.load(std::memory_order_relaxed))
+    {
+        // the audio thread jumped outside the buffered range, start over there
+        validEnd.store(fillStart.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        ackSerial.store(serial, std::memory_order_release);
+    }
+
+    auto end = validEnd.load(std::memory_order_relaxed);
+    if (end >= totalLength)
+    {
+        return 20;
+    }
+
+    auto freeSpace = (int) juce::jlimit((juce::int64) 0, (juce::int64) ringSize,
+                                        ringSize - (end - playPos.load(std::memory_order_acquire)));
+    if (freeSpace < minChunk)
+    {
+        return 5;
+    }
+
+    auto numToRead = (int) juce::jmin((juce::int64) juce::jmin(freeSpace, maxChunk), totalLength - end);
+    if (sourcePos != end)
+    {
+        source->setNextReadPosition(end);
+    }
+
+    auto slot = (int) (end % ringSize);
+    auto firstPart = juce::jmin(numToRead, ringSize - slot);
+    source->getNextAudioBlock(juce::AudioSourceChannelInfo(&ring, slot, firstPart));
+    if (firstPart < numToRead)
+    {
+        source->getNextAudioBlock(juce::AudioSourceChannelInfo(&ring, 0, numToRead - firstPart));
+    }
+    sourcePos = end + numToRead;
+
+    // only publish if the audio thread did not seek away while we were reading
+    if (fillSerial.load(std::memory_order_acquire) == serial)
+    {
+        validEnd.store(end + numToRead, std::memory_order_release);
+    }
+    return 1;
+}
+
+// audio thread: skip ahead inside the buffer if possible, otherwise refill from the new position
+void ReadAheadSource::applyPendingSeek()
+{
+    auto target = seekRequest.exchange(-1);
+    if (target < 0)
+    {
+        return;
+    }
+
+    auto pos = playPos.load(std::memory_order_relaxed);
+    bool isFilling = ackSerial.load(std::memory_order_acquire) == fillSerial.load(std::memory_order_relaxed);
+    if (isFilling && target >= pos && target <= validEnd.load(std::memory_order_acquire))
+    {
+        playPos.store(target, std::memory_order_release);
+    }
+    else
+    {
+        restartFillAt(target);
+    }
+}
+
+void ReadAheadSource::restartFillAt(juce::int64 position)
+{
+    playPos.store(position, std::memory_order_release);
+    fillStart.store(position, std::memory_order_relaxed);
+    fillSerial.fetch_add(1, std::memory_order_release);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Wraps a PositionableAudioSource and decodes it ahead of the playhead on a
+    background TimeSliceThread, so getNextAudioBlock only ever copies from RAM.
+
+    The audio thread is the only consumer, the background thread the only
+    producer; they talk through atomics, never locks. When the buffer runs dry
+    the missing part of the block is silenced, the playhead holds still and the
+    underrun counter is bumped.
+*/
+class ReadAheadSource  : public juce::PositionableAudioSource,
+                         private juce::TimeSliceClient
+{
+public:
+    ReadAheadSource(juce::PositionableAudioSource* source,
+                    juce::TimeSliceThread& thread,
+                    bool deleteSourceWhenDeleted,
+                    int bufferSizeSamples,
+                    std::atomic<int>& underrunCounter,
+                    int numChannels = 2);
+    ~ReadAheadSource() override;
+
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+    void releaseResources() override;
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+    /**Requests a seek, applied by the audio thread at the start of its next block*/
+    void setNextReadPosition(juce::int64 newPosition) override;
+    juce::int64 getNextReadPosition() const override;
+    juce::int64 getTotalLength() const override;
+    bool isLooping() const override;
+
+    /**Blocks until enough audio is buffered to start playback, or the timeout passes*/
+    bool waitUntilBuffered(int timeoutMs);
+    /**Number of samples decoded ahead of the playhead*/
+    int getNumBufferedSamples() const;
+
+private:
+    int useTimeSlice() override;
+    void applyPendingSeek();
+    void restartFillAt(juce::int64 position);
+
+    juce::OptionalScopedPointer<juce::PositionableAudioSource> source;
+    juce::TimeSliceThread& backgroundThread;
+    std::atomic<int>& underruns;
+
+    juce::AudioBuffer<float> ring;
+    int ringSize;
+    int numChannels;
+    juce::int64 totalLength;
+    bool isPrepared{ false };
+
+    // written by any thread, consumed by the audio thread
+    std::atomic<juce::int64> seekRequest{ -1 };
+    // owned by the audio thread
+    std::atomic<juce::int64> playPos{ 0 };
+    std::atomic<juce::int64> fillStart{ 0 };
+    std::atomic<juce::uint32> fillSerial{ 0 };
+    // owned by the background thread
+    std::atomic<juce::uint32> ackSerial{ 0 };
+    std::atomic<juce::int64> validEnd{ 0 };
+    juce::int64 sourcePos{ -1 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ReadAheadSource)
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Passes heap objects (loaded tracks, pre-decoded segments...) to the audio
+    thread without locking or freeing memory on it.
+
+    Any other thread publishes an object; the audio thread picks it up with
+    acquire() at the start of a block and retires the one it replaces into a
+    small FIFO. Retired objects are deleted later by collectGarbage(), which
+    must never be called from the audio thread.
+*/
+template <typename ObjectType>
+class RealtimeHandoff
+{
+public:
+    RealtimeHandoff() = default;
+
+    /**Only safe once the audio thread has stopped calling acquire()*/
+    ~RealtimeHandoff()
+    {
+        delete pending.exchange(nullptr);
+        delete current;
+        collectGarbage();
+    }
+
+    /**Queues an object for the audio thread. Replaces one it has not picked up yet*/
+    void publish(std::unique_ptr<ObjectType> object)
+    {
+        std::unique_ptr<ObjectType> unclaimed(pending.exchange(object.release(), std::memory_order_acq_rel));
+        collectGarbage();
+    }
+
+    /**Audio thread: returns the current object after swapping in a newly published one*/
+    ObjectType* acquire() noexcept
+    {
+        // a full retire queue just delays the swap until the message thread catches up
+        if (pending.load(std::memory_order_relaxed) != nullptr && retiredFifo.getFreeSpace() > 0)
+        {
+            auto* next = pending.exchange(nullptr, std::memory_order_acq_rel);
+            if (next != nullptr)
+            {
+                if (current != nullptr)
+                {
+                    int start1, size1, start2, size2;
+                    retiredFifo.prepareToWrite(1, start1, size1, start2, size2);
+                    retired[size1 > 0 ? start1 : start2] = current;
+                    retiredFifo.finishedWrite(1);
+                }
+                current = next;
+            }
+        }
+        return current;
+    }
+
+    /**Audio thread: the object returned by the last acquire()*/
+    ObjectType* get() const noexcept
+    {
+        return current;
+    }
+
+    /**Deletes the objects the audio thread has finished with*/
+    void collectGarbage()
+    {
+        const juce::ScopedLock sl(collectLock);
+        int start1, size1, start2, size2;
+        auto numReady = retiredFifo.getNumReady();
+        retiredFifo.prepareToRead(numReady, start1, size1, start2, size2);
+        for (int i = 0; i < size1; ++i)
+        {
+            delete retired[start1 + i];
+        }
+        for (int i = 0; i < size2; ++i)
+        {
+            delete retired[start2 + i];
+        }
+        retiredFifo.finishedRead(size1 + size2);
+    }
+
+private:
+    static constexpr int retireCapacity = 8;
+
+    std::atomic<ObjectType*> pending{ nullptr };
+    ObjectType* current = nullptr;
+    juce::AbstractFifo retiredFifo{ retireCapacity };
+    ObjectType* retired[retireCapacity] = {};
+    juce::CriticalSection collectLock;
+
+    JUCE_DECLARE_NON_COPYABLE (RealtimeHandoff)
+};
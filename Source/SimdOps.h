@@ -0,0 +1,94 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#if defined (__SSE2__) || defined (_M_X64) || defined (_M_AMD64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define DJ_SIMD_SSE 1
+#elif defined (__ARM_NEON__) || defined (__ARM_NEON) || defined (_M_ARM64)
+ #include <arm_neon.h>
+ #define DJ_SIMD_NEON 1
+#endif
+
+//==============================================================================
+/*
+    Four-lane float helpers for the DSP kernels. Maps to SSE2 on x86, NEON on
+    ARM and plain loops anywhere else. Loads and stores don't need alignment.
+*/
+namespace SimdOps
+{
+   #if DJ_SIMD_SSE
+    using Float4 = __m128;
+
+    inline Float4 load(const float* p)                   { return _mm_loadu_ps(p); }
+    inline void store(float* p, Float4 v)                { _mm_storeu_ps(p, v); }
+    inline Float4 broadcast(float x)                     { return _mm_set1_ps(x); }
+    inline Float4 add(Float4 a, Float4 b)                { return _mm_add_ps(a, b); }
+    inline Float4 sub(Float4 a, Float4 b)                { return _mm_sub_ps(a, b); }
+    inline Float4 mul(Float4 a, Float4 b)                { return _mm_mul_ps(a, b); }
+    inline Float4 mulAdd(Float4 acc, Float4 a, Float4 b) { return _mm_add_ps(acc, _mm_mul_ps(a, b)); }
+
+    inline float sum(Float4 v)
+    {
+        auto pairs = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+   #elif DJ_SIMD_NEON
+    using Float4 = float32x4_t;
+
+    inline Float4 load(const float* p)                   { return vld1q_f32(p); }
+    inline void store(float* p, Float4 v)                { vst1q_f32(p, v); }
+    inline Float4 broadcast(float x)                     { return vdupq_n_f32(x); }
+    inline Float4 add(Float4 a, Float4 b)                { return vaddq_f32(a, b); }
+    inline Float4 sub(Float4 a, Float4 b)                { return vsubq_f32(a, b); }
+    inline Float4 mul(Float4 a, Float4 b)                { return vmulq_f32(a, b); }
+    inline Float4 mulAdd(Float4 acc, Float4 a, Float4 b) { return vmlaq_f32(acc, a, b); }
+
+    inline float sum(Float4 v)
+    {
+        auto pairs = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+        return vget_lane_f32(vpadd_f32(pairs, pairs), 0);
+    }
+   #else
+    struct Float4 { float lane[4]; };
+
+    inline Float4 load(const float* p)                   { return { { p[0], p[1], p[2], p[3] } }; }
+    inline void store(float* p, Float4 v)                { for (int i = 0; i < 4; ++i) p[i] = v.lane[i]; }
+    inline Float4 broadcast(float x)                     { return { { x, x, x, x } }; }
+
+    inline Float4 add(Float4 a, Float4 b)
+    {
+        return { { a.lane[0] + b.lane[0], a.lane[1] + b.lane[1], a.lane[2] + b.lane[2], a.lane[3] + b.lane[3] } };
+    }
+
+    inline Float4 sub(Float4 a, Float4 b)
+    {
+        return { { a.lane[0] - b.lane[0], a.lane[1] - b.lane[1], a.lane[2] - b.lane[2], a.lane[3] - b.lane[3] } };
+    }
+
+    inline Float4 mul(Float4 a, Float4 b)
+    {
+        return { { a.lane[0] * b.lane[0], a.lane[1] * b.lane[1], a.lane[2] * b.lane[2], a.lane[3] * b.lane[3] } };
+    }
+
+    inline Float4 mulAdd(Float4 acc, Float4 a, Float4 b) { return add(acc, mul(a, b)); }
+    inline float sum(Float4 v)                           { return (v.lane[0] + v.lane[1]) + (v.lane[2] + v.lane[3]); }
+   #endif
+
+    /**Dot product of two arrays of any length*/
+    inline float dot(const float* a, const float* b, int numSamples)
+    {
+        auto acc = broadcast(0.0f);
+        int i = 0;
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            acc = mulAdd(acc, load(a + i), load(b + i));
+        }
+        auto result = sum(acc);
+        for (; i < numSamples; ++i)
+        {
+            result += a[i] * b[i];
+        }
+        return result;
+    }
+}
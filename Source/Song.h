@@ -1,6 +1,9 @@
 
 #pragma once
 #include <JuceHeader.h>
+#include "HotCues.h"
+#include "BeatGrid.h"
+#include "MusicalKey.h"
 
 class Song
 {
@@ -9,7 +12,15 @@ class Song
         juce::File file;
         juce::URL URL;
         juce::String title;
-        juce::String length;
+        /**0 until the file has been read; formatted only when it is shown*/
+        int lengthMs = 0;
+        /**stored with the track and passed to the deck it is loaded into*/
+        HotCues hotCues;
+        BeatGrid beatGrid;
+        MusicalKey key;
+        /**the file as it was when it was last read, 0 if not known*/
+        juce::int64 fileSize = 0;
+        juce::int64 modificationTime = 0;
         /**objects are compared by title*/
         bool operator==(const juce::String& other) const;
 };
\ No newline at end of file
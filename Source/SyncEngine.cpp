@@ -0,0 +1,88 @@
+#include <JuceHeader.h>
+#include "SyncEngine.h"
+
+//==============================================================================
+SyncEngine::SyncEngine()
+{
+}
+
+SyncEngine::~SyncEngine()
+{
+}
+
+void SyncEngine::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    masterReported.store(false);
+    chunkTempo = tempo.load();
+}
+
+void SyncEngine::beginChunk(int numSamples)
+{
+    if (masterReported.exchange(false, std::memory_order_acq_rel))
+    {
+        chunkTempo = masterBpm.load(std::memory_order_relaxed);
+        chunkBeats = masterBeats.load(std::memory_order_relaxed);
+        // if the master stops, the clock carries on at its tempo
+        tempo.store(chunkTempo);
+    }
+    else
+    {
+        chunkTempo = tempo.load();
+        chunkBeats = nextBeats;
+    }
+    if (sampleRate > 0)
+    {
+        nextBeats = chunkBeats + numSamples * chunkTempo / (60.0 * sampleRate);
+    }
+}
+
+void SyncEngine::setMaster(const void* deck)
+{
+    master.store(deck);
+}
+
+bool SyncEngine::isMaster(const void* deck) const
+{
+    return deck != nullptr && master.load(std::memory_order_relaxed) == deck;
+}
+
+void SyncEngine::setTempo(double bpm)
+{
+    if (bpm < minTempo || bpm > maxTempo)
+    {
+        DBG("SyncEngine::setTempo bpm should be between " << minTempo << " and " << maxTempo);
+    }
+    else {
+        tempo.store(bpm);
+    }
+}
+
+double SyncEngine::getTempo() const
+{
+    return tempo.load();
+}
+
+void SyncEngine::reportMaster(double bpm, double beatPosition)
+{
+    if (bpm >= minTempo && bpm <= maxTempo)
+    {
+        masterBpm.store(bpm, std::memory_order_relaxed);
+        masterBeats.store(beatPosition, std::memory_order_relaxed);
+        masterReported.store(true, std::memory_order_release);
+    }
+}
+
+double SyncEngine::getFollowerSpeed(double gridBpm, double beatPosition) const
+{
+    if (gridBpm <= 0 || chunkTempo <= 0)
+    {
+        return 0;
+    }
+    // how far the deck's beats trail the clock's, towards whichever clock beat is nearer
+    auto phaseError = chunkBeats - beatPosition;
+    phaseError -= std::round(phaseError);
+    // proportional, so the nudge eases off as the gap closes rather than overshooting
+    auto correction = juce::jlimit(-maxCorrection, maxCorrection, phaseError / phaseLockBeats);
+    return chunkTempo / gridBpm * (1.0 + correction);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    A shared beat clock the decks can sync to. When a deck is master the clock
+    follows it. Otherwise it keeps running at its own tempo, which is the last
+    master's tempo or whatever the user sets.
+
+    The mixer moves the clock on before each chunk it renders. A following
+    deck then compares its beat position with the clock's and plays at the
+    clock's tempo, nudged faster or slower until the beats line up. The decks
+    render in parallel, so the master reports where it got to during one
+    chunk and the clock picks that up at the start of the next.
+
+    Positions come from each deck's transport, in samples of the track, at
+    the chunk boundaries, less the track its stretcher and resampler still
+    hold, so they are where each deck is audibly rather than where it has
+    read to.
+*/
+class SyncEngine
+{
+public:
+    SyncEngine();
+    ~SyncEngine();
+
+    /**Called before playback starts, e.g. from prepareToPlay*/
+    void prepare(double sampleRate);
+    /**Audio thread: moves the clock to the start of the next chunk, before any deck renders it*/
+    void beginChunk(int numSamples);
+
+    /**Makes a deck the master, identified by any address unique to it, or none with nullptr*/
+    void setMaster(const void* deck);
+    bool isMaster(const void* deck) const;
+    /**The clock's tempo when no master is playing. Ignored while one is*/
+    void setTempo(double bpm);
+    double getTempo() const;
+
+    /**Render thread: the master's tempo as it plays and its beat position at the end of the chunk*/
+    void reportMaster(double bpm, double beatPosition);
+    /**Render thread: the speed a following deck should play the chunk at, 0 if it can't follow.
+    *  gridBpm is the deck's tempo at normal speed, beatPosition where its playhead is in beats*/
+    double getFollowerSpeed(double gridBpm, double beatPosition) const;
+
+    static constexpr double minTempo = 40.0;
+    static constexpr double maxTempo = 250.0;
+
+private:
+    // the most the speed is nudged to close a phase gap, so the correction stays inaudible
+    static constexpr double maxCorrection = 0.02;
+    // a gap is closed over about this many beats
+    static constexpr double phaseLockBeats = 2.0;
+
+    double sampleRate{ 0 };
+    std::atomic<const void*> master{ nullptr };
+    std::atomic<double> tempo{ 120.0 };
+
+    // written by the master's render, picked up at the start of the next chunk
+    std::atomic<double> masterBpm{ 0 };
+    std::atomic<double> masterBeats{ 0 };
+    std::atomic<bool> masterReported{ false };
+
+    // audio thread: the clock at the start of the chunk being rendered, only written between renders
+    double chunkTempo{ 120.0 };
+    double chunkBeats{ 0 };
+    double nextBeats{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SyncEngine)
+};
@@ -0,0 +1,180 @@
+#include <JuceHeader.h>
+#include "TelemetryPanel.h"
+
+namespace
+{
+    juce::String toPercent(double load)
+    {
+        return juce::String(load * 100.0, 1) + "%";
+    }
+}
+
+//==============================================================================
+TelemetryPanel::TelemetryPanel(AudioTelemetry& _telemetry,
+                               DeckMixer& _mixer,
+                               DeckManager& _deckManager,
+                               juce::AudioDeviceManager& _deviceManager
+                              ) : telemetry(_telemetry),
+                                  mixer(_mixer),
+                                  deckManager(_deckManager),
+                                  deviceManager(_deviceManager)
+{
+    addAndMakeVisible(resetButton);
+    addAndMakeVisible(saveButton);
+
+    resetButton.setColour(juce::ComboBox::outlineColourId, juce::Colours::deepskyblue);
+    resetButton.setColour(juce::TextButton::textColourOffId, juce::Colours::deepskyblue);
+    saveButton.setColour(juce::ComboBox::outlineColourId, juce::Colours::deepskyblue);
+    saveButton.setColour(juce::TextButton::textColourOffId, juce::Colours::deepskyblue);
+    resetButton.addListener(this);
+    saveButton.addListener(this);
+
+    startTimerHz(refreshRateHz);
+}
+
+TelemetryPanel::~TelemetryPanel()
+{
+    stopTimer();
+}
+
+void TelemetryPanel::paint(juce::Graphics& g)
+{
+    g.fillAll(getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
+    g.setColour(juce::Colours::black);
+    g.drawRect(getLocalBounds(), 1);
+
+    auto area = getLocalBounds().reduced(6, 4);
+    g.setColour(juce::Colours::cyan);
+    g.setFont(15.0f);
+    g.drawText("Audio", area.removeFromTop(lineHeight + 2), juce::Justification::centredTop, true);
+
+    g.setFont(13.0f);
+    g.setColour(juce::Colours::white);
+    g.drawText("CPU " + toPercent(recent.getAverageLoad()) + "   peak " + toPercent(total.peakLoad)
+                   + "   blocks " + juce::String(total.numBlocks),
+               area.removeFromTop(lineHeight), juce::Justification::centredLeft, true);
+
+    auto hasGlitches = total.overruns > 0 || total.lateCallbacks > 0 || total.deviceXRuns > 0;
+    g.setColour(hasGlitches ? juce::Colours::red : juce::Colours::limegreen);
+    g.drawText("Overruns " + juce::String(total.overruns)
+                   + "   late callbacks " + juce::String(total.lateCallbacks)
+                   + "   device xruns " + (total.deviceXRuns < 0 ? juce::String("n/a")
+                                                                  : juce::String(total.deviceXRuns)),
+               area.removeFromTop(lineHeight), juce::Justification::centredLeft, true);
+
+    g.setColour(juce::Colours::white);
+    g.drawText("Decks rendered " + juce::String(renderStats.parallelBlocks) + " blocks in parallel, "
+                   + juce::String(renderStats.serialBlocks) + " serially, "
+                   + juce::String(renderStats.deadlineMisses) + " missed deadlines, "
+                   + juce::String(renderStats.lateJobs) + " late decks",
+               area.removeFromTop(lineHeight), juce::Justification::centredLeft, true);
+
+    area.removeFromTop(4);
+    paintHistogram(g, area.removeFromTop(56));
+    area.removeFromTop(4);
+
+    area.removeFromBottom(resetButton.getHeight() + 4);
+    for (int i = 0; i < deckManager.getNumDecks() && area.getHeight() >= lineHeight; ++i)
+    {
+        auto deckNumber = deckManager.getDeckNumber(i);
+        const auto& deck = recent.decks[deckNumber - 1];
+        const auto& deckTotal = total.decks[deckNumber - 1];
+
+        juce::String text("Deck " + juce::String(deckNumber));
+        for (int stage = 0; stage < AudioTelemetry::numDeckStages; ++stage)
+        {
+            text << "   " << AudioTelemetry::getStageName(stage) << " " << toPercent(deck.getStageLoad(stage));
+        }
+        text << "   peak " << toPercent(deckTotal.peakLoad)
+             << " (" << AudioTelemetry::getStageName(deckTotal.peakStage) << ")"
+             << "   underruns " << deckTotal.underruns;
+
+        g.setColour(deckTotal.underruns > 0 ? juce::Colours::orange : juce::Colours::white);
+        g.drawText(text, area.removeFromTop(lineHeight), juce::Justification::centredLeft, true);
+    }
+}
+
+void TelemetryPanel::paintHistogram(juce::Graphics& g, juce::Rectangle<int> area)
+{
+    auto labels = area.removeFromBottom(lineHeight);
+    g.setColour(juce::Colours::grey);
+    g.drawText("0%", labels, juce::Justification::centredLeft, true);
+    g.drawText("block load", labels, juce::Justification::centred, true);
+    g.drawText("100%+", labels, juce::Justification::centredRight, true);
+
+    juce::int64 largest = 1;
+    for (auto count : total.histogram)
+    {
+        largest = juce::jmax(largest, count);
+    }
+
+    // square root scale, so the rare slow blocks still show next to the common ones
+    auto barWidth = (float) area.getWidth() / AudioTelemetry::numLoadBins;
+    for (int bin = 0; bin < AudioTelemetry::numLoadBins; ++bin)
+    {
+        auto count = total.histogram[bin];
+        if (count == 0)
+        {
+            continue;
+        }
+        auto height = juce::jmax(1.0f, area.getHeight() * std::sqrt((float) count / (float) largest));
+        g.setColour(bin == AudioTelemetry::numLoadBins - 1 ? juce::Colours::red : juce::Colours::deepskyblue);
+        g.fillRect(area.getX() + bin * barWidth + 1.0f, area.getBottom() - height, barWidth - 2.0f, height);
+    }
+}
+
+void TelemetryPanel::resized()
+{
+    auto buttonHeight = 24;
+    auto buttons = getLocalBounds().reduced(4).removeFromBottom(buttonHeight);
+    resetButton.setBounds(buttons.removeFromLeft(buttons.getWidth() / 2));
+    saveButton.setBounds(buttons);
+}
+
+void TelemetryPanel::buttonClicked(juce::Button* button)
+{
+    if (button == &resetButton)
+    {
+        DBG("TelemetryPanel reset button was clicked ");
+        telemetry.reset();
+    }
+    if (button == &saveButton)
+    {
+        DBG("TelemetryPanel save button was clicked ");
+        saveReport();
+    }
+}
+
+void TelemetryPanel::timerCallback()
+{
+    auto* device = deviceManager.getCurrentAudioDevice();
+    telemetry.setDeviceXRuns(device != nullptr ? device->getXRunCount() : -1);
+
+    total = telemetry.getSnapshot();
+    recent = total.since(previousSnapshot);
+    previousSnapshot = total;
+    renderStats = mixer.getRenderStats();
+    repaint();
+}
+
+void TelemetryPanel::saveReport()
+{
+    juce::FileChooser chooser{ "Save telemetry report",
+                               juce::File::getCurrentWorkingDirectory().getChildFile("telemetry.json"),
+                               "*.json" };
+    if (chooser.browseForFileToSave(true))
+    {
+        auto report = telemetry.createReport();
+        if (auto* object = report.getDynamicObject())
+        {
+            object->setProperty("parallelBlocks", renderStats.parallelBlocks);
+            object->setProperty("serialBlocks", renderStats.serialBlocks);
+            object->setProperty("deadlineMisses", renderStats.deadlineMisses);
+            object->setProperty("lateJobs", renderStats.lateJobs);
+        }
+        if (!chooser.getResult().replaceWithText(juce::JSON::toString(report)))
+        {
+            DBG("TelemetryPanel::saveReport could not write " << chooser.getResult().getFullPathName());
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "AudioTelemetry.h"
+#include "DeckManager.h"
+#include "DeckMixer.h"
+
+//==============================================================================
+/*
+    Shows the audio telemetry: the callback load over the last refresh and
+    its peak, overruns and late callbacks, the device's own xrun count, a
+    histogram of block loads and each deck's load per stage. RESET starts the
+    counts again and SAVE REPORT writes them to a JSON file.
+*/
+class TelemetryPanel  : public juce::Component,
+                        public juce::Button::Listener,
+                        private juce::Timer
+{
+public:
+    TelemetryPanel(AudioTelemetry& _telemetry,
+                   DeckMixer& _mixer,
+                   DeckManager& _deckManager,
+                   juce::AudioDeviceManager& _deviceManager);
+    ~TelemetryPanel() override;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+
+    void buttonClicked(juce::Button* button) override;
+
+private:
+    /**Polls the device's xrun count and takes a new snapshot*/
+    void timerCallback() override;
+    void saveReport();
+    void paintHistogram(juce::Graphics& g, juce::Rectangle<int> area);
+
+    static constexpr int refreshRateHz = 4;
+    static constexpr int lineHeight = 16;
+
+    AudioTelemetry& telemetry;
+    DeckMixer& mixer;
+    DeckManager& deckManager;
+    juce::AudioDeviceManager& deviceManager;
+
+    AudioTelemetry::Snapshot previousSnapshot;
+    // what accumulated since the previous refresh, apart from the peaks
+    AudioTelemetry::Snapshot recent;
+    AudioTelemetry::Snapshot total;
+    DeckRenderPool::Stats renderStats;
+
+    juce::TextButton resetButton{ "RESET" };
+    juce::TextButton saveButton{ "SAVE REPORT" };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TelemetryPanel)
+};
@@ -0,0 +1,450 @@
+#include <JuceHeader.h>
+#include "TimeStretcher.h"
+#include "SimdOps.h"
+
+//==============================================================================
+TimeStretcher::TimeStretcher(juce::AudioSource* inputSource,
+                             int _numChannels
+                            ) : input(inputSource),
+                                numChannels(_numChannels)
+{
+}
+
+TimeStretcher::~TimeStretcher()
+{
+}
+
+void TimeStretcher::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    // frames of roughly 20ms, a power of two so a hop is exactly half a frame
+    frameSize = sampleRate > 100000 ? 4096 : (sampleRate > 50000 ? 2048 : 1024);
+    hopSize = frameSize / 2;
+    searchRange = frameSize / 8;
+
+    // periodic Hann, so windows half a frame apart sum to exactly one
+    window.resize((size_t) frameSize);
+    for (int i = 0; i < frameSize; ++i)
+    {
+        window[(size_t) i] = 0.5f - 0.5f * std::cos(2.0f * juce::MathConstants<float>::pi * i / frameSize);
+    }
+
+    // enough for the widest search plus the fastest two hops through the input, as the
+    // hop playing and the one being rendered both keep their input
+    auto capacity = (int) std::ceil(2 * maxFactor * hopSize) + 2 * frameSize + 4 * searchRange;
+    inputBuffer.setSize(numChannels, capacity);
+    overlapBuffer.setSize(numChannels, frameSize);
+    readyBuffer.setSize(numChannels, 2 * hopSize);
+    searchReference.resize((size_t) hopSize / 2);
+    searchCandidates.resize((size_t) (hopSize / 2 + searchRange + 1));
+
+    input->prepareToPlay(samplesPerBlockExpected, sampleRate);
+    flushBuffers();
+}
+
+void TimeStretcher::releaseResources()
+{
+    input->releaseResources();
+    inputBuffer.setSize(numChannels, 0);
+    frameSize = 0;
+}
+
+void TimeStretcher::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    if (frameSize == 0)
+    {
+        bufferToFill.clearActiveBufferRegion();
+        return;
+    }
+
+    auto numOutChannels = juce::jmin(bufferToFill.buffer->getNumChannels(), numChannels);
+    for (int done = 0; done < bufferToFill.numSamples;)
+    {
+        if (readyPos < numReady)
+        {
+            auto numThisTime = juce::jmin(numReady - readyPos, bufferToFill.numSamples - done);
+            for (int channel = 0; channel < numOutChannels; ++channel)
+            {
+                bufferToFill.buffer->copyFrom(channel, bufferToFill.startSample + done,
+                                              readyBuffer, channel, readyOffset + readyPos, numThisTime);
+            }
+            readyPos += numThisTime;
+            done += numThisTime;
+            // keep the next hop's work in step with how much of this one has played
+            workOnNextHop((numHopSteps * readyPos + numReady - 1) / numReady);
+        }
+        else if (!stretching)
+        {
+            if (!isNeutral())
+            {
+                startStretching();
+                continue;
+            }
+            readPassThrough(juce::AudioSourceChannelInfo(bufferToFill.buffer,
+                                                         bufferToFill.startSample + done,
+                                                         bufferToFill.numSamples - done));
+            done = bufferToFill.numSamples;
+        }
+        else if (isNeutral() && readyExact)
+        {
+            // the output so far joins the input seamlessly here, so stop stretching
+            stretching = false;
+            passThroughPos = readyEnd;
+        }
+        else
+        {
+            // only the first hop after starting is still unfinished here, and it needs no search
+            workOnNextHop(numHopSteps);
+            playNextHop();
+        }
+    }
+
+    for (int channel = numOutChannels; channel < bufferToFill.buffer->getNumChannels(); ++channel)
+    {
+        bufferToFill.buffer->clear(channel, bufferToFill.startSample, bufferToFill.numSamples);
+    }
+}
+
+void TimeStretcher::setStretchFactor(double factor)
+{
+    stretchFactor = juce::jlimit(minFactor, maxFactor, factor);
+}
+
+void TimeStretcher::flushBuffers()
+{
+    stretching = false;
+    hasPreviousFrame = false;
+    bufferStart = 0;
+    numBuffered = 0;
+    passThroughPos = 0;
+    readyOffset = 0;
+    readyPos = 0;
+    numReady = 0;
+    hopStage = HopStage::done;
+    overlapBuffer.clear();
+}
+
+bool TimeStretcher::isStretching() const
+{
+    return stretching;
+}
+
+double TimeStretcher::getLatency() const
+{
+    auto readEnd = bufferStart + numBuffered;
+    if (!stretching)
+    {
+        return (double) juce::jmax((juce::int64) 0, readEnd - passThroughPos);
+    }
+    if (numReady == 0)
+    {
+        // nothing stretched has played yet, so the first hop starts where pass-through stopped
+        return (double) juce::jmax((juce::int64) 0, readEnd - readyEnd);
+    }
+    // a hop crossfades from the last frame's continuation into its own frame, so what is
+    // heard lies between the two, weighted by the window
+    auto frameStart = readyEnd - numReady;
+    auto fade = (double) window[(size_t) readyPos];
+    auto playing = (double) (readyFadeFrom + readyPos) + fade * (double) (frameStart - readyFadeFrom);
+    return juce::jmax(0.0, (double) readEnd - playing);
+}
+
+bool TimeStretcher::isNeutral() const
+{
+    return std::abs(stretchFactor - 1.0) < 1.0e-6;
+}
+
+void TimeStretcher::startStretching()
+{
+    // the first frame starts exactly where pass-through left off
+    discardBefore(passThroughPos);
+    nominalPos = (double) passThroughPos;
+    hasPreviousFrame = false;
+    overlapBuffer.clear();
+    // nothing stretched has played yet, so pass-through could take straight back over
+    readyPos = 0;
+    numReady = 0;
+    readyExact = true;
+    readyEnd = passThroughPos;
+    stretching = true;
+    planNextHop();
+}
+
+void TimeStretcher::planNextHop()
+{
+    hopSearches = false;
+    if (!hasPreviousFrame)
+    {
+        hopFramePos = (juce::int64) nominalPos;
+    }
+    else if (isNeutral())
+    {
+        // follow the input exactly so pass-through can take over after this hop
+        hopFramePos = previousFramePos + hopSize;
+        nominalPos = (double) hopFramePos;
+    }
+    else
+    {
+        hopSearches = true;
+        hopTarget = (juce::int64) std::llround(nominalPos);
+        hopContinuation = previousFramePos + hopSize;
+        hopFirstCandidate = juce::jmax(bufferStart, hopTarget - searchRange);
+    }
+
+    hopReadEnd = (hopSearches ? juce::jmax(hopTarget + searchRange + 1, hopContinuation) : hopFramePos) + frameSize;
+    auto numToRead = juce::jmax((juce::int64) 0, hopReadEnd - (bufferStart + numBuffered));
+    auto numReadSteps = (int) ((numToRead + hopSize - 1) / hopSize);
+    auto numSearchSteps = hopSearches ? 2 + (searchRange + lagsPerStep) / lagsPerStep : 0;
+    numHopSteps = numReadSteps + numSearchSteps + 1;
+    numHopStepsDone = 0;
+    hopStage = HopStage::read;
+}
+
+void TimeStretcher::workOnNextHop(int stepsDue)
+{
+    while (numHopStepsDone < stepsDue && hopStage != HopStage::done)
+    {
+        doHopStep();
+        ++numHopStepsDone;
+    }
+    // the step count is an estimate, so make sure the hop is finished once it is due
+    while (numHopStepsDone >= numHopSteps && hopStage != HopStage::done)
+    {
+        doHopStep();
+    }
+}
+
+void TimeStretcher::doHopStep()
+{
+    if (hopStage == HopStage::read)
+    {
+        auto readEnd = bufferStart + numBuffered;
+        if (readEnd < hopReadEnd)
+        {
+            ensureBuffered(juce::jmin(hopReadEnd, readEnd + hopSize));
+            return;
+        }
+        hopStage = hopSearches ? HopStage::prepareSearch : HopStage::mix;
+    }
+
+    switch (hopStage)
+    {
+        case HopStage::prepareSearch:   prepareSearch(); break;
+        case HopStage::search:          searchLags(); break;
+        case HopStage::refine:          refineSearch(); break;
+        case HopStage::mix:             mixFrame(); break;
+        case HopStage::read:
+        case HopStage::done:
+        default:                        break;
+    }
+}
+
+void TimeStretcher::prepareSearch()
+{
+    auto numReference = hopSize / 2;
+    auto getMono = [this](juce::int64 pos)
+    {
+        float mono = 0;
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            mono += *getInput(channel, pos);
+        }
+        return mono;
+    };
+    for (int i = 0; i < numReference; ++i)
+    {
+        searchReference[(size_t) i] = getMono(hopContinuation + 2 * i);
+    }
+    for (int i = 0; i < numReference + searchRange; ++i)
+    {
+        searchCandidates[(size_t) i] = getMono(hopFirstCandidate + 2 * i);
+    }
+
+    searchEnergy = 0;
+    for (int i = 0; i < numReference; ++i)
+    {
+        searchEnergy += searchCandidates[(size_t) i] * searchCandidates[(size_t) i];
+    }
+    bestCoarse = 0;
+    bestScore = -std::numeric_limits<double>::max();
+    searchLag = 0;
+    hopStage = HopStage::search;
+}
+
+void TimeStretcher::searchLags()
+{
+    auto numReference = hopSize / 2;
+    auto numCoarse = searchRange + 1;
+    auto endLag = juce::jmin(numCoarse, searchLag + lagsPerStep);
+    for (int k = searchLag; k < endLag; ++k)
+    {
+        auto correlation = SimdOps::dot(searchReference.data(), searchCandidates.data() + k, numReference);
+        auto score = correlation / std::sqrt(juce::jmax(searchEnergy, 0.0) + 1.0e-9);
+        if (score > bestScore)
+        {
+            bestScore = score;
+            bestCoarse = k;
+        }
+        if (k + 1 < numCoarse)
+        {
+            auto leaving = searchCandidates[(size_t) k];
+            auto entering = searchCandidates[(size_t) (k + numReference)];
+            searchEnergy += entering * entering - leaving * leaving;
+        }
+    }
+    searchLag = endLag;
+    if (searchLag >= numCoarse)
+    {
+        hopStage = HopStage::refine;
+    }
+}
+
+void TimeStretcher::refineSearch()
+{
+    auto coarsePos = hopFirstCandidate + 2 * bestCoarse;
+    hopFramePos = coarsePos;
+    auto bestRefined = -std::numeric_limits<double>::max();
+    for (auto candidate = juce::jmax(bufferStart, coarsePos - 1); candidate <= coarsePos + 1; ++candidate)
+    {
+        float candidateEnergy = 0;
+        auto correlation = getCorrelation(hopContinuation, candidate, candidateEnergy);
+        auto score = correlation / std::sqrt(juce::jmax(candidateEnergy, 0.0f) + 1.0e-9);
+        if (score > bestRefined)
+        {
+            bestRefined = score;
+            hopFramePos = candidate;
+        }
+    }
+    hopStage = HopStage::mix;
+}
+
+void TimeStretcher::mixFrame()
+{
+    auto framePos = hopFramePos;
+    nextExact = !hasPreviousFrame || framePos == previousFramePos + hopSize;
+    nextEnd = framePos + hopSize;
+    nextFadeFrom = hasPreviousFrame ? previousFramePos + hopSize : framePos;
+
+    ensureBuffered(framePos + frameSize);
+    auto nextOffset = hopSize - readyOffset;
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* frame = getInput(channel, framePos);
+        auto* overlap = overlapBuffer.getWritePointer(channel);
+        // nothing to fade against yet, so the first frame starts at full level
+        auto start = hasPreviousFrame ? 0 : hopSize;
+        if (!hasPreviousFrame)
+        {
+            juce::FloatVectorOperations::copy(overlap, frame, hopSize);
+        }
+        juce::FloatVectorOperations::addWithMultiply(overlap + start, frame + start,
+                                                     window.data() + start, frameSize - start);
+
+        readyBuffer.copyFrom(channel, nextOffset, overlap, hopSize);
+        juce::FloatVectorOperations::copy(overlap, overlap + hopSize, frameSize - hopSize);
+        juce::FloatVectorOperations::clear(overlap + frameSize - hopSize, hopSize);
+    }
+
+    previousFramePos = framePos;
+    hasPreviousFrame = true;
+    nominalPos += hopSize * stretchFactor;
+    // pass-through may still take over where the hop playing now ends
+    discardBefore(juce::jmin((juce::int64) nominalPos - searchRange, framePos + hopSize, readyEnd));
+    hopStage = HopStage::done;
+}
+
+void TimeStretcher::playNextHop()
+{
+    readyOffset = hopSize - readyOffset;
+    readyPos = 0;
+    numReady = hopSize;
+    readyExact = nextExact;
+    readyEnd = nextEnd;
+    readyFadeFrom = nextFadeFrom;
+    planNextHop();
+}
+
+float TimeStretcher::getCorrelation(juce::int64 reference, juce::int64 candidate, float& energy) const
+{
+    float correlation = 0;
+    energy = 0;
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* candidateSamples = getInput(channel, candidate);
+        correlation += SimdOps::dot(getInput(channel, reference), candidateSamples, hopSize);
+        energy += SimdOps::dot(candidateSamples, candidateSamples, hopSize);
+    }
+    return correlation;
+}
+
+void TimeStretcher::readPassThrough(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    auto numOutChannels = juce::jmin(bufferToFill.buffer->getNumChannels(), numChannels);
+    auto readEnd = bufferStart + numBuffered;
+    int done = 0;
+
+    // play out what stretching read ahead before going back to the source
+    if (passThroughPos < readEnd)
+    {
+        done = (int) juce::jmin(readEnd - passThroughPos, (juce::int64) bufferToFill.numSamples);
+        for (int channel = 0; channel < numOutChannels; ++channel)
+        {
+            bufferToFill.buffer->copyFrom(channel, bufferToFill.startSample,
+                                          getInput(channel, passThroughPos), done);
+        }
+        passThroughPos += done;
+    }
+
+    if (done < bufferToFill.numSamples)
+    {
+        input->getNextAudioBlock(juce::AudioSourceChannelInfo(bufferToFill.buffer,
+                                                              bufferToFill.startSample + done,
+                                                              bufferToFill.numSamples - done));
+        passThroughPos += bufferToFill.numSamples - done;
+        bufferStart = passThroughPos;
+        numBuffered = 0;
+    }
+}
+
+void TimeStretcher::ensureBuffered(juce::int64 endPos)
+{
+    auto numNeeded = (int) (endPos - (bufferStart + numBuffered));
+    if (numNeeded > 0)
+    {
+        jassert(numBuffered + numNeeded <= inputBuffer.getNumSamples());
+        input->getNextAudioBlock(juce::AudioSourceChannelInfo(&inputBuffer, numBuffered, numNeeded));
+        numBuffered += numNeeded;
+    }
+}
+
+void TimeStretcher::discardBefore(juce::int64 startPos)
+{
+    auto readEnd = bufferStart + numBuffered;
+    if (startPos >= readEnd)
+    {
+        // stretching fast can hop clean over some input, which still has to be read
+        for (auto toSkip = startPos - readEnd; toSkip > 0;)
+        {
+            auto numThisTime = (int) juce::jmin(toSkip, (juce::int64) inputBuffer.getNumSamples());
+            input->getNextAudioBlock(juce::AudioSourceChannelInfo(&inputBuffer, 0, numThisTime));
+            toSkip -= numThisTime;
+        }
+        bufferStart = startPos;
+        numBuffered = 0;
+    }
+    else if (startPos > bufferStart)
+    {
+        auto numDropped = (int) (startPos - bufferStart);
+        numBuffered -= numDropped;
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* data = inputBuffer.getWritePointer(channel);
+            std::memmove(data, data + numDropped, (size_t) numBuffered * sizeof(float));
+        }
+        bufferStart = startPos;
+    }
+}
+
+const float* TimeStretcher::getInput(int channel, juce::int64 pos) const
+{
+    return inputBuffer.getReadPointer(channel, (int) (pos - bufferStart));
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    WSOLA time-stretcher for a deck. Changes tempo without changing pitch by
+    overlap-adding Hann-windowed frames of the input, each one nudged within a
+    small search range to line up with the waveform of the frame before.
+
+    The work per hop is fixed (a decimated correlation search plus a short
+    refinement), so the worst-case cost of a block does not depend on the
+    stretch factor. It is also rendered one hop ahead and split into small
+    steps, which are run in step with how much of the hop before has played,
+    so the cost of a block follows its size rather than the hop size. With a
+    factor of 1 audio passes straight through.
+*/
+class TimeStretcher  : public juce::AudioSource
+{
+public:
+    TimeStretcher(juce::AudioSource* inputSource, int numChannels = 2);
+    ~TimeStretcher() override;
+
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+    void releaseResources() override;
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+    /**Audio thread: input samples consumed per output sample, 1 to pass audio through*/
+    void setStretchFactor(double factor);
+    /**Audio thread: forgets buffered audio, e.g. when the track changes*/
+    void flushBuffers();
+    /**Audio thread: false while audio is passing straight through*/
+    bool isStretching() const;
+    /**Audio thread: how many input samples have been read past the one the next output
+    *  sample comes from, i.e. how far the input is ahead of what is heard*/
+    double getLatency() const;
+
+    static constexpr double minFactor = 0.125;
+    static constexpr double maxFactor = 8.0;
+
+private:
+    /**The stages of rendering a hop, each split into steps of roughly equal cost*/
+    enum class HopStage
+    {
+        read,
+        prepareSearch,
+        search,
+        refine,
+        mix,
+        done
+    };
+
+    bool isNeutral() const;
+    void startStretching();
+    /**Works out where the next frame comes from and how many steps rendering it takes*/
+    void planNextHop();
+    /**Runs steps of the next hop until stepsDue of them are done or it is finished*/
+    void workOnNextHop(int stepsDue);
+    /**One step: reads a hop of input, runs part of the search, or overlap-adds the frame*/
+    void doHopStep();
+    /**Coarse pass of the search, on mono audio at half the sample rate*/
+    void prepareSearch();
+    void searchLags();
+    /**Refines the coarse winner at full rate, giving the frame start*/
+    void refineSearch();
+    /**Overlap-adds the frame into the half of readyBuffer not being played*/
+    void mixFrame();
+    /**Starts playing the hop just rendered and plans the one after*/
+    void playNextHop();
+    float getCorrelation(juce::int64 reference, juce::int64 candidate, float& energy) const;
+    void readPassThrough(const juce::AudioSourceChannelInfo& bufferToFill);
+
+    void ensureBuffered(juce::int64 endPos);
+    void discardBefore(juce::int64 startPos);
+    const float* getInput(int channel, juce::int64 pos) const;
+
+    juce::AudioSource* input;
+    int numChannels;
+
+    int frameSize{ 0 };
+    int hopSize{ 0 };
+    int searchRange{ 0 };
+    std::vector<float> window;
+
+    // input kept around the frames being searched, starting at stream position bufferStart
+    juce::AudioBuffer<float> inputBuffer;
+    juce::int64 bufferStart{ 0 };
+    int numBuffered{ 0 };
+
+    juce::AudioBuffer<float> overlapBuffer;
+    // two hops: the one playing, starting at readyOffset, and the next one being rendered
+    juce::AudioBuffer<float> readyBuffer;
+    int readyOffset{ 0 };
+    int readyPos{ 0 };
+    int numReady{ 0 };
+    // whether the playing hop joins the input seamlessly, and where the input carries on after it
+    bool readyExact{ true };
+    juce::int64 readyEnd{ 0 };
+    // where the frame before carried on from, which the playing hop fades out of
+    juce::int64 readyFadeFrom{ 0 };
+
+    // the next hop
+    HopStage hopStage{ HopStage::done };
+    int numHopSteps{ 0 };
+    int numHopStepsDone{ 0 };
+    bool hopSearches{ false };
+    juce::int64 hopFramePos{ 0 };
+    juce::int64 hopTarget{ 0 };
+    juce::int64 hopContinuation{ 0 };
+    juce::int64 hopFirstCandidate{ 0 };
+    juce::int64 hopReadEnd{ 0 };
+    bool nextExact{ false };
+    juce::int64 nextEnd{ 0 };
+    juce::int64 nextFadeFrom{ 0 };
+
+    // decimated mono copies of the audio being correlated, and how far the search has got
+    std::vector<float> searchReference;
+    std::vector<float> searchCandidates;
+    double searchEnergy{ 0 };
+    double bestScore{ 0 };
+    int bestCoarse{ 0 };
+    int searchLag{ 0 };
+    // coarse lags per search step, about as much work as reading or mixing a hop
+    static constexpr int lagsPerStep = 16;
+
+    double stretchFactor{ 1.0 };
+    bool stretching{ false };
+    bool hasPreviousFrame{ false };
+    double nominalPos{ 0 };
+    juce::int64 previousFramePos{ 0 };
+    // next input sample to play when passing through
+    juce::int64 passThroughPos{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TimeStretcher)
+};
@@ -0,0 +1,199 @@
+#include <JuceHeader.h>
+#include "TrackAnalyzer.h"
+#include "BeatDetector.h"
+#include "KeyDetector.h"
+
+//==============================================================================
+TrackAnalyzer::TrackAnalyzer(juce::AudioFormatManager& _formatManager,
+                             int _numThreads
+                            ) : formatManager(_formatManager),
+                                analyzerPool(createPool(_numThreads))
+{
+}
+
+TrackAnalyzer::~TrackAnalyzer()
+{
+    {
+        const juce::ScopedLock sl(lock);
+        isShuttingDown = true;
+    }
+    analyzerPool->removeAllJobs(true, 5000);
+    cancelPendingUpdate();
+}
+
+void TrackAnalyzer::analyzeInBackground(const juce::File& file)
+{
+    const juce::ScopedLock sl(lock);
+    if (!pending.insert(file.getFullPathName()).second)
+    {
+        return;
+    }
+    queued.push_back(file);
+    addJob();
+}
+
+void TrackAnalyzer::prioritize(const juce::File& file)
+{
+    const juce::ScopedLock sl(lock);
+    if (pending.insert(file.getFullPathName()).second)
+    {
+        queued.push_front(file);
+        addJob();
+        return;
+    }
+    auto it = std::find(queued.begin(), queued.end(), file);
+    if (it != queued.end())
+    {
+        // its job is already in the pool, it just gets the next free thread now
+        queued.erase(it);
+        queued.push_front(file);
+    }
+}
+
+int TrackAnalyzer::getNumPending() const
+{
+    const juce::ScopedLock sl(lock);
+    return (int) pending.size();
+}
+
+TrackAnalysis TrackAnalyzer::analyze(const juce::File& file) const
+{
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr)
+    {
+        DBG("TrackAnalyzer::analyze could not open " << file.getFileName());
+        return {};
+    }
+
+    BeatDetector beats(reader->sampleRate);
+    KeyDetector key(reader->sampleRate);
+    auto numChannels = juce::jmax(1, (int) reader->numChannels);
+    auto length = juce::jmin(reader->lengthInSamples,
+                             (juce::int64) (BeatDetector::maxAnalysisSecs * reader->sampleRate));
+    juce::AudioBuffer<float> block(numChannels, decodeBlockSize);
+
+    for (juce::int64 pos = 0; pos < length; pos += decodeBlockSize)
+    {
+        auto* job = juce::ThreadPoolJob::getCurrentThreadPoolJob();
+        if (job != nullptr && job->shouldExit())
+        {
+            return {};
+        }
+        auto numSamples = (int) juce::jmin((juce::int64) decodeBlockSize, length - pos);
+        reader->read(&block, 0, numSamples, pos, true, true);
+
+        // the detectors only need mono, and one decode feeds them all
+        for (int channel = 1; channel < numChannels; ++channel)
+        {
+            block.addFrom(0, 0, block, channel, 0, numSamples);
+        }
+        block.applyGain(0, 0, numSamples, 1.0f / numChannels);
+        beats.process(block.getReadPointer(0), numSamples);
+        key.process(block.getReadPointer(0), numSamples);
+    }
+
+    TrackAnalysis analysis;
+    analysis.beatGrid = beats.getBeatGrid();
+    analysis.key = key.getKey();
+    return analysis;
+}
+
+void TrackAnalyzer::setNumThreads(int numThreads)
+{
+    numThreads = juce::jmax(1, numThreads);
+    if (numThreads == getNumThreads())
+    {
+        return;
+    }
+
+    std::unique_ptr<juce::ThreadPool> oldPool;
+    {
+        const juce::ScopedLock sl(lock);
+        oldPool = std::move(analyzerPool);
+        analyzerPool = createPool(numThreads);
+        // a job for every queued track; any the old pool still starts leave a spare, which finds nothing
+        for (size_t i = 0; i < queued.size(); ++i)
+        {
+            addJob();
+        }
+    }
+    oldPool->removeAllJobs(true, 5000);
+}
+
+int TrackAnalyzer::getNumThreads() const
+{
+    const juce::ScopedLock sl(lock);
+    return analyzerPool->getNumThreads();
+}
+
+int TrackAnalyzer::getDefaultNumThreads()
+{
+    return juce::jmax(1, juce::SystemStats::getNumCpus() - 1);
+}
+
+void TrackAnalyzer::analyzeNext()
+{
+    juce::File file;
+    {
+        const juce::ScopedLock sl(lock);
+        if (queued.empty())
+        {
+            return;
+        }
+        file = queued.front();
+        queued.pop_front();
+        running.add(file);
+    }
+
+    auto analysis = analyze(file);
+
+    auto* job = juce::ThreadPoolJob::getCurrentThreadPoolJob();
+    const juce::ScopedLock sl(lock);
+    running.removeFirstMatchingValue(file);
+    if (job != nullptr && job->shouldExit())
+    {
+        // cut short by a change of pool, so it is started again on the new one
+        if (!isShuttingDown)
+        {
+            queued.push_front(file);
+            addJob();
+        }
+        else
+        {
+            pending.erase(file.getFullPathName());
+        }
+        return;
+    }
+    pending.erase(file.getFullPathName());
+    results.add({ file, analysis });
+    triggerAsyncUpdate();
+}
+
+void TrackAnalyzer::addJob()
+{
+    analyzerPool->addJob([this] { analyzeNext(); });
+}
+
+std::unique_ptr<juce::ThreadPool> TrackAnalyzer::createPool(int numThreads)
+{
+    auto pool = std::make_unique<juce::ThreadPool>(juce::jmax(1, numThreads));
+    // analysis is never urgent, the decks' threads come first
+    pool->setThreadPriorities(2);
+    return pool;
+}
+
+void TrackAnalyzer::handleAsyncUpdate()
+{
+    juce::Array<std::pair<juce::File, TrackAnalysis>> finished;
+    {
+        const juce::ScopedLock sl(lock);
+        finished.swapWith(results);
+    }
+    for (const auto& result : finished)
+    {
+        if (onTrackAnalyzed)
+        {
+            onTrackAnalyzed(result.first, result.second);
+        }
+    }
+}
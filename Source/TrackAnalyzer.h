@@ -0,0 +1,82 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <deque>
+#include <set>
+#include "BeatGrid.h"
+#include "MusicalKey.h"
+
+//==============================================================================
+/*
+    What analyzing a track found out about it.
+*/
+struct TrackAnalysis
+{
+    BeatGrid beatGrid;
+    MusicalKey key;
+};
+
+//==============================================================================
+/*
+    Analyzes tracks on a pool of low priority background threads, one track
+    per thread at a time, so a big import uses the spare cores without
+    taking time from the audio. How many cores it gets can be changed while
+    it runs.
+
+    Tracks are decoded a block at a time straight into the detectors, which
+    keep only their own small summaries, so memory stays bounded by the
+    number of threads rather than the length or number of tracks. The queue
+    is first come first served, except that a track a deck is loading jumps
+    to the front.
+*/
+class TrackAnalyzer  : private juce::AsyncUpdater
+{
+public:
+    TrackAnalyzer(juce::AudioFormatManager& _formatManager, int _numThreads);
+    ~TrackAnalyzer() override;
+
+    /**Any thread: queues a track behind the others, unless it is queued or being analyzed already*/
+    void analyzeInBackground(const juce::File& file);
+    /**Any thread: moves a track to the front of the queue, queueing it first if needed*/
+    void prioritize(const juce::File& file);
+    /**Tracks queued or being analyzed*/
+    int getNumPending() const;
+    /**Decodes and analyzes a track on the calling thread. Stops early, with an invalid
+    *  result, if called from a thread pool job that is asked to exit*/
+    TrackAnalysis analyze(const juce::File& file) const;
+    /**Message thread: analyzes this many tracks at once from now on. Analyses cut short
+    *  by the change go back to the front of the queue*/
+    void setNumThreads(int numThreads);
+    int getNumThreads() const;
+    /**Every core but the one the audio runs on*/
+    static int getDefaultNumThreads();
+
+    /**Message thread: called with each result as it comes in*/
+    std::function<void(const juce::File& file, const TrackAnalysis& analysis)> onTrackAnalyzed;
+
+private:
+    void handleAsyncUpdate() override;
+    /**Pool thread: takes the track at the front of the queue, whichever job was added for it*/
+    void analyzeNext();
+    /**Called with the lock held: a job for the next track in the queue*/
+    void addJob();
+    static std::unique_ptr<juce::ThreadPool> createPool(int numThreads);
+
+    static constexpr int decodeBlockSize = 65536;
+
+    juce::AudioFormatManager& formatManager;
+
+    juce::CriticalSection lock;
+    // front first; each has at least one pool job waiting for it
+    std::deque<juce::File> queued;
+    juce::Array<juce::File> running;
+    // the paths queued or running, so a library of thousands is queued without a search per track
+    std::set<juce::String> pending;
+    juce::Array<std::pair<juce::File, TrackAnalysis>> results;
+    bool isShuttingDown{ false };
+
+    // declared last so analyses stop before anything they use is destroyed
+    std::unique_ptr<juce::ThreadPool> analyzerPool;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TrackAnalyzer)
+};
@@ -0,0 +1,734 @@
+#include <JuceHeader.h>
+#include "TrackLibrary.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+    const int journalMagic = 0x4a4f544f; // "OTOJ"
+    const int journalVersion = 3;
+    // the same but without analysis stamps; replayed, then folded into a new snapshot
+    const int previousJournalVersion = 2;
+
+    enum JournalEdit
+    {
+        putTrack = 1,
+        removeTrack = 2
+    };
+
+    void writeTrack(juce::OutputStream& out, const TrackRecord& record)
+    {
+        out.writeInt((int) record.id);
+        out.writeString(record.path);
+        out.writeInt(record.lengthMs);
+        out.writeDouble(record.beatGrid.bpm);
+        out.writeDouble(record.beatGrid.firstBeatSecs);
+        for (auto position : record.hotCues.positions)
+        {
+            out.writeDouble(position);
+        }
+        out.writeByte((char) record.key.toIndex());
+        out.writeInt64(record.fileSize);
+        out.writeInt64(record.modificationTime);
+        out.writeInt64(record.analysisStamp);
+    }
+
+    TrackRecord readTrack(juce::InputStream& in, int version)
+    {
+        TrackRecord record;
+        record.id = (TrackId) in.readInt();
+        record.path = in.readString();
+        record.lengthMs = in.readInt();
+        record.beatGrid.bpm = in.readDouble();
+        record.beatGrid.firstBeatSecs = in.readDouble();
+        for (auto& position : record.hotCues.positions)
+        {
+            position = in.readDouble();
+        }
+        record.key = MusicalKey::fromIndex(in.readByte());
+        record.fileSize = in.readInt64();
+        record.modificationTime = in.readInt64();
+        if (version != previousJournalVersion)
+        {
+            record.analysisStamp = in.readInt64();
+        }
+        return record;
+    }
+
+    juce::String getRecordTitle(const TrackRecord& record)
+    {
+        return juce::File(record.path).getFileNameWithoutExtension();
+    }
+}
+
+//==============================================================================
+TrackLibrary::TrackLibrary()
+{
+}
+
+TrackLibrary::~TrackLibrary()
+{
+    commit();
+}
+
+int TrackLibrary::size() const
+{
+    return (int) idByIndex.size();
+}
+
+Song TrackLibrary::getTrack(int index) const
+{
+    auto id = idByIndex[(size_t) index];
+    auto cached = cachedRowById.find(id);
+    if (cached != cachedRowById.end())
+    {
+        cachedRows.splice(cachedRows.begin(), cachedRows, cached->second);
+        return cached->second->second;
+    }
+
+    auto* record = findEdited(id);
+    cachedRows.emplace_front(id, record != nullptr ? record->toSong()
+                                                   : snapshot.readRecord(rowByIndex[(size_t) index]).toSong());
+    cachedRowById[id] = cachedRows.begin();
+    if ((int) cachedRows.size() > maxCachedRows)
+    {
+        cachedRowById.erase(cachedRows.back().first);
+        cachedRows.pop_back();
+    }
+    return cachedRows.front().second;
+}
+
+TrackId TrackLibrary::getId(int index) const
+{
+    return idByIndex[(size_t) index];
+}
+
+juce::String TrackLibrary::getTitle(int index) const
+{
+    auto* record = findEdited(idByIndex[(size_t) index]);
+    return record != nullptr ? getRecordTitle(*record) : snapshot.getTitle(rowByIndex[(size_t) index]);
+}
+
+juce::File TrackLibrary::getFile(int index) const
+{
+    auto* record = findEdited(idByIndex[(size_t) index]);
+    return juce::File(record != nullptr ? record->path : snapshot.getPath(rowByIndex[(size_t) index]));
+}
+
+int TrackLibrary::getLengthMs(int index) const
+{
+    auto* record = findEdited(idByIndex[(size_t) index]);
+    return record != nullptr ? record->lengthMs : snapshot.getLengthMs(rowByIndex[(size_t) index]);
+}
+
+BeatGrid TrackLibrary::getBeatGrid(int index) const
+{
+    auto* record = findEdited(idByIndex[(size_t) index]);
+    return record != nullptr ? record->beatGrid : snapshot.getBeatGrid(rowByIndex[(size_t) index]);
+}
+
+MusicalKey TrackLibrary::getKey(int index) const
+{
+    auto* record = findEdited(idByIndex[(size_t) index]);
+    return record != nullptr ? record->key : snapshot.getKey(rowByIndex[(size_t) index]);
+}
+
+juce::int64 TrackLibrary::getFileSize(int index) const
+{
+    auto* record = findEdited(idByIndex[(size_t) index]);
+    return record != nullptr ? record->fileSize : snapshot.getFileSize(rowByIndex[(size_t) index]);
+}
+
+juce::int64 TrackLibrary::getModificationTime(int index) const
+{
+    auto* record = findEdited(idByIndex[(size_t) index]);
+    return record != nullptr ? record->modificationTime : snapshot.getModificationTime(rowByIndex[(size_t) index]);
+}
+
+juce::int64 TrackLibrary::getAnalysisStamp(int index) const
+{
+    auto* record = findEdited(idByIndex[(size_t) index]);
+    return record != nullptr ? record->analysisStamp : snapshot.getAnalysisStamp(rowByIndex[(size_t) index]);
+}
+
+// compare the names inside the playlist and return true when theres a exact copy to ensure theres no replicates
+bool TrackLibrary::contains(const juce::String& title) const
+{
+    for (auto row : snapshot.findTitle(title))
+    {
+        if (indexOf(snapshot.getId(row)) >= 0)
+        {
+            return true;
+        }
+    }
+    return numAddedByTitle.count(title) > 0;
+}
+
+void TrackLibrary::add(const Song& song)
+{
+    auto record = TrackRecord::fromSong(song);
+    record.id = nextTrackId;
+    addTrack(record);
+    journalTrack(record.id);
+}
+
+void TrackLibrary::remove(int index)
+{
+    auto id = idByIndex[(size_t) index];
+    journalRemoval(id);
+    forgetTrack(id);
+    dropRemoved();
+}
+
+void TrackLibrary::removeIf(const std::function<bool(int index)>& shouldRemove)
+{
+    // every index is asked about before any track moves
+    std::vector<TrackId> removed;
+    for (int i = 0; i < size(); ++i)
+    {
+        if (shouldRemove(i))
+        {
+            removed.push_back(idByIndex[(size_t) i]);
+        }
+    }
+    for (auto id : removed)
+    {
+        journalRemoval(id);
+        forgetTrack(id);
+    }
+    dropRemoved();
+}
+
+// finds index where track title contains searchText
+// it is case insensitive
+int TrackLibrary::find(const juce::String& searchText) const
+{
+    for (int i = 0; i < size(); ++i)
+    {
+        if (getTitle(i).containsIgnoreCase(searchText))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int TrackLibrary::indexOf(const juce::File& file) const
+{
+    return indexOf(findId(file.getFullPathName()));
+}
+
+int TrackLibrary::indexOf(TrackId id) const
+{
+    return id < indexById.size() ? indexById[id] : -1;
+}
+
+juce::Array<int> TrackLibrary::findTempo(double minBpm, double maxBpm) const
+{
+    std::vector<std::pair<double, int>> found;
+    // an edited track's tempo in the snapshot may be out of date, so those come from memory
+    for (auto row : snapshot.findTempo(minBpm, maxBpm))
+    {
+        auto id = snapshot.getId(row);
+        if (indexOf(id) >= 0 && findEdited(id) == nullptr)
+        {
+            found.push_back({ snapshot.getBeatGrid(row).bpm, indexOf(id) });
+        }
+    }
+    for (const auto& entry : edited)
+    {
+        const auto& grid = entry.second.beatGrid;
+        if (grid.isValid() && grid.bpm >= minBpm && grid.bpm <= maxBpm)
+        {
+            found.push_back({ grid.bpm, indexOf(entry.first) });
+        }
+    }
+    std::sort(found.begin(), found.end());
+
+    juce::Array<int> indexes;
+    for (const auto& entry : found)
+    {
+        indexes.add(entry.second);
+    }
+    return indexes;
+}
+
+juce::Array<int> TrackLibrary::findKey(const MusicalKey& key) const
+{
+    juce::Array<int> found;
+    for (auto row : snapshot.findKey(key))
+    {
+        auto id = snapshot.getId(row);
+        if (indexOf(id) >= 0 && findEdited(id) == nullptr)
+        {
+            found.add(indexOf(id));
+        }
+    }
+    for (const auto& entry : edited)
+    {
+        if (entry.second.key.isValid() && entry.second.key.toIndex() == key.toIndex())
+        {
+            found.add(indexOf(entry.first));
+        }
+    }
+    found.sort();
+    return found;
+}
+
+void TrackLibrary::setHotCues(int index, const HotCues& cues)
+{
+    editTrack(index).hotCues = cues;
+    journalTrack(idByIndex[(size_t) index]);
+}
+
+void TrackLibrary::setBeatGrid(int index, const BeatGrid& grid)
+{
+    editTrack(index).beatGrid = grid;
+    journalTrack(idByIndex[(size_t) index]);
+}
+
+void TrackLibrary::setKey(int index, const MusicalKey& key)
+{
+    editTrack(index).key = key;
+    journalTrack(idByIndex[(size_t) index]);
+}
+
+void TrackLibrary::setLength(int index, int lengthMs)
+{
+    editTrack(index).lengthMs = lengthMs;
+    journalTrack(idByIndex[(size_t) index]);
+}
+
+void TrackLibrary::setFileStamp(int index, juce::int64 fileSize, juce::int64 modificationTime)
+{
+    auto& record = editTrack(index);
+    record.fileSize = fileSize;
+    record.modificationTime = modificationTime;
+    journalTrack(idByIndex[(size_t) index]);
+}
+
+void TrackLibrary::setAnalysisStamp(int index, juce::int64 modificationTime)
+{
+    editTrack(index).analysisStamp = modificationTime;
+    journalTrack(idByIndex[(size_t) index]);
+}
+
+bool TrackLibrary::open(const juce::File& _storeFile)
+{
+    journal.reset();
+    uncommitted.reset();
+    snapshot.close();
+    storeFile = _storeFile;
+    unreadableStore = juce::File();
+    resetRows();
+
+    if (!storeFile.existsAsFile())
+    {
+        // a new store starts as an empty snapshot
+        return compact();
+    }
+    if (!snapshot.open(storeFile))
+    {
+        DBG("TrackLibrary::open " << storeFile.getFullPathName() << " is damaged");
+        snapshot.close();
+        // kept for whoever can recover it, out of the way of the empty store started in its place
+        unreadableStore = storeFile.getSiblingFile(storeFile.getFileName() + ".unreadable").getNonexistentSibling(false);
+        if (!storeFile.moveFileTo(unreadableStore))
+        {
+            DBG("TrackLibrary::open could not move " << storeFile.getFileName() << " aside");
+            unreadableStore = juce::File();
+            storeFile = juce::File();
+            return false;
+        }
+        getJournalFile().moveFileTo(getJournalFile(unreadableStore));
+        return compact();
+    }
+    resetRows();
+
+    auto journalEnd = replayJournal();
+    // a store of the previous version is read as it is, then rewritten in this one
+    if (!snapshot.isCurrentFormat())
+    {
+        return compact();
+    }
+    if (journalEnd == 0)
+    {
+        return startJournal();
+    }
+    journal = std::make_unique<juce::FileOutputStream>(getJournalFile());
+    if (journal->failedToOpen())
+    {
+        DBG("TrackLibrary::open could not open the journal of " << storeFile.getFileName());
+        journal.reset();
+        return false;
+    }
+    // a frame cut short by a crash is dropped, so the next one isn't written after it
+    if (journal->getPosition() != journalEnd)
+    {
+        journal->setPosition(journalEnd);
+        journal->truncate();
+    }
+    return true;
+}
+
+juce::File TrackLibrary::getUnreadableStore() const
+{
+    return unreadableStore;
+}
+
+bool TrackLibrary::commit()
+{
+    if (journal == nullptr || uncommitted.getDataSize() == 0)
+    {
+        return true;
+    }
+
+    // one frame per commit, so a crash part way through loses the whole commit, never half of it
+    auto frameStart = journal->getPosition();
+    journal->writeInt((int) uncommitted.getDataSize());
+    journal->writeInt((int) LibrarySnapshot::checksum(uncommitted.getData(), uncommitted.getDataSize()));
+    journal->write(uncommitted.getData(), uncommitted.getDataSize());
+    journal->flush();
+    if (journal->getStatus().failed())
+    {
+        DBG("TrackLibrary::commit could not write the journal: " << journal->getStatus().getErrorMessage());
+        journal->setPosition(frameStart);
+        journal->truncate();
+        return false;
+    }
+    uncommitted.reset();
+    return true;
+}
+
+bool TrackLibrary::compact()
+{
+    if (storeFile == juce::File())
+    {
+        return false;
+    }
+
+    auto contents = LibrarySnapshot::build(snapshot.getGeneration() + 1, nextTrackId, size(), [this](int index)
+    {
+        auto* record = findEdited(idByIndex[(size_t) index]);
+        return record != nullptr ? *record : snapshot.readRecord(rowByIndex[(size_t) index]);
+    });
+    // a file that is mapped can't be replaced on every platform, and the rows are all in contents now
+    snapshot.close();
+
+    // written beside the store and moved into place whole, so the old one stays until the new one is complete
+    juce::TemporaryFile temp(storeFile);
+    bool isWritten;
+    {
+        juce::FileOutputStream out(temp.getFile());
+        isWritten = !out.failedToOpen() && out.write(contents.getData(), contents.getSize());
+    }
+    if (!isWritten || !temp.overwriteTargetFileWithTemporary())
+    {
+        DBG("TrackLibrary::compact could not replace " << storeFile.getFullPathName());
+        snapshot.open(storeFile);
+        return false;
+    }
+    if (!snapshot.open(storeFile))
+    {
+        DBG("TrackLibrary::compact could not map " << storeFile.getFullPathName());
+        return false;
+    }
+
+    // the old journal names the old generation, so a crash from here on can't replay it twice
+    resetRows();
+    uncommitted.reset();
+    return startJournal();
+}
+
+bool TrackLibrary::shouldCompact() const
+{
+    return journal != nullptr
+        && (journal->getPosition() > juce::jmax((juce::int64) 65536, storeFile.getSize())
+            || (int) edited.size() > maxEditedTracks);
+}
+
+void TrackLibrary::save(const juce::File& file) const
+{
+    std::ofstream my_Library(file.getFullPathName().toStdString());
+
+    for (int i = 0; i < size(); ++i)
+    {
+        auto t = getTrack(i);
+        auto seconds = (t.lengthMs + 500) / 1000;
+        my_Library << t.file.getFullPathName() << "," << seconds / 60 << ":" << juce::String(seconds % 60).paddedLeft('0', 2)
+                   << "," << t.beatGrid.bpm << "," << t.beatGrid.firstBeatSecs
+                   << "," << t.hotCues.toString() << "," << t.key.toIndex()
+                   << "," << t.fileSize << "," << t.modificationTime << "\n";
+    }
+}
+
+void TrackLibrary::load(const juce::File& file)
+{
+    std::ifstream my_Library(file.getFullPathName().toStdString());
+    std::string line;
+
+    // Read data, line by line
+    if (my_Library.is_open())
+    {
+        // add each songs found in the .csv to the library
+        while (getline(my_Library, line)) {
+            std::istringstream fields(line);
+            std::string filePath, length, bpm, firstBeat, hotCues, key, fileSize, modificationTime;
+            getline(fields, filePath, ',');
+            getline(fields, length, ',');
+            // libraries saved before cues and grids have only the first two
+            getline(fields, bpm, ',');
+            getline(fields, firstBeat, ',');
+            getline(fields, hotCues, ',');
+            getline(fields, key, ',');
+            getline(fields, fileSize, ',');
+            getline(fields, modificationTime);
+
+            juce::File songFile{ filePath };
+            Song newSong{ songFile };
+            auto minutesAndSeconds = juce::String(length);
+            newSong.lengthMs = (minutesAndSeconds.upToFirstOccurrenceOf(":", false, false).getIntValue() * 60
+                                + minutesAndSeconds.fromFirstOccurrenceOf(":", false, false).getIntValue()) * 1000;
+            newSong.beatGrid.bpm = juce::String(bpm).getDoubleValue();
+            newSong.beatGrid.firstBeatSecs = juce::String(firstBeat).getDoubleValue();
+            newSong.hotCues = HotCues::fromString(hotCues);
+            // and those saved before keys end at the cues
+            newSong.key = key.empty() ? MusicalKey() : MusicalKey::fromIndex(juce::String(key).getIntValue());
+            newSong.fileSize = juce::String(fileSize).getLargeIntValue();
+            newSong.modificationTime = juce::String(modificationTime).getLargeIntValue();
+            add(newSong);
+        }
+    }
+    my_Library.close();
+}
+
+TrackId TrackLibrary::findId(const juce::String& path) const
+{
+    auto row = snapshot.findPath(path);
+    if (row >= 0 && indexOf(snapshot.getId(row)) >= 0)
+    {
+        return snapshot.getId(row);
+    }
+    auto added = addedIdByPath.find(path);
+    return added != addedIdByPath.end() ? added->second : 0;
+}
+
+const TrackRecord* TrackLibrary::findEdited(TrackId id) const
+{
+    auto record = edited.find(id);
+    return record != edited.end() ? &record->second : nullptr;
+}
+
+TrackRecord& TrackLibrary::editTrack(int index)
+{
+    auto id = idByIndex[(size_t) index];
+    auto record = edited.find(id);
+    if (record == edited.end())
+    {
+        record = edited.emplace(id, snapshot.readRecord(rowByIndex[(size_t) index])).first;
+    }
+    uncacheTrack(id);
+    return record->second;
+}
+
+void TrackLibrary::addTrack(const TrackRecord& record)
+{
+    nextTrackId = juce::jmax(nextTrackId, record.id + 1);
+    indexById.resize(nextTrackId, -1);
+    indexById[record.id] = size();
+    idByIndex.push_back(record.id);
+    rowByIndex.push_back(-1);
+    edited[record.id] = record;
+    addedIdByPath[record.path] = record.id;
+    ++numAddedByTitle[getRecordTitle(record)];
+}
+
+void TrackLibrary::forgetTrack(TrackId id)
+{
+    auto record = edited.find(id);
+    if (record != edited.end())
+    {
+        if (rowByIndex[(size_t) indexById[id]] < 0)
+        {
+            addedIdByPath.erase(record->second.path);
+            auto title = numAddedByTitle.find(getRecordTitle(record->second));
+            if (title != numAddedByTitle.end() && --title->second == 0)
+            {
+                numAddedByTitle.erase(title);
+            }
+        }
+        edited.erase(record);
+    }
+    uncacheTrack(id);
+    indexById[id] = -1;
+}
+
+void TrackLibrary::dropRemoved()
+{
+    size_t numKept = 0;
+    for (size_t i = 0; i < idByIndex.size(); ++i)
+    {
+        auto id = idByIndex[i];
+        if (indexById[id] >= 0)
+        {
+            idByIndex[numKept] = id;
+            rowByIndex[numKept] = rowByIndex[i];
+            indexById[id] = (int) numKept;
+            ++numKept;
+        }
+    }
+    idByIndex.resize(numKept);
+    rowByIndex.resize(numKept);
+}
+
+void TrackLibrary::uncacheTrack(TrackId id)
+{
+    auto cached = cachedRowById.find(id);
+    if (cached != cachedRowById.end())
+    {
+        cachedRows.erase(cached->second);
+        cachedRowById.erase(cached);
+    }
+}
+
+void TrackLibrary::resetRows()
+{
+    auto numRows = snapshot.getNumRows();
+    nextTrackId = snapshot.getNextTrackId();
+    idByIndex.resize((size_t) numRows);
+    rowByIndex.resize((size_t) numRows);
+    indexById.assign(nextTrackId, -1);
+    for (int i = 0; i < numRows; ++i)
+    {
+        auto id = snapshot.getId(i);
+        idByIndex[(size_t) i] = id;
+        rowByIndex[(size_t) i] = i;
+        if (id < nextTrackId)
+        {
+            indexById[id] = i;
+        }
+    }
+    edited.clear();
+    addedIdByPath.clear();
+    numAddedByTitle.clear();
+    cachedRows.clear();
+    cachedRowById.clear();
+}
+
+void TrackLibrary::journalTrack(TrackId id)
+{
+    if (journal != nullptr)
+    {
+        uncommitted.writeByte((char) putTrack);
+        writeTrack(uncommitted, edited.at(id));
+    }
+}
+
+void TrackLibrary::journalRemoval(TrackId id)
+{
+    if (journal != nullptr)
+    {
+        uncommitted.writeByte((char) removeTrack);
+        uncommitted.writeInt((int) id);
+    }
+}
+
+juce::int64 TrackLibrary::replayJournal()
+{
+    juce::MemoryBlock data;
+    if (!getJournalFile().loadFileAsData(data) || data.getSize() < 16)
+    {
+        return 0;
+    }
+    juce::MemoryInputStream in(data, false);
+    if (in.readInt() != journalMagic)
+    {
+        return 0;
+    }
+    auto version = in.readInt();
+    if ((version != journalVersion && version != previousJournalVersion)
+        || in.readInt64() != snapshot.getGeneration())
+    {
+        return 0;
+    }
+
+    // removals only mark their track, so replaying thousands of them doesn't shift the rest each time
+    auto frameEnd = in.getPosition();
+    while (in.getNumBytesRemaining() >= 8)
+    {
+        auto frameSize = in.readInt();
+        auto frameChecksum = (juce::uint32) in.readInt();
+        auto* frame = static_cast<const char*>(data.getData()) + in.getPosition();
+        if (frameSize <= 0 || frameSize > in.getNumBytesRemaining()
+            || LibrarySnapshot::checksum(frame, (size_t) frameSize) != frameChecksum)
+        {
+            DBG("TrackLibrary::replayJournal dropped an incomplete commit");
+            break;
+        }
+
+        juce::MemoryInputStream edits(frame, (size_t) frameSize, false);
+        while (!edits.isExhausted())
+        {
+            auto edit = edits.readByte();
+            if (edit == putTrack)
+            {
+                // ids are never given out twice, so a put is either an edit or the add that gave out its id
+                auto record = readTrack(edits, version);
+                if (indexOf(record.id) >= 0)
+                {
+                    edited[record.id] = record;
+                }
+                else if (record.id >= nextTrackId)
+                {
+                    addTrack(record);
+                }
+            }
+            else if (edit == removeTrack)
+            {
+                auto id = (TrackId) edits.readInt();
+                if (indexOf(id) >= 0)
+                {
+                    forgetTrack(id);
+                }
+            }
+        }
+        in.skipNextBytes(frameSize);
+        frameEnd = in.getPosition();
+    }
+    dropRemoved();
+    return frameEnd;
+}
+
+bool TrackLibrary::startJournal()
+{
+    journal.reset();
+    auto journalFile = getJournalFile();
+    if (!journalFile.deleteFile())
+    {
+        DBG("TrackLibrary::startJournal could not delete " << journalFile.getFullPathName());
+        return false;
+    }
+    journal = std::make_unique<juce::FileOutputStream>(journalFile);
+    if (journal->failedToOpen())
+    {
+        DBG("TrackLibrary::startJournal could not create " << journalFile.getFullPathName());
+        journal.reset();
+        return false;
+    }
+    journal->writeInt(journalMagic);
+    journal->writeInt(journalVersion);
+    journal->writeInt64(snapshot.getGeneration());
+    journal->flush();
+    return true;
+}
+
+juce::File TrackLibrary::getJournalFile() const
+{
+    return getJournalFile(storeFile);
+}
+
+juce::File TrackLibrary::getJournalFile(const juce::File& store)
+{
+    return store.getSiblingFile(store.getFileName() + ".journal");
+}
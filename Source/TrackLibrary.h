@@ -0,0 +1,156 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <list>
+#include <map>
+#include <vector>
+#include "LibrarySnapshot.h"
+
+//==============================================================================
+/*
+    The tracks in the library and the operations on them, without any GUI, so
+    the playlist and the benchmarks share one implementation.
+
+    Once opened on a store file, the library persists itself. The store is a
+    binary snapshot of every track plus an append-only journal of the edits
+    made since. Every edit writes the whole record of the track it changed,
+    or a removal, so an edit costs the same however big the library is.
+    commit appends the edits made since the last commit to the journal as a
+    single checksummed frame and flushes it to disk, so a crash loses at
+    most the edits not yet committed and never leaves half a commit behind.
+    Opening replays the journal over the snapshot and stops at the first
+    frame that is cut short or fails its checksum. compact folds the journal
+    into a new snapshot that replaces the old one whole. A store written by
+    the previous version is read and then compacted into the current one;
+    one that can't be read at all is moved aside and a new one started.
+
+    The snapshot is memory-mapped rather than read, so opening a library of
+    any size only reads the snapshot's header and replays the journal. The
+    tracks edited or added since the snapshot are kept in memory over it,
+    and a track's Song is only built when it is asked for, the last few
+    hundred of them being cached for the rows on screen. Besides the path,
+    tracks are indexed by title, tempo and key, in the snapshot for its rows
+    and in memory for the rest.
+
+    Each track has an id that stays the same however the tracks before it
+    are removed, so something that has to find a track again later can keep
+    its id rather than its index, which shifts.
+*/
+class TrackLibrary
+{
+public:
+    TrackLibrary();
+    ~TrackLibrary();
+
+    int size() const;
+    /**Builds the track's Song, or takes it from the cache of those recently built*/
+    Song getTrack(int index) const;
+    /**A single field, read without building the Song*/
+    TrackId getId(int index) const;
+    juce::String getTitle(int index) const;
+    juce::File getFile(int index) const;
+    int getLengthMs(int index) const;
+    BeatGrid getBeatGrid(int index) const;
+    MusicalKey getKey(int index) const;
+    juce::int64 getFileSize(int index) const;
+    juce::int64 getModificationTime(int index) const;
+    /**The modification time the file had when it was last analyzed, 0 if it never was*/
+    juce::int64 getAnalysisStamp(int index) const;
+    /**true if a track with exactly this title is in the library*/
+    bool contains(const juce::String& title) const;
+    void add(const Song& song);
+    void remove(int index);
+    /**Removes every track whose index the predicate is true for, in one pass*/
+    void removeIf(const std::function<bool(int index)>& shouldRemove);
+    /**Index of the first track whose title contains searchText, ignoring case, or -1*/
+    int find(const juce::String& searchText) const;
+    /**Index of the track playing from this file, or -1. Looked up by path, not searched for*/
+    int indexOf(const juce::File& file) const;
+    /**Index of the track with this id, or -1 if it has been removed*/
+    int indexOf(TrackId id) const;
+    /**Indexes of the tracks with a tempo in the range, slowest first*/
+    juce::Array<int> findTempo(double minBpm, double maxBpm) const;
+    /**Indexes of the tracks in a key*/
+    juce::Array<int> findKey(const MusicalKey& key) const;
+    void setHotCues(int index, const HotCues& cues);
+    void setBeatGrid(int index, const BeatGrid& grid);
+    void setKey(int index, const MusicalKey& key);
+    void setLength(int index, int lengthMs);
+    /**Records the size and modification time the file was read at*/
+    void setFileStamp(int index, juce::int64 fileSize, juce::int64 modificationTime);
+    /**Records that the file was analyzed as it was at this modification time, whatever was found*/
+    void setAnalysisStamp(int index, juce::int64 modificationTime);
+
+    /**Replaces the tracks with those in a store, creating it if it doesn't exist, and journals
+    *  every edit to it from then on. The journal sits beside the store file. A store that can't
+    *  be read is renamed to end in .unreadable, with its journal, and an empty one started*/
+    bool open(const juce::File& storeFile);
+    /**Where the last open moved a store it couldn't read, or File() if it didn't*/
+    juce::File getUnreadableStore() const;
+    /**Writes the edits since the last commit to the journal, all of them or none*/
+    bool commit();
+    /**Writes every track to a new snapshot and starts an empty journal*/
+    bool compact();
+    /**true once the journal has grown bigger than the snapshot it applies to,
+    *  or too many tracks are kept in memory over it*/
+    bool shouldCompact() const;
+
+    /**Writes one "path,length,bpm,first beat,hot cues,key,size,modification time" line per track,
+    *  the text format the library was kept in before the store*/
+    void save(const juce::File& file) const;
+    /**Adds the tracks listed in a file written by save, including older "path,length" ones*/
+    void load(const juce::File& file);
+
+private:
+    /**The id of the track with this path, or 0*/
+    TrackId findId(const juce::String& path) const;
+    /**The in-memory copy of a track, or nullptr if it is only in the snapshot*/
+    const TrackRecord* findEdited(TrackId id) const;
+    /**Copies a track into memory, if it isn't already, to be edited there*/
+    TrackRecord& editTrack(int index);
+    void addTrack(const TrackRecord& record);
+    /**Takes a track out of memory and marks it removed; dropRemoved then closes the gaps*/
+    void forgetTrack(TrackId id);
+    void dropRemoved();
+    /**Drops the Song built for a track, once the track has changed*/
+    void uncacheTrack(TrackId id);
+    /**Every snapshot row in its order, with nothing in memory over them*/
+    void resetRows();
+    /**Records an edit to be written by the next commit, if a store is open*/
+    void journalTrack(TrackId id);
+    void journalRemoval(TrackId id);
+    /**Applies the journal's complete frames, returning where the last one ends, or 0 if the
+    *  journal is missing or belongs to an older snapshot*/
+    juce::int64 replayJournal();
+    /**Replaces the journal with an empty one for the current snapshot*/
+    bool startJournal();
+    juce::File getJournalFile() const;
+    static juce::File getJournalFile(const juce::File& store);
+
+    static constexpr int maxCachedRows = 256;
+    static constexpr int maxEditedTracks = 4096;
+
+    LibrarySnapshot snapshot;
+    // by index, the track's id and its snapshot row, -1 if it was added since
+    std::vector<TrackId> idByIndex;
+    std::vector<int> rowByIndex;
+    // by id, -1 for one that was removed or never given out
+    std::vector<int> indexById;
+    TrackId nextTrackId{ 1 };
+    // the tracks added or edited since the snapshot
+    std::map<TrackId, TrackRecord> edited;
+    // the added ones aren't in the snapshot's path and title indexes
+    std::map<juce::String, TrackId> addedIdByPath;
+    std::map<juce::String, int> numAddedByTitle;
+
+    // the Songs built most recently, the latest at the front
+    mutable std::list<std::pair<TrackId, Song>> cachedRows;
+    mutable std::map<TrackId, std::list<std::pair<TrackId, Song>>::iterator> cachedRowById;
+
+    juce::File storeFile;
+    juce::File unreadableStore;
+    std::unique_ptr<juce::FileOutputStream> journal;
+    juce::MemoryOutputStream uncommitted;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TrackLibrary)
+};
@@ -0,0 +1,358 @@
+#include <JuceHeader.h>
+#include "VectorReverb.h"
+#include "SimdOps.h"
+
+namespace
+{
+    // Freeverb tunings at 44.1kHz, as used by juce::Reverb
+    const short combTunings[] = { 1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617 };
+    const short allPassTunings[] = { 556, 441, 341, 225 };
+    constexpr int stereoSpread = 23;
+
+    // about -100dB, well under anything audible
+    constexpr float silenceLevel = 1.0e-5f;
+
+    float getPeak(const float* samples, int numSamples) noexcept
+    {
+        auto range = juce::FloatVectorOperations::findMinAndMax(samples, numSamples);
+        return juce::jmax(-range.getStart(), range.getEnd());
+    }
+
+    // adding and removing 0.1 flushes denormals, exactly like JUCE_UNDENORMALISE
+    inline float undenormalise(float x) noexcept
+    {
+        x += 0.1f;
+        x -= 0.1f;
+        return x;
+    }
+
+    inline SimdOps::Float4 undenormalise(SimdOps::Float4 x, SimdOps::Float4 offset) noexcept
+    {
+        return SimdOps::sub(SimdOps::add(x, offset), offset);
+    }
+}
+
+//==============================================================================
+VectorReverb::VectorReverb()
+{
+    setParameters(Parameters());
+    setSampleRate(44100.0);
+}
+
+const VectorReverb::Parameters& VectorReverb::getParameters() const noexcept
+{
+    return parameters;
+}
+
+void VectorReverb::setParameters(const Parameters& newParams)
+{
+    const float wetScaleFactor = 3.0f;
+    const float dryScaleFactor = 2.0f;
+
+    const float wet = newParams.wetLevel * wetScaleFactor;
+    dryGain.setTargetValue(newParams.dryLevel * dryScaleFactor);
+    wetGain1.setTargetValue(0.5f * wet * (1.0f + newParams.width));
+    wetGain2.setTargetValue(0.5f * wet * (1.0f - newParams.width));
+
+    gain = newParams.freezeMode >= 0.5f ? 0.0f : 0.015f;
+    parameters = newParams;
+    updateDamping();
+}
+
+void VectorReverb::setSampleRate(double sampleRate)
+{
+    jassert(sampleRate > 0);
+    const int intSampleRate = (int) sampleRate;
+
+    int longestDelay = 0;
+    for (int i = 0; i < numCombs; ++i)
+    {
+        combDelays[i] = (intSampleRate * combTunings[i]) / 44100;
+        combDelays[i + numCombs] = (intSampleRate * (combTunings[i] + stereoSpread)) / 44100;
+        longestDelay = juce::jmax(longestDelay, combDelays[i + numCombs]);
+    }
+    ringLength = longestDelay + 1;
+    combRing.assign((size_t) (ringLength * numLanes), 0.0f);
+
+    maxChunk = std::numeric_limits<int>::max();
+    for (int i = 0; i < numAllPasses; ++i)
+    {
+        allPasses[0][i].setSize((intSampleRate * allPassTunings[i]) / 44100);
+        allPasses[1][i].setSize((intSampleRate * (allPassTunings[i] + stereoSpread)) / 44100);
+        maxChunk = juce::jmin(maxChunk, (int) allPasses[0][i].buffer.size());
+    }
+    combOutLeft.assign((size_t) maxChunk, 0.0f);
+    combOutRight.assign((size_t) maxChunk, 0.0f);
+
+    const double smoothTime = 0.01;
+    damping.reset(sampleRate, smoothTime);
+    feedback.reset(sampleRate, smoothTime);
+    dryGain.reset(sampleRate, smoothTime);
+    wetGain1.reset(sampleRate, smoothTime);
+    wetGain2.reset(sampleRate, smoothTime);
+
+    reset();
+}
+
+void VectorReverb::reset()
+{
+    std::fill(combRing.begin(), combRing.end(), 0.0f);
+    std::fill(std::begin(combLast), std::end(combLast), 0.0f);
+    ringPos = 0;
+    tailLevel = 0.0f;
+
+    for (auto& channel : allPasses)
+    {
+        for (auto& allPass : channel)
+        {
+            allPass.clear();
+        }
+    }
+}
+
+void VectorReverb::processStereo(float* left, float* right, int numSamples) noexcept
+{
+    jassert(left != nullptr && right != nullptr);
+    process(left, right, numSamples);
+}
+
+void VectorReverb::processMono(float* samples, int numSamples) noexcept
+{
+    jassert(samples != nullptr);
+    process(samples, nullptr, numSamples);
+}
+
+bool VectorReverb::isActive() const noexcept
+{
+    return active;
+}
+
+void VectorReverb::process(float* left, float* right, int numSamples) noexcept
+{
+    auto inputLevel = getPeak(left, numSamples);
+    if (right != nullptr)
+    {
+        inputLevel = juce::jmax(inputLevel, getPeak(right, numSamples));
+    }
+    auto hasInput = inputLevel > silenceLevel;
+
+    if (!active)
+    {
+        if (!hasInput || !isWetAudible())
+        {
+            processDryOnly(left, right, numSamples);
+            return;
+        }
+        // whatever was left in the delay lines is from before the suspend
+        reset();
+        active = true;
+    }
+
+    tailLevel = 0.0f;
+    for (int done = 0; done < numSamples;)
+    {
+        auto numThisTime = juce::jmin(maxChunk, numSamples - done);
+        processChunk(left + done, right != nullptr ? right + done : nullptr, numThisTime);
+        done += numThisTime;
+    }
+
+    // with the wet level at zero the tail is already muted, otherwise let it ring out first
+    if (!isWetAudible() || (!hasInput && tailLevel < silenceLevel))
+    {
+        active = false;
+    }
+}
+
+void VectorReverb::processDryOnly(float* left, float* right, int numSamples) noexcept
+{
+    damping.skip(numSamples);
+    feedback.skip(numSamples);
+    wetGain1.skip(numSamples);
+    wetGain2.skip(numSamples);
+
+    if (dryGain.isSmoothing())
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float dry = dryGain.getNextValue();
+            left[i] *= dry;
+            if (right != nullptr)
+            {
+                right[i] *= dry;
+            }
+        }
+    }
+    else
+    {
+        juce::FloatVectorOperations::multiply(left, dryGain.getCurrentValue(), numSamples);
+        if (right != nullptr)
+        {
+            juce::FloatVectorOperations::multiply(right, dryGain.getCurrentValue(), numSamples);
+        }
+    }
+}
+
+bool VectorReverb::isWetAudible() const noexcept
+{
+    return wetGain1.getTargetValue() != 0.0f || wetGain2.getTargetValue() != 0.0f
+        || wetGain1.isSmoothing() || wetGain2.isSmoothing();
+}
+
+void VectorReverb::processChunk(float* left, float* right, int numSamples) noexcept
+{
+    using namespace SimdOps;
+    const auto offset = broadcast(0.1f);
+
+    Float4 last[numLanes / 4];
+    for (int group = 0; group < numLanes / 4; ++group)
+    {
+        last[group] = load(combLast + 4 * group);
+    }
+
+    // comb bank, all lanes of both channels at once
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float input = (right != nullptr ? left[i] + right[i] : left[i]) * gain;
+        const float damp = damping.getNextValue();
+        const float feedbackLevel = feedback.getNextValue();
+
+        const auto inputV = broadcast(input);
+        const auto dampV = broadcast(damp);
+        const auto keepV = broadcast(1.0f - damp);
+        const auto feedbackV = broadcast(feedbackLevel);
+
+        auto* frame = combRing.data() + ringPos * numLanes;
+        float written[numLanes];
+        Float4 outputs[numLanes / 4];
+
+        for (int group = 0; group < numLanes / 4; ++group)
+        {
+            outputs[group] = load(frame + 4 * group);
+            last[group] = undenormalise(add(mul(outputs[group], keepV), mul(last[group], dampV)), offset);
+            store(written + 4 * group, undenormalise(add(inputV, mul(last[group], feedbackV)), offset));
+        }
+
+        // each lane lands as far ahead as its delay, so it comes back round to this slot on time
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            auto slot = ringPos + combDelays[lane];
+            slot -= slot >= ringLength ? ringLength : 0;
+            combRing[(size_t) (slot * numLanes + lane)] = written[lane];
+        }
+        ringPos = ringPos + 1 < ringLength ? ringPos + 1 : 0;
+
+        combOutLeft[(size_t) i] = sum(add(outputs[0], outputs[1]));
+        combOutRight[(size_t) i] = sum(add(outputs[2], outputs[3]));
+    }
+
+    for (int group = 0; group < numLanes / 4; ++group)
+    {
+        store(combLast + 4 * group, last[group]);
+    }
+
+    // allpasses in series, each across the whole chunk
+    for (int i = 0; i < numAllPasses; ++i)
+    {
+        allPasses[0][i].process(combOutLeft.data(), numSamples);
+        if (right != nullptr)
+        {
+            allPasses[1][i].process(combOutRight.data(), numSamples);
+        }
+    }
+
+    tailLevel = juce::jmax(tailLevel, getPeak(combOutLeft.data(), numSamples));
+    if (right != nullptr)
+    {
+        tailLevel = juce::jmax(tailLevel, getPeak(combOutRight.data(), numSamples));
+    }
+
+    if (right != nullptr)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float dry = dryGain.getNextValue();
+            const float wet1 = wetGain1.getNextValue();
+            const float wet2 = wetGain2.getNextValue();
+            const float outL = combOutLeft[(size_t) i];
+            const float outR = combOutRight[(size_t) i];
+            left[i] = outL * wet1 + outR * wet2 + left[i] * dry;
+            right[i] = outR * wet1 + outL * wet2 + right[i] * dry;
+        }
+    }
+    else
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            left[i] = combOutLeft[(size_t) i] * wetGain1.getNextValue() + left[i] * dryGain.getNextValue();
+        }
+    }
+}
+
+void VectorReverb::updateDamping() noexcept
+{
+    const float roomScaleFactor = 0.28f;
+    const float roomOffset = 0.7f;
+    const float dampScaleFactor = 0.4f;
+
+    if (parameters.freezeMode >= 0.5f)
+    {
+        damping.setTargetValue(0.0f);
+        feedback.setTargetValue(1.0f);
+    }
+    else
+    {
+        damping.setTargetValue(parameters.damping * dampScaleFactor);
+        feedback.setTargetValue(parameters.roomSize * roomScaleFactor + roomOffset);
+    }
+}
+
+//==============================================================================
+void VectorReverb::AllPass::setSize(int size)
+{
+    if ((int) buffer.size() != size)
+    {
+        buffer.assign((size_t) size, 0.0f);
+        index = 0;
+    }
+    clear();
+}
+
+void VectorReverb::AllPass::clear()
+{
+    std::fill(buffer.begin(), buffer.end(), 0.0f);
+}
+
+void VectorReverb::AllPass::process(float* samples, int numSamples) noexcept
+{
+    using namespace SimdOps;
+    const auto half = broadcast(0.5f);
+    const auto offset = broadcast(0.1f);
+    const int size = (int) buffer.size();
+
+    // within one pass round the buffer every sample touches a different slot, so lanes are independent
+    for (int done = 0; done < numSamples;)
+    {
+        auto numThisTime = juce::jmin(numSamples - done, size - index);
+        auto* delayed = buffer.data() + index;
+        auto* io = samples + done;
+
+        int i = 0;
+        for (; i + 4 <= numThisTime; i += 4)
+        {
+            auto in = load(io + i);
+            auto buffered = load(delayed + i);
+            store(delayed + i, undenormalise(add(in, mul(buffered, half)), offset));
+            store(io + i, sub(buffered, in));
+        }
+        for (; i < numThisTime; ++i)
+        {
+            const float in = io[i];
+            const float buffered = delayed[i];
+            delayed[i] = undenormalise(in + buffered * 0.5f);
+            io[i] = buffered - in;
+        }
+
+        index = index + numThisTime < size ? index + numThisTime : 0;
+        done += numThisTime;
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Drop-in replacement for juce::Reverb (the same Freeverb topology, tunings
+    and parameters) with the inner loops vectorized.
+
+    The 8 comb filters of both channels run as 16 SIMD lanes. Each lane's
+    delay line is stored skewed in one interleaved ring, written ahead by its
+    own delay, so every lane's output for a sample sits in one contiguous
+    frame. The allpasses are processed a chunk at a time across samples, which
+    works because no chunk is longer than the shortest allpass delay.
+
+    While it could only add silence (the wet level is zero, or the input is
+    silent and the tail has died away) the reverb suspends itself and just
+    applies the dry gain. It clears its delay lines when it wakes up.
+*/
+class VectorReverb
+{
+public:
+    using Parameters = juce::Reverb::Parameters;
+
+    VectorReverb();
+
+    const Parameters& getParameters() const noexcept;
+    /**Same scaling and smoothing as juce::Reverb::setParameters*/
+    void setParameters(const Parameters& newParams);
+    /**Allocates the delay lines, call before processing*/
+    void setSampleRate(double sampleRate);
+    /**Clears the delay lines, silencing any tail*/
+    void reset();
+
+    void processStereo(float* left, float* right, int numSamples) noexcept;
+    void processMono(float* samples, int numSamples) noexcept;
+
+    /**False while suspended*/
+    bool isActive() const noexcept;
+
+private:
+    static constexpr int numCombs = 8;
+    static constexpr int numAllPasses = 4;
+    static constexpr int numLanes = 2 * numCombs;
+
+    struct AllPass
+    {
+        std::vector<float> buffer;
+        int index = 0;
+
+        void setSize(int size);
+        void clear();
+        /**numSamples must not exceed the delay*/
+        void process(float* samples, int numSamples) noexcept;
+    };
+
+    void process(float* left, float* right, int numSamples) noexcept;
+    /**right is null for mono*/
+    void processChunk(float* left, float* right, int numSamples) noexcept;
+    /**What the reverb does while suspended: dry gain only, smoothing kept in step*/
+    void processDryOnly(float* left, float* right, int numSamples) noexcept;
+    bool isWetAudible() const noexcept;
+    void updateDamping() noexcept;
+
+    Parameters parameters;
+    float gain = 0.015f;
+
+    // numLanes floats per slot; lane j is read combDelays[j] slots after it is written
+    std::vector<float> combRing;
+    int ringLength = 0;
+    int ringPos = 0;
+    int combDelays[numLanes] = {};
+    float combLast[numLanes] = {};
+
+    AllPass allPasses[2][numAllPasses];
+    std::vector<float> combOutLeft;
+    std::vector<float> combOutRight;
+    int maxChunk = 0;
+
+    juce::SmoothedValue<float> damping, feedback, dryGain, wetGain1, wetGain2;
+
+    bool active = false;
+    // loudest wet sample of the last call, before the wet gain
+    float tailLevel = 0.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VectorReverb)
+};
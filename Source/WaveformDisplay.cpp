@@ -9,6 +9,7 @@ WaveformDisplay::WaveformDisplay(int _id,
                                 ) : audioThumb(1000, formatManager, thumbCache),
                                     fileLoaded(false),
                                     position(0),
+                                    underrunCount(0),
                                     id(_id)
 {
     // In your constructor, you should add any child components, and
@@ -48,6 +49,18 @@ void WaveformDisplay::paint (juce::Graphics& g)
                               );
         g.setColour(juce::Colours::red);
         g.drawRect(position * getWidth(), 0, getWidth() / 20, getHeight());
+        // numbered like the cue buttons
+        g.setColour(juce::Colours::yellow);
+        for (int i = 0; i < hotCues.size(); ++i)
+        {
+            if (hotCues[i] >= 0)
+            {
+                auto x = juce::roundToInt(hotCues[i] * getWidth());
+                g.drawVerticalLine(x, 0.0f, (float) getHeight());
+                g.drawText(juce::String(i + 1), x + 2, getHeight() / 2 - 8, 16, 16,
+                    juce::Justification::centredLeft, false);
+            }
+        }
         g.setColour(juce::Colours::pink);
         g.drawText(fileName, getLocalBounds(),
             juce::Justification::bottomLeft, true);
@@ -59,6 +72,28 @@ void WaveformDisplay::paint (juce::Graphics& g)
         g.drawText("File not loaded...", getLocalBounds(),
             juce::Justification::centred, true);   // draw some placeholder text
     }
+    if (underrunCount > 0)
+    {
+        // the read-ahead buffer ran dry at least once
+        g.setColour(juce::Colours::orange);
+        g.setFont(15.0f);
+        g.drawText("Underruns: " + std::to_string(underrunCount), getLocalBounds(),
+            juce::Justification::bottomRight, true);
+    }
+    if (fileLoaded && loadMode.isNotEmpty())
+    {
+        g.setColour(juce::Colours::deepskyblue);
+        g.setFont(13.0f);
+        g.drawText(loadMode, getLocalBounds().reduced(4, 2),
+            juce::Justification::topLeft, true);
+    }
+    if (activeStages.isNotEmpty())
+    {
+        g.setColour(juce::Colours::limegreen);
+        g.setFont(13.0f);
+        g.drawText(activeStages, getLocalBounds().reduced(4, 2),
+            juce::Justification::topRight, true);
+    }
 }
 
 void WaveformDisplay::resized()
@@ -98,3 +133,39 @@ void WaveformDisplay::setPositionRelative(double pos)
         repaint();
     }
 }
+
+void WaveformDisplay::setUnderrunCount(int count)
+{
+    if (count != underrunCount)
+    {
+        underrunCount = count;
+        repaint();
+    }
+}
+
+void WaveformDisplay::setActiveStages(const juce::String& stages)
+{
+    if (stages != activeStages)
+    {
+        activeStages = stages;
+        repaint();
+    }
+}
+
+void WaveformDisplay::setLoadMode(const juce::String& mode)
+{
+    if (mode != loadMode)
+    {
+        loadMode = mode;
+        repaint();
+    }
+}
+
+void WaveformDisplay::setHotCues(const juce::Array<double>& positions)
+{
+    if (positions != hotCues)
+    {
+        hotCues = positions;
+        repaint();
+    }
+}
@@ -22,11 +22,23 @@ public:
     void loadURL(juce::URL audioURL);
     /**set the relative position of the playhead*/
     void setPositionRelative(double pos);
+    /**show how many times the deck ran out of buffered audio*/
+    void setUnderrunCount(int count);
+    /**show which DSP stages are running, e.g. "DSP: STRETCH REVERB"*/
+    void setActiveStages(const juce::String& stages);
+    /**show where the track plays from, e.g. "IN-MEMORY" or "STREAMING"*/
+    void setLoadMode(const juce::String& mode);
+    /**mark the hot cues, as relative positions with a negative one for each cue not set*/
+    void setHotCues(const juce::Array<double>& positions);
 private:
     int id;
     bool fileLoaded;
     double position;
+    int underrunCount;
     juce::String fileName;
+    juce::String activeStages;
+    juce::String loadMode;
+    juce::Array<double> hotCues;
     juce::AudioThumbnail audioThumb;
 
 